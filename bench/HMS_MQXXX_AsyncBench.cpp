@@ -0,0 +1,97 @@
+/*
+  Blocking readSensor() against co_await readAsync() on one host thread.
+
+  Wall-clock benchmarks sleep for real: a blocking read costs retries * retryInterval, so N
+  sensors take N times that, while the async reads all wait on the same HostLoop and finish
+  together. Overhead benchmarks run on virtual time (no-op delay hook, HostLoop jumping to
+  the next deadline) to expose the CPU cost of the coroutine frames and the deadline list.
+*/
+#include "HMS_MQXXX_Async.h"
+
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <vector>
+
+static uint32_t virtualMillis = 0;
+
+static uint16_t benchADC(uint8_t pin, void *context) {
+  (void)context;
+  return (uint16_t)(1200 + pin);
+}
+
+static void benchDelay(uint32_t ms, void *context) {
+  (void)context;
+  virtualMillis += ms;
+}
+
+static uint32_t benchMillis(void *context) {
+  (void)context;
+  return virtualMillis;
+}
+
+static std::vector<std::unique_ptr<HMS_MQXXX>> makeSensors(size_t count, HMS_MQXXX_Executor *executor) {
+  std::vector<std::unique_ptr<HMS_MQXXX>> sensors;
+  sensors.reserve(count);
+  for(size_t i = 0; i < count; i++) {
+    sensors.emplace_back(new HMS_MQXXX((uint8_t)i, HMS_MQXXX_MQ2));
+    sensors.back()->init();
+    sensors.back()->setR0(10);
+    sensors.back()->setExecutor(executor);
+  }
+  return sensors;
+}
+
+static void runAsyncReads(std::vector<std::unique_ptr<HMS_MQXXX>> &sensors, HMS_MQXXX_HostLoop &loop) {
+  std::vector<HMS_MQXXX_Task<float>> reads;
+  reads.reserve(sensors.size());
+  for(auto &sensor : sensors) {
+    reads.push_back(sensor->readAsync());
+    reads.back().start();
+  }
+  loop.run();
+  for(auto &read : reads) benchmark::DoNotOptimize(read.result());
+}
+
+static void BM_BlockingRead(benchmark::State &state) {
+  HMS_MQXXX_HostHooks hooks = { benchADC, NULL, NULL, NULL };             // Real sleeps
+  HMS_MQXXX_SetHostHooks(&hooks);
+  auto sensors = makeSensors((size_t)state.range(0), NULL);
+  for(auto _ : state) {
+    for(auto &sensor : sensors) benchmark::DoNotOptimize(sensor->readSensor());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BlockingRead)->Arg(1)->Arg(8)->Arg(32)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_AsyncRead(benchmark::State &state) {
+  HMS_MQXXX_HostLoop loop;
+  HMS_MQXXX_HostHooks hooks = { benchADC, NULL, HMS_MQXXX_HostLoop::millisHook, &loop };
+  HMS_MQXXX_SetHostHooks(&hooks);
+  auto sensors = makeSensors((size_t)state.range(0), &loop);
+  for(auto _ : state) runAsyncReads(sensors, loop);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AsyncRead)->Arg(1)->Arg(8)->Arg(32)->Arg(1024)->Arg(4096)->Unit(benchmark::kMillisecond)->UseRealTime();
+
+static void BM_BlockingReadOverhead(benchmark::State &state) {
+  HMS_MQXXX_HostHooks hooks = { benchADC, benchDelay, benchMillis, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+  auto sensors = makeSensors((size_t)state.range(0), NULL);
+  for(auto _ : state) {
+    for(auto &sensor : sensors) benchmark::DoNotOptimize(sensor->readSensor());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_BlockingReadOverhead)->Arg(1)->Arg(64)->Arg(4096);
+
+static void BM_AsyncReadOverhead(benchmark::State &state) {
+  HMS_MQXXX_HostLoop loop(true);
+  HMS_MQXXX_HostHooks hooks = { benchADC, NULL, HMS_MQXXX_HostLoop::millisHook, &loop };
+  HMS_MQXXX_SetHostHooks(&hooks);
+  auto sensors = makeSensors((size_t)state.range(0), &loop);
+  for(auto _ : state) runAsyncReads(sensors, loop);
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_AsyncReadOverhead)->Arg(1)->Arg(64)->Arg(4096);
+
+BENCHMARK_MAIN();
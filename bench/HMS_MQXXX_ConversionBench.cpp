@@ -0,0 +1,146 @@
+/*
+  ns/op of the conversion and acquisition hot paths, for every sensor type and both
+  regression modes, on virtual time (no-op delay hook) so only CPU cost is measured.
+
+  Arguments are {HMS_MQXXX_Type, HMS_MQXXX_Regression}; evaluateGases() follows the curve
+  table of the type and only takes the type. Inputs cycle through a fixed table of ADC codes
+  and ratios so neither the compiler nor the branch predictor sees one constant value.
+
+  Results are compared across driver versions from the JSON report:
+    HMS_MQXXX_ConversionBench --benchmark_out=new.json --benchmark_out_format=json
+    compare.py benchmarks old.json new.json               (tools/ of Google Benchmark)
+  or `cmake --build <dir> --target HMS_MQXXX_BenchReport`.
+*/
+#include "HMS_MQXXX_DRIVER.h"
+
+#include <benchmark/benchmark.h>
+#include <math.h>
+#include <string>
+
+#define BENCH_INPUTS    256                                                 // Power of two, indexed with a mask
+
+static uint32_t virtualMillis = 0;
+static uint16_t adcCodes[BENCH_INPUTS];
+static float    ratios[BENCH_INPUTS];
+static uint32_t adcIndex = 0;
+
+static uint16_t benchADC(uint8_t pin, void *context) {
+  (void)pin;
+  (void)context;
+  return adcCodes[adcIndex++ & (BENCH_INPUTS - 1)];
+}
+
+static void benchDelay(uint32_t ms, void *context) {
+  (void)context;
+  virtualMillis += ms;
+}
+
+static uint32_t benchMillis(void *context) {
+  (void)context;
+  return virtualMillis;
+}
+
+// Codes over most of the ADC range, ratios log-spaced over the span of the datasheet curves
+static void fillInputs() {
+  static bool filled = false;
+  if(filled) return;
+  for(uint32_t i = 0; i < BENCH_INPUTS; i++) {
+    uint32_t scrambled = (i * 97) & (BENCH_INPUTS - 1);
+    adcCodes[i] = (uint16_t)(200 + scrambled * 14);
+    ratios[i]   = powf(10.0f, -1.0f + 2.5f * (float)scrambled / BENCH_INPUTS);
+  }
+  filled = true;
+}
+
+static void setupSensor(HMS_MQXXX &sensor, benchmark::State &state) {
+  static HMS_MQXXX_HostHooks hooks = { benchADC, benchDelay, benchMillis, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+  fillInputs();
+  sensor.init();
+  sensor.setR0(10);
+  if(state.range(1) == 0) return;
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  static HMS_MQXXX_Profile profile;                                         // One sensor at a time, outlives it
+  profile            = *HMS_MQXXX_GetProfile(sensor.getType());
+  profile.regression = (uint8_t)state.range(1);
+  sensor.setProfile(&profile);
+  #else
+  sensor.setRegressionMethod((HMS_MQXXX_Regression)state.range(1));
+  #endif
+}
+
+static void typeLabel(benchmark::State &state) {
+  static const char *const names[] = { "MQ2", "MQ131", "MQ135", "MQ303A" };
+  static const char *const modes[] = { "", "exponential", "linear" };
+  state.SetLabel(std::string(names[state.range(0)]) + (state.range(1) != 0 ? std::string("/") + modes[state.range(1)] : ""));
+}
+
+static void typesAndModes(benchmark::internal::Benchmark *bench) {
+  for(int type = HMS_MQXXX_MQ2; type <= HMS_MQXXX_MQ303A; type++) {
+    bench->Args({ type, HMS_MQXXX_EXPONENTIAL });
+    bench->Args({ type, HMS_MQXXX_LINEAR });
+  }
+}
+
+static void typesOnly(benchmark::internal::Benchmark *bench) {
+  for(int type = HMS_MQXXX_MQ2; type <= HMS_MQXXX_MQ303A; type++) bench->Args({ type, 0 });
+}
+
+static void BM_ReadSensor(benchmark::State &state) {
+  HMS_MQXXX sensor(0, (HMS_MQXXX_Type)state.range(0));
+  setupSensor(sensor, state);
+  for(auto _ : state) benchmark::DoNotOptimize(sensor.readSensor());
+  state.SetItemsProcessed(state.iterations());
+  typeLabel(state);
+}
+BENCHMARK(BM_ReadSensor)->Apply(typesAndModes);
+
+static void BM_SetRatioAndGetPPM(benchmark::State &state) {
+  HMS_MQXXX sensor(0, (HMS_MQXXX_Type)state.range(0));
+  setupSensor(sensor, state);
+  uint32_t i = 0;
+  for(auto _ : state) benchmark::DoNotOptimize(sensor.setRatioAndGetPPM(ratios[i++ & (BENCH_INPUTS - 1)]));
+  state.SetItemsProcessed(state.iterations());
+  typeLabel(state);
+}
+BENCHMARK(BM_SetRatioAndGetPPM)->Apply(typesAndModes);
+
+static void BM_ProcessVoltage(benchmark::State &state) {
+  HMS_MQXXX sensor(0, (HMS_MQXXX_Type)state.range(0));
+  setupSensor(sensor, state);
+  uint32_t i = 0;
+  for(auto _ : state) {
+    float voltage = (float)adcCodes[i++ & (BENCH_INPUTS - 1)] * (5.0f / 4095.0f);
+    benchmark::DoNotOptimize(sensor.processVoltage(voltage));
+  }
+  state.SetItemsProcessed(state.iterations());
+  typeLabel(state);
+}
+BENCHMARK(BM_ProcessVoltage)->Apply(typesAndModes);
+
+static void BM_Calibrate(benchmark::State &state) {
+  HMS_MQXXX sensor(0, (HMS_MQXXX_Type)state.range(0));
+  setupSensor(sensor, state);
+  for(auto _ : state) benchmark::DoNotOptimize(sensor.calibrate(9.83f));
+  state.SetItemsProcessed(state.iterations());
+  typeLabel(state);
+}
+BENCHMARK(BM_Calibrate)->Apply(typesAndModes);
+
+static void BM_EvaluateGases(benchmark::State &state) {
+  HMS_MQXXX sensor(0, (HMS_MQXXX_Type)state.range(0));
+  setupSensor(sensor, state);
+  float    ppm[HMS_MQXXX_MAX_GASES];
+  uint8_t  count = 0;
+  uint32_t i = 0;
+  for(auto _ : state) {
+    count = sensor.evaluateGases(ratios[i++ & (BENCH_INPUTS - 1)], ppm, HMS_MQXXX_MAX_GASES);
+    benchmark::DoNotOptimize(ppm);
+  }
+  state.SetItemsProcessed(state.iterations() * count);                      // Items are gas conversions
+  state.counters["gases"] = count;
+  typeLabel(state);
+}
+BENCHMARK(BM_EvaluateGases)->Apply(typesOnly);
+
+BENCHMARK_MAIN();
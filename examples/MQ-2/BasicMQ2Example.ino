@@ -32,11 +32,20 @@ void setup() {
     return;
   }
   
+  #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
   Serial.println("Warming up sensor...");
-  Serial.println("Please wait 20 seconds for sensor stabilization");
+  Serial.println("Waiting until the sensor resistance settles");
   
   // Warm-up period (important for accurate readings)
-  delay(20000);
+  // Ready as soon as Rs stops drifting, at the latest after the datasheet preheat time
+  while(!mq2.isReady()) {
+    mq2.update();
+    Serial.print("Warm-up ETA: ");
+    Serial.print(mq2.getWarmupETA());
+    Serial.println(" s");
+    delay(1000);
+  }
+  #endif
   
   Serial.println("Sensor ready!");
   Serial.println("Gas concentrations will be displayed every 2 seconds");
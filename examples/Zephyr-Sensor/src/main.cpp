@@ -0,0 +1,77 @@
+/*
+ * Zephyr Sensor API Example
+ *
+ * Reads an MQ-2 described in devicetree ("hms,mqxxx") twice per second:
+ *   - blocking sensor_sample_fetch() / sensor_channel_get()
+ *   - RTIO sensor_read() into a buffer, decoded afterwards with the driver's decoder
+ *
+ * On native_sim the sensor output is an emulated ADC input swept between 0.5 V and 3.5 V.
+ */
+
+#include <zephyr/kernel.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/drivers/adc/adc_emul.h>
+#include <zephyr/dsp/print_format.h>
+#include <zephyr/rtio/rtio.h>
+#include <stdio.h>
+
+#include "HMS_MQXXX_Zephyr.h"
+
+static const struct device *const mq2 = DEVICE_DT_GET(DT_NODELABEL(mq2));
+
+SENSOR_DT_READ_IODEV(mq2Iodev, DT_NODELABEL(mq2),
+                     {SENSOR_CHAN_VOLTAGE, 0},
+                     {(enum sensor_channel)HMS_MQXXX_SENSOR_CHAN_RATIO, 0},
+                     {HMS_MQXXX_SENSOR_CHAN_GAS(HMS_MQXXX_GAS_LPG), 0});
+RTIO_DEFINE(mq2Ctx, 1, 1);
+
+static void printBlocking() {
+  struct sensor_value voltage, ratio, lpg, co;
+  if(sensor_sample_fetch(mq2) != 0) {
+    printf("fetch failed\n");
+    return;
+  }
+  sensor_channel_get(mq2, SENSOR_CHAN_VOLTAGE, &voltage);
+  sensor_channel_get(mq2, (enum sensor_channel)HMS_MQXXX_SENSOR_CHAN_RATIO, &ratio);
+  sensor_channel_get(mq2, HMS_MQXXX_SENSOR_CHAN_GAS(HMS_MQXXX_GAS_LPG), &lpg);
+  sensor_channel_get(mq2, HMS_MQXXX_SENSOR_CHAN_GAS(HMS_MQXXX_GAS_CO), &co);
+  printf("fetch: %.3f V  ratio %.3f  LPG %.1f ppm  CO %.1f ppm\n",
+         sensor_value_to_double(&voltage), sensor_value_to_double(&ratio),
+         sensor_value_to_double(&lpg), sensor_value_to_double(&co));
+}
+
+static void printStreamed() {
+  uint8_t buf[64];
+  if(sensor_read(&mq2Iodev, &mq2Ctx, buf, sizeof(buf)) != 0) {
+    printf("rtio read failed\n");
+    return;
+  }
+
+  const struct sensor_decoder_api *decoder;
+  sensor_get_decoder(mq2, &decoder);
+
+  struct sensor_q31_data lpg = {};
+  uint32_t fit = 0;
+  decoder->decode(buf, {HMS_MQXXX_SENSOR_CHAN_GAS(HMS_MQXXX_GAS_LPG), 0}, &fit, 1, &lpg);
+  printf("rtio:  LPG %" PRIq(6) " ppm\n", PRIq_arg(lpg.readings[0].value, 6, lpg.shift));
+}
+
+int main(void) {
+  if(!device_is_ready(mq2)) {
+    printf("MQ-2 not ready\n");
+    return 0;
+  }
+
+  const struct device *adc = DEVICE_DT_GET(DT_NODELABEL(adc0));
+  uint32_t mv = 500;
+  while(true) {
+    adc_emul_const_value_set(adc, 0, mv);
+    mv = (mv >= 3500) ? 500 : mv + 250;
+
+    printBlocking();
+    printStreamed();
+    k_msleep(500);
+  }
+  return 0;
+}
@@ -0,0 +1,116 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Arbiter.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Queued, coalescing access to one ADC shared by several MQXXX sensors
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_ARBITER_H
+#define HMS_MQXXX_ARBITER_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+/*
+  Serialises one ADC peripheral between sensors and tasks without a blocking mutex (flat
+  combining). A caller posts its channel into a free request slot; if nobody is converting it
+  becomes the combiner and runs every pending request, otherwise it waits for its slot to be
+  served. The combiner takes a snapshot of the pending slots, converts each distinct channel
+  once and hands that code to every request for the channel, so N tasks reading the same sensor
+  cost one conversion, and the peripheral is only ever touched by one caller at a time.
+
+  The conversion itself is a callback; STM32 HAL builds get a built-in one (channel select,
+  start, poll, stop) from the ADC_HandleTypeDef constructor.
+*/
+typedef HMS_MQXXX_StatusTypeDef (*HMS_MQXXX_ADCConvert)(uint32_t channel, uint16_t *code, void *context);
+
+class HMS_MQXXX_Arbiter {
+  public:
+    HMS_MQXXX_Arbiter(HMS_MQXXX_ADCConvert convert, void *context = NULL);
+    #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+      HMS_MQXXX_Arbiter(ADC_HandleTypeDef *hadc);
+    #endif
+    HMS_MQXXX_Arbiter(const HMS_MQXXX_Arbiter &) = delete;
+    HMS_MQXXX_Arbiter &operator=(const HMS_MQXXX_Arbiter &) = delete;
+
+    HMS_MQXXX_StatusTypeDef convert(uint32_t channel, uint16_t *code);
+
+    uint32_t getRequestCount() const                        { return requests;            }
+    uint32_t getConversionCount() const                     { return conversions;         }
+    uint32_t getCoalescedCount() const                      { return coalesced;           }
+
+  private:
+    typedef enum {
+      SLOT_FREE       = 0,
+      SLOT_PENDING    = 1,                                                  // Posted, not yet picked up
+      SLOT_SERVICING  = 2,                                                  // In the combiner's current batch
+      SLOT_DONE       = 3                                                   // code/status valid
+    } SlotState;
+
+    typedef struct {
+      volatile uint8_t  state;
+      uint8_t           status;
+      uint16_t          code;
+      uint32_t          channel;
+    } Slot;
+
+    #if defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+      typedef k_spinlock_key_t  Key;
+    #else
+      typedef uint32_t          Key;
+    #endif
+
+    Slot                        slots[HMS_MQXXX_ARBITER_SLOTS];
+    volatile bool               busy                = false;                // A combiner is running
+    HMS_MQXXX_ADCConvert        convertFn;
+    void                        *convertContext;
+    uint32_t                    requests            = 0;
+    uint32_t                    conversions         = 0;
+    uint32_t                    coalesced           = 0;                    // Requests served by another request's conversion
+
+    #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+      ADC_HandleTypeDef         *hadc               = NULL;
+      uint32_t                  selectedChannel     = HMS_MQXXX_STM32_NO_CHANNEL;   // Skip reconfiguring an unchanged channel
+      static HMS_MQXXX_StatusTypeDef stm32Convert(uint32_t channel, uint16_t *code, void *context);
+    #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+      portMUX_TYPE              mux                 = portMUX_INITIALIZER_UNLOCKED;
+    #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+      struct k_spinlock         spin                = {};
+    #elif defined(HMS_MQXXX_PLATFORM_HOST)
+      volatile bool             spin                = false;
+    #endif
+
+    Key enter();                                                            // Short critical section around slot state
+    void leave(Key key);
+    void combine();
+};
+
+#endif // HMS_MQXXX_ARBITER_H
@@ -0,0 +1,197 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Array.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Structure-of-arrays manager for batched MQXXX conversion
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+
+#ifndef HMS_MQXXX_ARRAY_H
+#define HMS_MQXXX_ARRAY_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+/*
+  Fixed-capacity container for gateways running many MQ sensors. Every per-sensor quantity lives
+  in its own contiguous, 16-byte aligned array, and convert() runs each pipeline stage as a flat
+  loop over all sensors:
+
+    stage 1  code -> voltage -> Rs -> ratio       (mul/div/select only, vectorises)
+    stage 2  ratio -> log10(ppm) -> ppm           (logf/expf, vectorised by libmvec with -ffast-math)
+
+  Both regression forms are reduced at add() time to log10(ppm) = k0 + k1 * log10(ratio):
+    HMS_MQXXX_EXPONENTIAL  k0 = log10(a),  k1 = b
+    HMS_MQXXX_LINEAR       k0 = -b / a,    k1 = 1 / a
+  so stage 2 has no branch on the sensor type. The ratio gets the same environment compensation
+  (folded into R0), correction offset, 0.001 floor and curve guards as readSensor(); an
+  exponential curve with a < 0 gives FLT_MAX, a == 0 gives 0. The math is single precision; the
+  HMS_MQXXX double-precision path stays the reference. Raw codes are filled by the application
+  (typically straight from an ADC scan/DMA buffer) with setRawCodes() or rawCodes().
+*/
+template <size_t N>
+class HMS_MQXXX_Array {
+  public:
+    // Copies the calibration (and compensation factor) of an initialised driver instance, with the
+    // correctionFactor readSensor() would be given. Returns the index or -1 when full.
+    int add(const HMS_MQXXX &sensor, float correctionFactor = 0.0f) {
+      int i = add(sensor.getType(), sensor.getR0(), sensor.getRL(), sensor.getVCC(), sensor.getA(), sensor.getB(),
+                  sensor.getRegressionMethod(), sensor.getADCScale(), sensor.getADCOffset());
+      if(i >= 0) {
+        setCorrection((size_t)i, correctionFactor);
+        #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+        setCompensation((size_t)i, sensor.getCompensationFactor());
+        #endif
+      }
+      return i;
+    }
+
+    int add(HMS_MQXXX_Type type, float r0, float rl, float vcc, float a, float b,
+            HMS_MQXXX_Regression regression, float voltsPerCode, float voltsOffset = 0.0f) {
+      if(count >= N) return -1;
+      size_t i = count++;
+      rawCode[i]      = 0;
+      compensation[i] = 1.0f;
+      correction[i]   = 0.0f;
+      configure(i, type, r0, rl, vcc, a, b, regression, voltsPerCode, voltsOffset);
+      return (int)i;
+    }
+
+    void configure(size_t i, HMS_MQXXX_Type type, float r0, float rl, float vcc, float a, float b,
+                   HMS_MQXXX_Regression regression, float voltsPerCode, float voltsOffset = 0.0f) {
+      if(i >= count) return;
+      sensorType[i] = (uint8_t)type;
+      inverted[i]   = (type == HMS_MQXXX_MQ131) ? 1 : 0;
+      r0Value[i]    = r0;
+      rlValue[i]    = rl;
+      vccRl[i]      = ((type == HMS_MQXXX_MQ303A) ? vcc - 0.45f : vcc) * rl;   // Same MQ-303A supply drop as readSensor()
+      scale[i]      = voltsPerCode;
+      offset[i]     = voltsOffset;
+      curve[i]      = (a != 0) ? CURVE_VALID : CURVE_ZERO;
+      if(regression == HMS_MQXXX_EXPONENTIAL) {
+        k0[i] = (a > 0) ? log10f(a) : 0.0f;
+        k1[i] = b;
+        if(a < 0) curve[i] = CURVE_UNDEFINED;                                 // log10(a) is NaN on the scalar path
+      } else {
+        k0[i] = (a != 0) ? -b / a : 0.0f;
+        k1[i] = (a != 0) ? 1.0f / a : 0.0f;
+      }
+    }
+
+    void setR0(size_t i, float value)                       { if(i < count) r0Value[i] = value; }
+    void setCompensation(size_t i, float factor)            { if(i < count) compensation[i] = factor; }   // getCompensationFactor()
+    void setCorrection(size_t i, float value)               { if(i < count) correction[i] = value; }      // Added to the ratio
+    void setRawCode(size_t i, uint16_t code)                { if(i < count) rawCode[i] = code;  }
+    void setRawCodes(const uint16_t *codes, size_t n) {
+      if(n > count) n = count;
+      for(size_t i = 0; i < n; i++) rawCode[i] = codes[i];
+    }
+
+    void convert() {
+      const size_t n = count;
+
+      for(size_t i = 0; i < n; i++) {
+        float v   = (float)rawCode[i] * scale[i] + offset[i];
+        float rs  = vccRl[i] / v - rlValue[i];
+        rs        = (rs < 0.0f) ? 0.0f : rs;
+        float r0  = r0Value[i] * compensation[i];                             // Rs/(R0*f) or R0*f/Rs, as readSensor()
+        float num = inverted[i] ? r0 : rs;                                    // Select operands, not results,
+        float den = inverted[i] ? rs : r0;                                    // so the loop stays branch free
+        float r   = num / den + correction[i];
+        voltage[i] = v;
+        rsValue[i] = rs;
+        ratio[i]   = (r <= 0.0f) ? 0.001f : r;                                // readSensor() floor
+      }
+
+      const float ln10    = 2.30258509f;
+      const float invLn10 = 0.434294482f;
+      for(size_t i = 0; i < n; i++) {
+        logPPM[i] = k0[i] + k1[i] * (logf(ratio[i]) * invLn10);
+      }
+
+      const float maxLog = 38.5318394f;                                       // log10(FLT_MAX)
+      const float minLog = -37.9297794f;                                      // log10(FLT_MIN)
+      for(size_t i = 0; i < n; i++) {
+        float lp     = logPPM[i];
+        bool  high   = !(lp <= maxLog);                                       // Also catches NaN, like readSensor()
+        bool  low    = lp < minLog;
+        float value  = expf(lp * ln10);
+        value        = high ? FLT_MAX : value;
+        value        = low  ? 0.0f    : value;
+        bool  valid  = curve[i] == CURVE_VALID;
+        value        = valid ? value : ((curve[i] == CURVE_UNDEFINED) ? FLT_MAX : 0.0f);
+        ppm[i]       = value;
+        flags[i]     = (valid && (high || low)) ? (uint8_t)HMS_MQXXX_FLAG_SATURATED : (uint8_t)HMS_MQXXX_FLAG_NONE;
+      }
+    }
+
+    size_t size() const                                     { return count;               }
+    static constexpr size_t capacity()                      { return N;                   }
+    void clear()                                            { count = 0;                  }
+
+    uint16_t *rawCodes()                                    { return rawCode;             }
+    const float *voltages() const                           { return voltage;             }
+    const float *rs() const                                 { return rsValue;             }
+    const float *ratios() const                             { return ratio;               }
+    const float *ppms() const                               { return ppm;                 }
+    const uint8_t *readingFlags() const                     { return flags;               }
+    HMS_MQXXX_Type getType(size_t i) const                  { return (HMS_MQXXX_Type)sensorType[i]; }
+
+  private:
+    enum : uint8_t {
+      CURVE_ZERO                = 0,                                        // a == 0, ppm 0
+      CURVE_VALID               = 1,
+      CURVE_UNDEFINED           = 2                                         // Exponential with a < 0, ppm FLT_MAX
+    };
+
+    size_t                      count               = 0;
+    alignas(16) uint16_t        rawCode[N];                                 // Averaged ADC codes, input
+    alignas(16) float           scale[N];                                   // Volts per code incl. ADC gain
+    alignas(16) float           offset[N];                                  // Volts at code 0
+    alignas(16) float           vccRl[N];                                   // Effective VCC * RL
+    alignas(16) float           rlValue[N];                                 // Load resistance
+    alignas(16) float           r0Value[N];                                 // Clean air resistance
+    alignas(16) float           compensation[N];                            // Environment factor on R0, 1 = baseline
+    alignas(16) float           correction[N];                              // correctionFactor added to the ratio
+    alignas(16) float           k0[N];                                      // log10(ppm) intercept
+    alignas(16) float           k1[N];                                      // log10(ppm) slope over log10(ratio)
+    alignas(16) float           voltage[N];                                 // Outputs
+    alignas(16) float           rsValue[N];
+    alignas(16) float           ratio[N];
+    alignas(16) float           ppm[N];
+    alignas(16) float           logPPM[N];                                  // Stage 2 scratch
+    alignas(16) uint8_t         inverted[N];                                // 1 for MQ-131 (R0/Rs)
+    alignas(16) uint8_t         curve[N];                                   // CURVE_*, how stage 2 output is used
+    alignas(16) uint8_t         flags[N];                                   // HMS_MQXXX_ReadingFlags
+    uint8_t                     sensorType[N];
+};
+
+#endif // HMS_MQXXX_ARRAY_H
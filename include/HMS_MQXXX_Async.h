@@ -0,0 +1,305 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Async.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Coroutine Read API and Executors for the HMS MQXXX Driver
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_ASYNC_H
+#define HMS_MQXXX_ASYNC_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+
+#include <coroutine>
+#include <exception>
+
+#if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #include "freertos/timers.h"
+  #define HMS_MQXXX_TIMER_EXECUTOR_AVAILABLE
+#elif defined(HMS_MQXXX_SERVICE_FREERTOS) && (HMS_MQXXX_SERVICE_FREERTOS == 1)
+  #include "FreeRTOS.h"
+  #include "task.h"
+  #include "timers.h"
+  #define HMS_MQXXX_TIMER_EXECUTOR_AVAILABLE
+#endif
+
+#if defined(HMS_MQXXX_TIMER_EXECUTOR_AVAILABLE) && defined(HMS_MQXXX_NO_HEAP) && (HMS_MQXXX_NO_HEAP == 1)
+  #if !defined(configSUPPORT_STATIC_ALLOCATION) || (configSUPPORT_STATIC_ALLOCATION != 1)
+    #error "HMS_MQXXX_NO_HEAP needs configSUPPORT_STATIC_ALLOCATION = 1 (or build with HMS_MQXXX_NO_HEAP = 0)"
+  #endif
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <chrono>
+#endif
+
+#if defined(HMS_MQXXX_NO_HEAP) && (HMS_MQXXX_NO_HEAP == 1)
+  #define HMS_MQXXX_ASYNC_POOLED
+
+/*
+  Coroutine frames come from a static pool of HMS_MQXXX_ASYNC_FRAMES slots instead of the heap.
+  A frame larger than HMS_MQXXX_ASYNC_FRAME_SIZE, or no free slot, yields an invalid task and
+  counts a failure; readAsync()/calibrateAsync() then fall back to a blocking acquisition.
+*/
+void *HMS_MQXXX_AsyncFrameAlloc(size_t size);
+void HMS_MQXXX_AsyncFrameFree(void *frame);
+uint32_t HMS_MQXXX_AsyncFrameFailures();
+#endif
+
+/*
+  Lazy coroutine result. Nothing runs until the task is awaited from another coroutine or
+  start()ed from plain code; completion resumes the awaiting coroutine directly (symmetric
+  transfer), so chains of awaits never grow the stack. The frame is freed with the task. A
+  task whose frame could not be allocated is !valid(), done() and yields T().
+*/
+template<typename T>
+class HMS_MQXXX_Task {
+  public:
+    struct promise_type {
+      T                         value               = T();
+      bool                      started             = false;
+      std::coroutine_handle<>   continuation;
+
+      HMS_MQXXX_Task get_return_object()                    { return HMS_MQXXX_Task(std::coroutine_handle<promise_type>::from_promise(*this)); }
+      std::suspend_always initial_suspend() noexcept        { return {};                  }
+      void return_value(T result)                           { value = result;             }
+      void unhandled_exception()                            { std::terminate();           }
+
+      struct FinalAwaiter {
+        bool await_ready() noexcept                         { return false;               }
+        std::coroutine_handle<> await_suspend(std::coroutine_handle<promise_type> self) noexcept {
+          std::coroutine_handle<> next = self.promise().continuation;
+          return next ? next : std::noop_coroutine();
+        }
+        void await_resume() noexcept                        {                             }
+      };
+      FinalAwaiter final_suspend() noexcept                 { return {};                  }
+
+      #if defined(HMS_MQXXX_ASYNC_POOLED)
+        static void *operator new(size_t size) noexcept     { return HMS_MQXXX_AsyncFrameAlloc(size); }
+        static void operator delete(void *frame) noexcept   { HMS_MQXXX_AsyncFrameFree(frame); }
+        static HMS_MQXXX_Task get_return_object_on_allocation_failure() { return HMS_MQXXX_Task(nullptr); }
+      #endif
+    };
+
+    HMS_MQXXX_Task(HMS_MQXXX_Task &&other) noexcept : handle(other.handle) { other.handle = nullptr; }
+    HMS_MQXXX_Task &operator=(HMS_MQXXX_Task &&other) noexcept {
+      if(this != &other) {
+        if(handle) handle.destroy();
+        handle = other.handle;
+        other.handle = nullptr;
+      }
+      return *this;
+    }
+    HMS_MQXXX_Task(const HMS_MQXXX_Task &) = delete;
+    HMS_MQXXX_Task &operator=(const HMS_MQXXX_Task &) = delete;
+    ~HMS_MQXXX_Task()                                       { if(handle) handle.destroy(); }
+
+    // Run until the first suspension point; the executor takes it from there
+    void start() {
+      if(handle && !handle.promise().started) {
+        handle.promise().started = true;
+        handle.resume();
+      }
+    }
+    bool valid() const                                      { return static_cast<bool>(handle); }
+    bool done() const                                       { return !handle || handle.done(); }
+    T result() const                                        { return handle ? handle.promise().value : T(); }
+
+    bool await_ready() const noexcept                       { return !handle || handle.done(); }
+    std::coroutine_handle<> await_suspend(std::coroutine_handle<> awaiting) noexcept {
+      handle.promise().continuation = awaiting;
+      if(handle.promise().started) return std::noop_coroutine();         // Already in flight, just wait for it
+      handle.promise().started = true;
+      return handle;
+    }
+    T await_resume() const                                  { return result();            }
+
+  private:
+    explicit HMS_MQXXX_Task(std::coroutine_handle<promise_type> h) : handle(h) {}
+    std::coroutine_handle<promise_type> handle;
+};
+
+/*
+  One suspended coroutine waiting for a deadline. Lives inside the awaiting coroutine's frame
+  (see HMS_MQXXX_Sleep), so scheduling never allocates.
+*/
+struct HMS_MQXXX_AsyncNode {
+  std::coroutine_handle<>       handle;
+  uint32_t                      due;                                        // now() at which to resume (ms)
+  HMS_MQXXX_AsyncNode           *next;
+};
+
+/*
+  Deadline list shared by every executor. post() files a node in due order (appending is O(1),
+  which is the common case since reads of one type share the same retry interval), runDue()
+  resumes everything that is due. A backend only provides the clock and a way to be woken up
+  when the earliest deadline moves (rearm()), plus a lock when nodes are posted from more than
+  one context.
+*/
+class HMS_MQXXX_Executor {
+  public:
+    virtual ~HMS_MQXXX_Executor()                           {                             }
+
+    void post(HMS_MQXXX_AsyncNode *node, uint32_t delay);
+    uint32_t runDue();                                                      // Returns the number of coroutines resumed
+    bool nextDelay(uint32_t *delay);                                        // ms until the earliest deadline, false when idle
+    bool idle() const                                       { return head == NULL;        }
+    uint32_t getPendingCount() const                        { return pending;             }
+
+    virtual uint32_t now() = 0;
+
+  protected:
+    virtual void rearm(uint32_t delay)                      { (void)delay;                }
+    virtual void lock()                                     {                             }
+    virtual void unlock()                                   {                             }
+
+  private:
+    HMS_MQXXX_AsyncNode         *head               = NULL;
+    HMS_MQXXX_AsyncNode         *tail               = NULL;
+    uint32_t                    pending             = 0;
+};
+
+// co_await HMS_MQXXX_Sleep(executor, ms); a zero delay does not suspend
+class HMS_MQXXX_Sleep {
+  public:
+    HMS_MQXXX_Sleep(HMS_MQXXX_Executor *executor, uint32_t ms) : exec(executor), delay(ms) {}
+
+    bool await_ready() const noexcept                       { return delay == 0;          }
+    void await_suspend(std::coroutine_handle<> awaiting)    { node.handle = awaiting; exec->post(&node, delay); }
+    void await_resume() const noexcept                      {                             }
+
+  private:
+    HMS_MQXXX_Executor          *exec;
+    uint32_t                    delay;
+    HMS_MQXXX_AsyncNode         node                = {};
+};
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+/*
+  Single-threaded event loop for simulators, replay tools and benchmarks. With virtualTime the
+  clock jumps straight to the next deadline instead of sleeping; point HMS_MQXXX_HostHooks.millis
+  at millisHook() so the driver's timestamps and cache ages follow the same clock.
+*/
+class HMS_MQXXX_HostLoop : public HMS_MQXXX_Executor {
+  public:
+    explicit HMS_MQXXX_HostLoop(bool virtualTime = false);
+
+    bool runOnce();                                                         // Wait for and run one deadline, false when idle
+    void run()                                              { while(runOnce()) {}         }
+    void advance(uint32_t ms)                               { clock += ms;                }
+    uint32_t now() override;
+
+    static uint32_t millisHook(void *context)               { return static_cast<HMS_MQXXX_HostLoop *>(context)->now(); }
+
+  private:
+    bool                        virtualClock;
+    uint32_t                    clock               = 0;                    // Virtual time (ms)
+    std::chrono::steady_clock::time_point epoch;
+};
+#endif
+
+#if defined(HMS_MQXXX_TIMER_EXECUTOR_AVAILABLE)
+/*
+  FreeRTOS backend: one one-shot software timer always armed for the earliest deadline, so the
+  coroutines resume on the timer service task. Keep configTIMER_TASK_STACK_DEPTH large enough
+  for one conversion; the retry delays themselves cost no stack.
+*/
+class HMS_MQXXX_TimerExecutor : public HMS_MQXXX_Executor {
+  public:
+    HMS_MQXXX_TimerExecutor()                               {                             }
+    ~HMS_MQXXX_TimerExecutor();
+    HMS_MQXXX_TimerExecutor(const HMS_MQXXX_TimerExecutor &) = delete;
+    HMS_MQXXX_TimerExecutor &operator=(const HMS_MQXXX_TimerExecutor &) = delete;
+
+    HMS_MQXXX_StatusTypeDef begin();
+    uint32_t now() override                                 { return (uint32_t)(xTaskGetTickCount() * portTICK_PERIOD_MS); }
+
+  protected:
+    void rearm(uint32_t delay) override;
+    void lock() override;
+    void unlock() override;
+
+  private:
+    TimerHandle_t               timer               = NULL;
+    #if defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+      StaticTimer_t             timerControl;
+    #endif
+    #if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+      portMUX_TYPE              mux                 = portMUX_INITIALIZER_UNLOCKED;
+    #endif
+
+    static void expired(TimerHandle_t timer);
+};
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+/*
+  Zephyr backend: one delayable work item rescheduled to the earliest deadline, on the system
+  work queue or a dedicated one, so coroutines resume in that queue's thread.
+*/
+class HMS_MQXXX_WorkExecutor : public HMS_MQXXX_Executor {
+  public:
+    explicit HMS_MQXXX_WorkExecutor(struct k_work_q *queue = NULL);
+    ~HMS_MQXXX_WorkExecutor();
+    HMS_MQXXX_WorkExecutor(const HMS_MQXXX_WorkExecutor &) = delete;
+    HMS_MQXXX_WorkExecutor &operator=(const HMS_MQXXX_WorkExecutor &) = delete;
+
+    uint32_t now() override                                 { return k_uptime_get_32();   }
+
+  protected:
+    void rearm(uint32_t delay) override;
+    void lock() override                                    { key = k_spin_lock(&spin);   }
+    void unlock() override                                  { k_spin_unlock(&spin, key);  }
+
+  private:
+    struct Item {                                                           // Standard layout, so CONTAINER_OF is valid
+      struct k_work_delayable   work;
+      HMS_MQXXX_WorkExecutor    *owner;
+    };
+
+    Item                        item;
+    struct k_work_q             *workQueue;
+    struct k_spinlock           spin                = {};
+    k_spinlock_key_t            key                 = {};
+
+    static void handler(struct k_work *work);
+};
+#endif
+
+#endif // HMS_MQXXX_ASYNC_AVAILABLE
+
+#endif // HMS_MQXXX_ASYNC_H
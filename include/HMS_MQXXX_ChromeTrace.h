@@ -0,0 +1,117 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_ChromeTrace.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Chrome trace-event export of MQXXX driver stage spans
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_CHROMETRACE_H
+#define HMS_MQXXX_CHROMETRACE_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#if defined(HMS_MQXXX_SPANS_ENABLED)
+
+#include <memory>
+#include <mutex>
+#include <vector>
+
+#include <stdio.h>
+
+/*
+  Writes the stage spans of the attached sensors as Chrome trace-event JSON, one thread track
+  per sensor, for chrome://tracing or ui.perfetto.dev:
+    X  readSensor, acquire, mqDelay, average, rs, ratio, curve      (HMS_MQXXX_Stage)
+    C  "<name> ppm"                                                 every published reading
+    b/e "sample-to-alarm", cat alarm                                first acquire of the sample
+                                                                    to the reading that alarms
+    i  "alarm" / "alarm-clear"                                      threshold crossings
+  Timestamps come from the clock given to open() in ns, normally the simulation's virtual
+  clock so mqDelay() spans show the simulated interval; without one, steady time since
+  open(). Only one trace can be open at a time: it owns HMS_MQXXX_SetHostSpans().
+*/
+class HMS_MQXXX_ChromeTrace {
+  public:
+    typedef uint64_t (*Clock)(void *context);
+
+    HMS_MQXXX_ChromeTrace() = default;
+    ~HMS_MQXXX_ChromeTrace();                                               // close()
+    HMS_MQXXX_ChromeTrace(const HMS_MQXXX_ChromeTrace &) = delete;
+    HMS_MQXXX_ChromeTrace &operator=(const HMS_MQXXX_ChromeTrace &) = delete;
+
+    HMS_MQXXX_StatusTypeDef open(const char *path, Clock clock = NULL, void *context = NULL);
+    void close();                                                           // Terminates the JSON, detaches every sensor
+    bool isOpen() const                                     { return file != NULL;        }
+
+    HMS_MQXXX_StatusTypeDef attach(HMS_MQXXX *sensor, const char *name);   // ERROR when not open
+    void detach(HMS_MQXXX *sensor);
+    void setAlarmThreshold(HMS_MQXXX *sensor, float ppm);                   // NAN (default) = no alarm events
+    void mark(const HMS_MQXXX *sensor, const char *name);                   // Instant event, e.g. a simulated gas step
+
+    uint64_t getEventCount() const                          { return events;              }
+    uint64_t getOverhead() const                            { return overhead;            }   // Host ns spent recording, for clocks that charge host time
+
+  private:
+    typedef struct {
+      HMS_MQXXX_Listener        listener;
+      HMS_MQXXX                 *sensor;
+      HMS_MQXXX_ChromeTrace     *owner;
+      char                      name[32];
+      uint32_t                  tid;
+      float                     alarm;
+      bool                      alarmed;
+      bool                      sampleOpen;                                 // An acquire span began the current sample
+      uint64_t                  sampleBegin;
+    } Track;
+
+    FILE                        *file               = NULL;
+    Clock                       clock               = NULL;
+    void                        *clockContext       = NULL;
+    uint64_t                    epoch               = 0;                    // Steady clock at open() (ns), without a clock
+    uint64_t                    events              = 0;
+    uint64_t                    overhead            = 0;
+    uint32_t                    alarms              = 0;                    // Async ids of sample-to-alarm
+    std::vector<std::unique_ptr<Track>> tracks;
+    std::recursive_mutex        lock;                                       // Listener runs inside a span's sensor call
+
+    uint64_t now();
+    Track *find(const HMS_MQXXX *sensor);
+    void emit(const char *format, ...);
+    void record(Track *track, const HMS_MQXXX_Reading *reading, uint64_t begin, uint64_t at);
+    static uint64_t onNow(void *context);
+    static void onSpan(const HMS_MQXXX *sensor, uint8_t stage, uint64_t begin, uint64_t end, void *context);
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+};
+
+#endif
+
+#endif // HMS_MQXXX_CHROMETRACE_H
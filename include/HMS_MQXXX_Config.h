@@ -354,11 +354,29 @@
 #define HMS_MQXXX_MQ303A_PREHEAT_TIME       120                      // Preheat time (seconds) - Faster for alcohol
 #define HMS_MQXXX_MQ303A_BURN_IN_TIME       24                       // Burn-in time (hours)
 
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Warm-up Readiness Detection                                │
+    │ Usage:   init() starts the clock, update()/readSensor() feed it     │
+    │ Info:    Ready once Rs is flat and quiet, or at the preheat time    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_WARMUP_ENABLED
+#define HMS_MQXXX_WARMUP_ENABLED            1                        // 1=enabled, 0=disabled (always ready)
+#endif
+#define HMS_MQXXX_WARMUP_MIN_TIME           20                       // Never ready before this (seconds)
+#define HMS_MQXXX_WARMUP_SLOPE_LIMIT        0.002f                   // Flat: |dRs/dt| / Rs below this (1/s)
+#define HMS_MQXXX_WARMUP_NOISE_LIMIT        0.02f                    // Quiet: relative Rs std-dev below this
+#define HMS_MQXXX_WARMUP_STABLE_SAMPLES     10                       // Consecutive flat samples required
+#define HMS_MQXXX_WARMUP_ALPHA              0.2f                     // Smoothing weight of new samples
+
 /*
     ┌─────────────────────────────────────────────────────────────────────┐
     │ Note:    Temperature & Humidity Compensation (Optional)             │
     │ Usage:   Correction factors for environmental conditions            │
     │ Formula: corrected_ppm = raw_ppm * temp_factor * humidity_factor    │
+    │ Driver:  readSensor() divides the ratio by the same combined factor │
+    │          (multiplies for MQ-131), feed it via setEnvironment()      │
     │ Info:    Most MQ sensors are affected by temperature and humidity   │
     └─────────────────────────────────────────────────────────────────────┘
 */
@@ -385,8 +403,12 @@
 #define HMS_MQXXX_MQ303A_HUMIDITY_COEFF     0.003f                   // Humidity coefficient (%/%RH) - Most affected
 
 // Simple compensation enable/disable (for easy on/off)
-#define HMS_MQXXX_ENABLE_ecTEMP_COMPENSATION  0                        // 1=enabled, 0=disabled
+#ifndef HMS_MQXXX_ENABLE_TEMP_COMPENSATION
+#define HMS_MQXXX_ENABLE_TEMP_COMPENSATION     0                     // 1=enabled, 0=disabled
+#endif
+#ifndef HMS_MQXXX_ENABLE_HUMIDITY_COMPENSATION
 #define HMS_MQXXX_ENABLE_HUMIDITY_COMPENSATION 0                     // 1=enabled, 0=disabled
+#endif
 
 // Auto-select default values based on enabled sensor type
 #if defined(HMS_MQXXX_MQ2)
@@ -440,6 +462,389 @@
 #define HMS_MQXXX_MAX_A                   1e30
 #define HMS_MQXXX_MAX_B                   100.0
 
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    ADC Self-Calibration                                       │
+    │ Usage:   calibrateADC(), repeated from update() every interval      │
+    │ Source:  STM32 VREFINT + factory cal, ESP32 eFuse, AVR 1.1V bandgap │
+    │ Info:    Folded into one volts-per-code scale, no per-sample cost   │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_ADC_CALIBRATION_ENABLED
+#define HMS_MQXXX_ADC_CALIBRATION_ENABLED   1                        // 1=enabled, 0=disabled
+#endif
+#define HMS_MQXXX_ADC_CAL_INTERVAL          60000UL                  // Re-run from update() (ms), 0 = manual only
+#define HMS_MQXXX_ADC_GAIN_MIN              0.8f                     // Reject implausible results (sag/failed read)
+#define HMS_MQXXX_ADC_GAIN_MAX              1.2f
+
+#define HMS_MQXXX_STM32_NO_CHANNEL          0xFFFFFFFFUL             // setADCChannel() not called
+#define HMS_MQXXX_STM32_VREFINT_CAL_MV      3300                     // Used when VREFINT_CAL_VREF is not provided
+#define HMS_MQXXX_STM32_VREFINT_TYPICAL_MV  1210                     // Used when VREFINT_CAL_ADDR is not provided
+#define HMS_MQXXX_ESP_ADC_UNIT              ADC_UNIT_1               // Until init() resolves it from the GPIO
+#define HMS_MQXXX_ESP_ADC_ATTEN             ADC_ATTEN_DB_12
+#define HMS_MQXXX_ESP_ADC_BITWIDTH          ADC_BITWIDTH_DEFAULT     // Widest the chip has; S3/C3 accept only this or 12
+#define HMS_MQXXX_AVR_BANDGAP_MV            1100                     // Nominal, trim per board for best results
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Calibration Persistence (Optional)                         │
+    │ Usage:   saveCalibration() / restoreCalibration() on the driver     │
+    │ Backend: ESP-IDF NVS, STM32 flash pages A/B, Arduino EEPROM, host   │
+    │          file                                                       │
+    │ Info:    STM32 init() restores instead of recalibrating when valid; │
+    │          records only expire there with HMS_MQXXX_STORAGE_TIME()    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_STORAGE_ENABLED
+#define HMS_MQXXX_STORAGE_ENABLED           0                        // 1=enabled, 0=disabled
+#endif
+#define HMS_MQXXX_STORAGE_SLOTS             4                        // Records kept (one per sensor instance)
+#define HMS_MQXXX_CALIBRATION_MAGIC         0x43534D48UL             // "HMSC" little-endian
+#define HMS_MQXXX_CALIBRATION_VERSION       1
+#define HMS_MQXXX_CALIBRATION_MAX_AGE       (30UL * 24UL * 3600UL)   // Record expiry (seconds), 0 = never
+
+#define HMS_MQXXX_NVS_NAMESPACE             "hms_mqxxx"              // ESP-IDF: nvs_flash_init() is up to the app
+#define HMS_MQXXX_EEPROM_ADDRESS            0                        // Arduino: first byte of the record table
+#define HMS_MQXXX_EEPROM_SIZE               512                      // Arduino ESP32/ESP8266: emulated EEPROM size
+#ifndef HMS_MQXXX_STM32_FLASH_ADDRESS
+#define HMS_MQXXX_STM32_FLASH_ADDRESS       0x0807F800UL             // STM32: start of page/sector A reserved for us
+#endif
+#ifndef HMS_MQXXX_STM32_FLASH_SECTOR
+#define HMS_MQXXX_STM32_FLASH_SECTOR        7                        // STM32 F2/F4/F7: sector holding address A
+#endif
+#ifndef HMS_MQXXX_STM32_FLASH_ADDRESS_B                                 // STM32: page/sector B, never the same unit as A
+  #if defined(FLASH_TYPEERASE_SECTORS)
+    #define HMS_MQXXX_STM32_FLASH_ADDRESS_B 0x08080000UL             // F2/F4/F7 >= 1 MB; smaller parts must override
+  #else
+    #define HMS_MQXXX_STM32_FLASH_ADDRESS_B 0x0807F000UL
+  #endif
+#endif
+#ifndef HMS_MQXXX_STM32_FLASH_SECTOR_B
+#define HMS_MQXXX_STM32_FLASH_SECTOR_B      8                        // STM32 F2/F4/F7: sector holding address B
+#endif
+// #define HMS_MQXXX_STORAGE_TIME()         rtcSeconds()             // STM32: seconds clock for init(); unset = no expiry
+#ifndef HMS_MQXXX_HOST_STORAGE_PATH
+#define HMS_MQXXX_HOST_STORAGE_PATH         "hms_mqxxx_cal.bin"      // Host: file holding the record table
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Reading Snapshot                                           │
+    │ Usage:   getLatestReading() from any task or ISR                    │
+    │ Info:    One writer (the task calling readSensor()), any readers    │
+    │ Info:    A reader that keeps losing the race gives up, no spinning  │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_SNAPSHOT_RETRIES
+#define HMS_MQXXX_SNAPSHOT_RETRIES          4                        // Copy attempts before returning false
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Response Cache                                             │
+    │ Usage:   setCacheMaxAge(ms) per sensor, this is the default         │
+    │ Info:    readSensor()/getRS() reuse a sample younger than the       │
+    │          max-age instead of running the ADC retry loop;             │
+    │          calibrate() always acquires                                │
+    │ Info:    Config setters drop the cached ppm, invalidateCache() all  │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_CACHE_MAX_AGE
+#define HMS_MQXXX_CACHE_MAX_AGE             0                        // ms, 0 = disabled (always acquire)
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Shared ADC Arbiter                                         │
+    │ Usage:   HMS_MQXXX_Arbiter per ADC, sensor.setArbiter(&arb, ch)     │
+    │ Info:    Requests queue in slots, whoever finds the ADC idle runs   │
+    │          every pending one; same-channel requests share a result    │
+    │ Info:    Task context only, a waiting ISR would never be served     │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_ARBITER_SLOTS
+#define HMS_MQXXX_ARBITER_SLOTS             8                        // Concurrent requests per ADC (max 255)
+#endif
+#ifndef HMS_MQXXX_ARBITER_YIELD                                      // How a waiting caller gives up the CPU
+  #if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+    #define HMS_MQXXX_ARBITER_YIELD()       vTaskDelay(1)
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+    #define HMS_MQXXX_ARBITER_YIELD()       k_msleep(1)
+  #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+    #define HMS_MQXXX_ARBITER_YIELD()       HAL_Delay(1)             // Under an RTOS, override with osDelay(1)
+  #elif defined(HMS_MQXXX_PLATFORM_ARDUINO)
+    #define HMS_MQXXX_ARBITER_YIELD()       yield()
+  #else
+    #define HMS_MQXXX_ARBITER_YIELD()       std::this_thread::yield()
+  #endif
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Async Read API (C++20 coroutines)                          │
+    │ Usage:   float ppm = co_await sensor.readAsync();                   │
+    │ Backend: HostLoop, FreeRTOS software timer, Zephyr work queue       │
+    │ Info:    Needs -std=c++20 and <coroutine>, otherwise compiled out   │
+    │ Info:    FreeRTOS executor follows SERVICE_FREERTOS off ESP-IDF     │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_ASYNC_ENABLED
+#define HMS_MQXXX_ASYNC_ENABLED             1                        // Set 0 to drop readAsync() on C++20 builds
+#endif
+#ifndef HMS_MQXXX_ASYNC_CALIBRATION_INTERVAL
+#define HMS_MQXXX_ASYNC_CALIBRATION_INTERVAL 500                     // Default spacing of calibrateAsync() samples (ms)
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Memory Footprint                                           │
+    │ Usage:   COMPACT_STATE 1 for many sensors on small RAM (AVR, M0)    │
+    │ Info:    Compact instances point at a shared const profile instead  │
+    │          of carrying curve, divider and ADC settings;               │
+    │          setA()/setRL()/... give way to setProfile()                │
+    │ Info:    The sample cache is the published reading (no separate     │
+    │          voltage/ppm copies); a cache hit reconverts it             │
+    │ Info:    COMPACT_BUDGET caps sizeof: 152 B 32-bit, 192 B 64-bit     │
+    │ Info:    NO_HEAP 1: static RTOS objects, pooled coroutine frames    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_COMPACT_STATE
+#define HMS_MQXXX_COMPACT_STATE             0                        // 1=shared profiles, 0=per-instance configuration
+#endif
+#ifndef HMS_MQXXX_READ_RETRIES
+#define HMS_MQXXX_READ_RETRIES              2                        // Conversions averaged per acquisition
+#endif
+#ifndef HMS_MQXXX_READ_INTERVAL
+#define HMS_MQXXX_READ_INTERVAL             20                       // Spacing of those conversions (ms)
+#endif
+#ifndef HMS_MQXXX_NO_HEAP
+#define HMS_MQXXX_NO_HEAP                   1                        // 1=never allocate (needs static FreeRTOS allocation)
+#endif
+#ifndef HMS_MQXXX_ASYNC_FRAMES
+#define HMS_MQXXX_ASYNC_FRAMES              8                        // Coroutine frames in the pool (2 per readAsync())
+#endif
+#ifndef HMS_MQXXX_ASYNC_FRAME_SIZE
+#define HMS_MQXXX_ASYNC_FRAME_SIZE          160                      // Bytes per frame, calibrateAsync() needs 144 on 64-bit
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Compressed History                                         │
+    │ Usage:   HMS_MQXXX_History h; h.attach(&sensor);                    │
+    │ Info:    Delta-of-delta timestamps, XOR-float values, fixed ring    │
+    │          of blocks; the oldest block is recycled when full          │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_HISTORY_BLOCK_SIZE
+#define HMS_MQXXX_HISTORY_BLOCK_SIZE        64                       // Payload bytes per block (max 8191)
+#endif
+#ifndef HMS_MQXXX_HISTORY_BLOCKS
+#define HMS_MQXXX_HISTORY_BLOCKS            16                       // Blocks in the ring (2..255)
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Flash Ring Log                                             │
+    │ Usage:   HMS_MQXXX_FlashLog log; log.begin(); log.attach(&sensor);  │
+    │ Backend: ESP32 data partition, STM32 flash sectors, host file       │
+    │ Info:    Records batch in a RAM page programmed once; a sector is   │
+    │          erased only when the ring wraps onto it (even wear)        │
+    │ Info:    begin() reads only headers: one per sector, then the       │
+    │          page headers of the newest sector                          │
+    │ Info:    Erases only in begin()/maintain()/erase(), never from the  │
+    │          reading listener; call maintain() between readings, on the │
+    │          task that reads the sensor (the log is not locked)         │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#define HMS_MQXXX_FLASHLOG_MAGIC            0x4C534D48UL             // "HMSL" little-endian
+#ifndef HMS_MQXXX_FLASHLOG_PAGE_SIZE
+#define HMS_MQXXX_FLASHLOG_PAGE_SIZE        256                      // RAM buffer and program unit: header + 10 records
+#endif
+#ifndef HMS_MQXXX_FLASHLOG_SECTOR_SIZE                                 // Erase unit, a multiple of the page size
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL) && defined(FLASH_TYPEERASE_SECTORS)
+    #define HMS_MQXXX_FLASHLOG_SECTOR_SIZE  0x20000UL                // F2/F4/F7: the uniform 128 KB sectors
+  #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL) && defined(FLASH_PAGE_SIZE)
+    #define HMS_MQXXX_FLASHLOG_SECTOR_SIZE  FLASH_PAGE_SIZE
+  #else
+    #define HMS_MQXXX_FLASHLOG_SECTOR_SIZE  4096                     // SPI NOR sector
+  #endif
+#endif
+#ifndef HMS_MQXXX_FLASHLOG_SECTORS                                     // STM32/host ring size (ESP32: partition size)
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL) && defined(FLASH_TYPEERASE_SECTORS)
+    #define HMS_MQXXX_FLASHLOG_SECTORS      2
+  #else
+    #define HMS_MQXXX_FLASHLOG_SECTORS      16
+  #endif
+#endif
+#ifndef HMS_MQXXX_FLASHLOG_ERASE_AHEAD
+#define HMS_MQXXX_FLASHLOG_ERASE_AHEAD      1                        // maintain() erases at this many free head pages
+#endif
+#ifndef HMS_MQXXX_FLASHLOG_PARTITION
+#define HMS_MQXXX_FLASHLOG_PARTITION        "hms_log"                // ESP32: data partition label
+#endif
+#ifndef HMS_MQXXX_STM32_LOG_ADDRESS
+  #if defined(FLASH_TYPEERASE_SECTORS)
+    #define HMS_MQXXX_STM32_LOG_ADDRESS     0x08020000UL             // STM32: first sector/page, keep out of the linker
+  #else
+    #define HMS_MQXXX_STM32_LOG_ADDRESS     0x08070000UL
+  #endif
+#endif
+#ifndef HMS_MQXXX_STM32_LOG_SECTOR
+#define HMS_MQXXX_STM32_LOG_SECTOR          5                        // STM32 F2/F4/F7: sector number at the address
+#endif
+#ifndef HMS_MQXXX_HOST_LOG_PATH
+#define HMS_MQXXX_HOST_LOG_PATH             "hms_mqxxx_log.bin"      // Host: file standing in for the flash
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Rollups                                                    │
+    │ Usage:   HMS_MQXXX_Rollup r; r.attach(&sensor);                     │
+    │ Info:    min/max/mean/count per gas at each level, circular bucket  │
+    │          arrays; a sample updates one bucket per level and gas      │
+    │ Info:    RAM = gases x total slots x 20 bytes (13 KB as shipped)    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_ROLLUP_GASES
+#define HMS_MQXXX_ROLLUP_GASES              6                        // Gases tracked, HMS_MQXXX_MAX_GASES covers all
+#endif
+#ifndef HMS_MQXXX_ROLLUP_LEVELS                                         // Override the four together
+#define HMS_MQXXX_ROLLUP_LEVELS             3
+#endif
+#ifndef HMS_MQXXX_ROLLUP_PERIODS
+#define HMS_MQXXX_ROLLUP_PERIODS            { 60000UL, 3600000UL, 86400000UL }   // ms per bucket, one per level
+#endif
+#ifndef HMS_MQXXX_ROLLUP_SLOTS
+#define HMS_MQXXX_ROLLUP_SLOTS              { 60, 24, 30 }           // Buckets kept: 60 min, 24 h, 30 d
+#endif
+#ifndef HMS_MQXXX_ROLLUP_TOTAL_SLOTS
+#define HMS_MQXXX_ROLLUP_TOTAL_SLOTS        (60 + 24 + 30)           // Sum of the slots above
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Telemetry Batching                                         │
+    │ Usage:   HMS_MQXXX_Telemetry t(sink, ctx); t.attach(&sensor, id);   │
+    │ Info:    Readings are delta-coded into one frame, sent when it is   │
+    │          full or its first record is too old; alarms go at once     │
+    │ Info:    Call poll(now) from the main loop so an idle batch ages out│
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_TELEMETRY_FRAME_SIZE
+#define HMS_MQXXX_TELEMETRY_FRAME_SIZE      51                       // Bytes per frame (LoRaWAN EU868 DR0 payload)
+#endif
+#ifndef HMS_MQXXX_TELEMETRY_MAX_AGE
+#define HMS_MQXXX_TELEMETRY_MAX_AGE         600000UL                 // ms a record may wait before the frame goes
+#endif
+#ifndef HMS_MQXXX_TELEMETRY_SOURCES
+#define HMS_MQXXX_TELEMETRY_SOURCES         4                        // Sensors one batcher can attach
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Modbus Slave (Optional)                                    │
+    │ Usage:   HMS_MQXXX_Modbus m(addr); m.attach(&sensor);               │
+    │ Info:    Feed RTU frames / TCP ADUs to processRTU()/processTCP();   │
+    │          call service() from the sensor task to run calibrations    │
+    │ Info:    Register map is listed in HMS_MQXXX_Modbus.h               │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_MODBUS_ADDRESS
+#define HMS_MQXXX_MODBUS_ADDRESS            1                        // Default slave address (1..247)
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Cycle-Count Instrumentation (Optional)                     │
+    │ Usage:   HMS_MQXXX_CycleStats stats; sensor.setCycleStats(&stats);  │
+    │ Info:    Times ADC, mqDelay(), Rs, ratio and curve stages into log2 │
+    │          histograms; compiled out entirely when disabled            │
+    │ Backend: DWT CYCCNT, ESP cycle count, k_cycle_get_32, clock_gettime │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_CYCLE_STATS_ENABLED
+#define HMS_MQXXX_CYCLE_STATS_ENABLED       0                        // 1=build HMS_MQXXX_CycleStats and the timing points
+#endif
+#ifndef HMS_MQXXX_CYCLE_BUCKETS
+#define HMS_MQXXX_CYCLE_BUCKETS             32                       // log2 buckets per stage, the last one is open-ended
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Curve Math Mode                                            │
+    │ Options: 0 = double (reference), 1 = float, 2 = fast approximation  │
+    │ Info:    Budgets are the max relative ppm error each mode may show  │
+    │          against double; HMS_MQXXX_Conformance enforces them        │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_MATH_MODE
+#define HMS_MQXXX_MATH_MODE                 0                        // HMS_MQXXX_MathMode used by the driver
+#endif
+#ifndef HMS_MQXXX_MATH_FLOAT_BUDGET
+#define HMS_MQXXX_MATH_FLOAT_BUDGET         1e-5f                    // Max relative error of HMS_MQXXX_MATH_FLOAT
+#endif
+#ifndef HMS_MQXXX_MATH_FAST_BUDGET
+#define HMS_MQXXX_MATH_FAST_BUDGET          1e-4f                    // Max relative error of HMS_MQXXX_MATH_FAST
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Binary Event Trace (Optional)                              │
+    │ Usage:   HMS_MQXXX_TraceDump() into a file, HMS_MQXXX_TraceDecode   │
+    │ Info:    20-byte records in a lock-free RAM ring, cheap enough to   │
+    │          stay on in production where HMS_MQXXX_DEBUG_ENABLED string │
+    │          logging is too slow; timestamps use the cycle-count ticks  │
+    │          plus a millisecond stamp that carries them across wraps    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_BINARY_TRACE
+#define HMS_MQXXX_BINARY_TRACE              0                        // 1=build the trace ring and the driver trace points
+#endif
+#ifndef HMS_MQXXX_TRACE_RECORDS
+#define HMS_MQXXX_TRACE_RECORDS             256                      // Ring size in records (power of two, 20 bytes each)
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Host Simulation Spans (Optional, host builds only)         │
+    │ Usage:   HMS_MQXXX_ChromeTrace trace; trace.open("sim.json", clock) │
+    │ Info:    Each acquisition, mqDelay() and conversion stage as a      │
+    │          span in Chrome trace-event JSON (chrome://tracing,         │
+    │          ui.perfetto.dev), with sample-to-alarm latency per sensor  │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_HOST_SPANS
+#define HMS_MQXXX_HOST_SPANS                0                        // 1=report stage spans through HMS_MQXXX_SetHostSpans()
+#endif
+
+/*
+    ┌─────────────────────────────────────────────────────────────────────┐
+    │ Note:    Acquisition Service (Optional, FreeRTOS)                   │
+    │ Usage:   HMS_MQXXX_Service owns one task sampling every sensor      │
+    │ Backend: ESP-IDF, or any FreeRTOS port with SERVICE_FREERTOS = 1    │
+    │ Info:    Consumers get task notifications and/or a reading queue    │
+    └─────────────────────────────────────────────────────────────────────┘
+*/
+#ifndef HMS_MQXXX_SERVICE_FREERTOS
+#define HMS_MQXXX_SERVICE_FREERTOS          0                        // 1=build the service on a non ESP-IDF FreeRTOS port
+#endif
+#ifndef HMS_MQXXX_SERVICE_MAX_SENSORS
+#define HMS_MQXXX_SERVICE_MAX_SENSORS       4                        // Sensors per service (max 32, one notify bit each)
+#endif
+#ifndef HMS_MQXXX_SERVICE_MAX_CONSUMERS
+#define HMS_MQXXX_SERVICE_MAX_CONSUMERS     4                        // Tasks notified after every cycle
+#endif
+#ifndef HMS_MQXXX_SERVICE_QUEUE_DEPTH
+#define HMS_MQXXX_SERVICE_QUEUE_DEPTH       8                        // Preallocated reading slots, 0 = no queue
+#endif
+#ifndef HMS_MQXXX_SERVICE_STOP_TIMEOUT
+#define HMS_MQXXX_SERVICE_STOP_TIMEOUT      5000                     // Longest wait (ms) for the task to leave a cycle
+#endif
+#define HMS_MQXXX_SERVICE_PERIOD            1000                     // Default sampling period (ms)
+#define HMS_MQXXX_SERVICE_PRIORITY          5                        // Default task priority
+#define HMS_MQXXX_SERVICE_CORE              1                        // ESP-IDF: default core, tskNO_AFFINITY allowed
+#define HMS_MQXXX_SERVICE_STACK_DEPTH       4096                     // ESP-IDF: bytes, vanilla FreeRTOS: words
+
 /*
     ┌─────────────────────────────────────────────────────────────────────┐
     │ Note:    Convenience Macros for Quick Access                        │
@@ -0,0 +1,142 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Cycles.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Per-stage cycle-count histograms of the MQXXX acquisition path
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_CYCLES_H
+#define HMS_MQXXX_CYCLES_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+typedef enum {
+  HMS_MQXXX_STAGE_ACQUIRE   = 0,                                            // One readADC() conversion (arbiter wait included)
+  HMS_MQXXX_STAGE_DELAY,                                                    // One mqDelay() between conversions
+  HMS_MQXXX_STAGE_AVERAGE,                                                  // Averaged code to voltage
+  HMS_MQXXX_STAGE_RS,                                                       // Voltage to Rs (acquisition task only, not convertVoltage())
+  HMS_MQXXX_STAGE_RATIO,                                                    // Rs to ratio, compensation and correction
+  HMS_MQXXX_STAGE_CURVE,                                                    // Ratio to ppm (HMS_MQXXX_MATH_MODE curve)
+  HMS_MQXXX_STAGE_READING,                                                  // Whole readSensor() that acquired a sample
+  HMS_MQXXX_STAGE_COUNT
+} HMS_MQXXX_Stage;
+
+#if defined(HMS_MQXXX_CYCLES_ENABLED) || defined(HMS_MQXXX_TRACE_ENABLED)
+
+/*
+  Free-running tick counter shared by the cycle statistics and the binary trace, the cheapest
+  one of the target:
+    STM32 (Cortex-M3/4/7/33)  DWT CYCCNT, enabled by HMS_MQXXX_StartTicks()
+    ESP-IDF / Arduino-ESP32   esp_cpu_get_cycle_count()
+    Zephyr                    k_cycle_get_32()
+    Host                      clock_gettime(CLOCK_MONOTONIC), in ns
+    anything else             micros() (Arduino) or HAL_GetTick() (STM32 without DWT)
+  HMS_MQXXX_GetTickRate() gives ticks per second. A 32-bit cycle counter wraps after a few
+  seconds at hundreds of MHz.
+*/
+void HMS_MQXXX_StartTicks();
+uint32_t HMS_MQXXX_GetTicks();
+uint32_t HMS_MQXXX_GetTickRate();
+
+#endif
+
+#if defined(HMS_MQXXX_CYCLES_ENABLED)
+
+/*
+  Latency histograms of the acquisition stages, filled by every sensor the object is handed
+  to with setCycleStats(). Bucket b counts the samples of [2^b, 2^(b+1)) ticks (see
+  HMS_MQXXX_GetTicks()), bucket 0 also holds 0 and 1 and the last bucket everything above;
+  min, max and the sum are exact. Counter wrap only matters for HMS_MQXXX_STAGE_DELAY and
+  STAGE_READING with long read intervals.
+
+  Recording is a plain read-modify-write: give each acquisition task its own object. The
+  conversion stages are timed only when the sensor's own task converts (readSensor(),
+  processVoltage()); convertVoltage() from other tasks is never recorded.
+*/
+class HMS_MQXXX_CycleStats {
+  public:
+    HMS_MQXXX_CycleStats();
+    HMS_MQXXX_CycleStats(const HMS_MQXXX_CycleStats &) = delete;
+    HMS_MQXXX_CycleStats &operator=(const HMS_MQXXX_CycleStats &) = delete;
+
+    static uint32_t now()                                   { return HMS_MQXXX_GetTicks();    }
+    static uint32_t getTickRate()                           { return HMS_MQXXX_GetTickRate(); }
+
+    void record(HMS_MQXXX_Stage stage, uint32_t ticks);
+    void clear();
+
+    uint32_t getCount(HMS_MQXXX_Stage stage) const;
+    uint32_t getMin(HMS_MQXXX_Stage stage) const;                           // 0 without samples
+    uint32_t getMax(HMS_MQXXX_Stage stage) const;
+    uint32_t getMean(HMS_MQXXX_Stage stage) const;
+    uint32_t getBucket(HMS_MQXXX_Stage stage, uint8_t bucket) const;
+    uint32_t getPercentile(HMS_MQXXX_Stage stage, float fraction) const;    // Upper edge of the bucket, capped at max
+
+  private:
+    typedef struct {
+      uint32_t                  buckets[HMS_MQXXX_CYCLE_BUCKETS];
+      uint32_t                  count;
+      uint32_t                  min;
+      uint32_t                  max;
+      uint64_t                  total;
+    } Histogram;
+
+    Histogram                   stages[HMS_MQXXX_STAGE_COUNT];
+};
+
+#define HMS_MQXXX_STATS_BEGIN_IF(owner, name)       uint32_t name = ((owner) && cycleStats != NULL) ? HMS_MQXXX_CycleStats::now() : 0
+#define HMS_MQXXX_STATS_END_IF(owner, stage, name)  do { if((owner) && cycleStats != NULL) cycleStats->record(stage, HMS_MQXXX_CycleStats::now() - name); } while(0)
+
+#else
+
+#define HMS_MQXXX_STATS_BEGIN_IF(owner, name)       (void)(owner)
+#define HMS_MQXXX_STATS_END_IF(owner, stage, name)
+
+#endif
+
+#if defined(HMS_MQXXX_SPANS_ENABLED)
+#define HMS_MQXXX_SPAN_BEGIN(name)          uint64_t name##Span = HMS_MQXXX_SpanBegin()
+#define HMS_MQXXX_SPAN_END(stage, name)     HMS_MQXXX_SpanEnd(this, stage, name##Span)
+#else
+#define HMS_MQXXX_SPAN_BEGIN(name)
+#define HMS_MQXXX_SPAN_END(stage, name)
+#endif
+
+// Instrumentation points inside the driver: histograms, host spans, or nothing in builds without either
+#define HMS_MQXXX_CYCLES_BEGIN(name)        HMS_MQXXX_STATS_BEGIN_IF(true, name); HMS_MQXXX_SPAN_BEGIN(name)
+#define HMS_MQXXX_CYCLES_END(stage, name)   HMS_MQXXX_STATS_END_IF(true, stage, name); HMS_MQXXX_SPAN_END(stage, name)
+
+// Points in code any task may run: histograms only when `owner` says the sensor's task is timing (spans are thread-safe)
+#define HMS_MQXXX_CYCLES_BEGIN_IF(owner, name)      HMS_MQXXX_STATS_BEGIN_IF(owner, name); HMS_MQXXX_SPAN_BEGIN(name)
+#define HMS_MQXXX_CYCLES_END_IF(owner, stage, name) HMS_MQXXX_STATS_END_IF(owner, stage, name); HMS_MQXXX_SPAN_END(stage, name)
+
+#endif // HMS_MQXXX_CYCLES_H
@@ -47,6 +47,8 @@
   #define HMS_MQXXX_PLATFORM_ZEPHYR
 #elif defined( __STM32__)
   #define HMS_MQXXX_PLATFORM_STM32_HAL
+#elif defined(__linux__) || defined(__APPLE__) || defined(_WIN32)
+  #define HMS_MQXXX_PLATFORM_HOST
 #endif
 
 #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
@@ -55,8 +57,21 @@
   #include <float.h>
   #include <math.h>
 #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #include <stdint.h>
+  #include <stddef.h>
+  #include <float.h>
+  #include <math.h>
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #include "esp_adc/adc_oneshot.h"
+  #include "soc/soc_caps.h"
 #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
   #include <stdio.h>
+  #include <stdint.h>
+  #include <stddef.h>
+  #include <float.h>
+  #include <math.h>
+  #include <zephyr/kernel.h>
   #include <zephyr/device.h>
   #include <zephyr/drivers/i2c.h>
 #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
@@ -64,14 +79,57 @@
   #include <math.h>
   #include <float.h>
   #include <stdio.h>
+#elif defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <stdint.h>
+  #include <stddef.h>
+  #include <float.h>
+  #include <math.h>
+  #include <stdio.h>
 #endif
 
 #include "HMS_MQXXX_Config.h"
 
+#if defined(HMS_MQXXX_PLATFORM_ARDUINO)                                    // Default ADC full scale and resolution
+  #define HMS_MQXXX_ADC_VREF_DEFAULT    5.0f
+  #define HMS_MQXXX_ADC_BITS_DEFAULT    10
+#elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #define HMS_MQXXX_ADC_VREF_DEFAULT    3.3f
+  #define HMS_MQXXX_ADC_BITS_DEFAULT    SOC_ADC_RTC_MAX_BITWIDTH             // What ADC_BITWIDTH_DEFAULT converts at (12, S2: 13)
+#else
+  #define HMS_MQXXX_ADC_VREF_DEFAULT    3.3f
+  #define HMS_MQXXX_ADC_BITS_DEFAULT    12
+#endif
+
 #if defined(HMS_MQXXX_DEBUG_ENABLED) && (HMS_MQXXX_DEBUG_ENABLED == 1)
   #define HMS_MQXXX_LOGGER_ENABLED
 #endif
 
+#if (HMS_MQXXX_ENABLE_TEMP_COMPENSATION == 1) || (HMS_MQXXX_ENABLE_HUMIDITY_COMPENSATION == 1)
+  #define HMS_MQXXX_COMPENSATION_ENABLED
+#endif
+
+#if defined(HMS_MQXXX_COMPACT_STATE) && (HMS_MQXXX_COMPACT_STATE == 1)
+  #define HMS_MQXXX_COMPACT_ENABLED
+#endif
+
+#if defined(HMS_MQXXX_CYCLE_STATS_ENABLED) && (HMS_MQXXX_CYCLE_STATS_ENABLED == 1)
+  #define HMS_MQXXX_CYCLES_ENABLED                                          // setCycleStats(), see HMS_MQXXX_Cycles.h
+#endif
+
+#if defined(HMS_MQXXX_BINARY_TRACE) && (HMS_MQXXX_BINARY_TRACE == 1)
+  #define HMS_MQXXX_TRACE_ENABLED                                           // Event ring, see HMS_MQXXX_Trace.h
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_HOST) && defined(HMS_MQXXX_HOST_SPANS) && (HMS_MQXXX_HOST_SPANS == 1)
+  #define HMS_MQXXX_SPANS_ENABLED                                           // HMS_MQXXX_SetHostSpans(), see HMS_MQXXX_ChromeTrace.h
+#endif
+
+#if defined(HMS_MQXXX_ASYNC_ENABLED) && (HMS_MQXXX_ASYNC_ENABLED == 1) && (__cplusplus >= 202002L) && defined(__has_include)
+  #if __has_include(<coroutine>)
+    #define HMS_MQXXX_ASYNC_AVAILABLE                                       // readAsync()/calibrateAsync(), see HMS_MQXXX_Async.h
+  #endif
+#endif
+
 typedef enum {
   HMS_MQXXX_MQ2,
   HMS_MQXXX_MQ131,
@@ -87,9 +145,262 @@ typedef enum {
 typedef enum {
   HMS_MQXXX_OK       = 0x00,
   HMS_MQXXX_ERROR    = 0x01,
-  HMS_MQXXX_NOT_FOUND= 0x04
+  HMS_MQXXX_NOT_FOUND= 0x04,
+  HMS_MQXXX_STALE    = 0x08
 } HMS_MQXXX_StatusTypeDef;
 
+typedef enum {
+  HMS_MQXXX_WARMUP_COLD      = 0,                                           // No sample since power-on
+  HMS_MQXXX_WARMUP_HEATING   = 1,                                           // Rs still drifting
+  HMS_MQXXX_WARMUP_SETTLING  = 2,                                           // Rs flat, collecting the stable streak
+  HMS_MQXXX_WARMUP_READY     = 3                                            // Stable, or preheat time elapsed
+} HMS_MQXXX_WarmupState;
+
+typedef enum {
+  HMS_MQXXX_FLAG_NONE        = 0x00,
+  HMS_MQXXX_FLAG_WARMUP      = 0x01,                                        // Heater not settled, reading not trustworthy
+  HMS_MQXXX_FLAG_SATURATED   = 0x02                                         // ppm clipped to 0 or FLT_MAX
+} HMS_MQXXX_ReadingFlags;
+
+/*
+  One complete conversion result. convertVoltage() builds it without touching driver state;
+  readSensor() publishes the latest one for lock-free readers (see getLatestReading()).
+  Size is a multiple of 4 so the snapshot can be copied as whole words.
+*/
+typedef struct {
+  uint32_t  timestamp;                                                      // mqMillis() at acquisition (ms)
+  float     voltage;                                                        // Sensor output voltage
+  float     rs;                                                             // Sensor resistance in kilo ohms
+  float     ratio;                                                          // Rs/R0 (R0/Rs for MQ-131), compensated and corrected
+  float     ppm;                                                            // Concentration for the active curve
+  uint8_t   status;                                                         // HMS_MQXXX_StatusTypeDef, ERROR when no curve is set
+  uint8_t   flags;                                                          // HMS_MQXXX_ReadingFlags
+  uint8_t   reserved[2];
+} HMS_MQXXX_Reading;
+
+typedef enum {
+  HMS_MQXXX_GAS_LPG          = 0,
+  HMS_MQXXX_GAS_CO           = 1,
+  HMS_MQXXX_GAS_H2           = 2,
+  HMS_MQXXX_GAS_ALCOHOL      = 3,
+  HMS_MQXXX_GAS_PROPANE      = 4,
+  HMS_MQXXX_GAS_CO2          = 5,
+  HMS_MQXXX_GAS_NH3          = 6,
+  HMS_MQXXX_GAS_TOLUENE      = 7,
+  HMS_MQXXX_GAS_ACETONE      = 8,
+  HMS_MQXXX_GAS_O3           = 9,
+  HMS_MQXXX_GAS_NO2          = 10,
+  HMS_MQXXX_GAS_CL2          = 11,
+  HMS_MQXXX_GAS_ETHANOL      = 12,
+  HMS_MQXXX_GAS_ISO_BUTANE   = 13,
+  HMS_MQXXX_GAS_COUNT
+} HMS_MQXXX_Gas;
+
+#define HMS_MQXXX_MAX_GASES     6                                           // Longest per-type curve table (MQ-135)
+
+/*
+  Datasheet curve of one gas. HMS_MQXXX_GetGasCurves() returns the table for a sensor type
+  (built from the HMS_MQXXX_<TYPE>_A/B_<GAS> coefficients in HMS_MQXXX_Config.h) so one ratio
+  can be turned into every gas the sensor responds to, see HMS_MQXXX::evaluateGases().
+*/
+typedef struct {
+  HMS_MQXXX_Gas         gas;
+  HMS_MQXXX_Regression  regression;
+  float                 a;
+  float                 b;
+} HMS_MQXXX_GasCurve;
+
+const HMS_MQXXX_GasCurve *HMS_MQXXX_GetGasCurves(HMS_MQXXX_Type type, uint8_t *count);
+const char *HMS_MQXXX_GetGasName(HMS_MQXXX_Gas gas);
+
+/*
+  Arithmetic of the ratio -> ppm curve. DOUBLE is the reference; FLOAT keeps the same steps in
+  single precision (no soft-double on FPU-less or single-FPU MCUs); FAST replaces log10/pow by
+  short polynomials and exponent bit tricks. HMS_MQXXX_MATH_MODE picks the one the driver uses,
+  HMS_MQXXX_CurveToPPM() runs any of them (conformance tooling). Saturation, ratio <= 0 and
+  a == 0 behave the same in every mode; the relative error each mode is held to is declared
+  next to HMS_MQXXX_MATH_MODE.
+*/
+typedef enum {
+  HMS_MQXXX_MATH_DOUBLE = 0,
+  HMS_MQXXX_MATH_FLOAT  = 1,
+  HMS_MQXXX_MATH_FAST   = 2,
+  HMS_MQXXX_MATH_COUNT
+} HMS_MQXXX_MathMode;
+
+float HMS_MQXXX_CurveToPPM(HMS_MQXXX_MathMode mode, HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags = NULL);
+
+/*
+  Everything about a sensor that is the same for every unit of a kind: curve, divider, ADC
+  and acquisition settings (28 bytes). HMS_MQXXX_GetProfile() returns the built-in one for a
+  type. Compact-state builds keep only a pointer to a profile per instance, so any number of
+  sensors sharing a profile pay for it once; it must outlive the sensors using it.
+*/
+typedef struct {
+  float     a;                                                              // Curve coefficient a
+  float     b;                                                              // Curve coefficient b
+  float     vcc;                                                            // Sensor supply voltage
+  float     rl;                                                             // Load resistance in kilo ohms
+  float     voltageResolution;                                              // ADC full scale (V)
+  uint16_t  retryInterval;                                                  // Spacing of averaged conversions (ms)
+  uint8_t   retries;                                                        // Conversions averaged per acquisition
+  uint8_t   adcBitResolution;
+  uint8_t   type;                                                           // HMS_MQXXX_Type
+  uint8_t   regression;                                                     // HMS_MQXXX_Regression
+  uint8_t   reserved[2];
+} HMS_MQXXX_Profile;
+
+const HMS_MQXXX_Profile *HMS_MQXXX_GetProfile(HMS_MQXXX_Type type);
+
+#if defined(__AVR__)
+  typedef uint8_t HMS_MQXXX_SeqWord;                                        // Widest single-instruction access on AVR
+#else
+  typedef uint32_t HMS_MQXXX_SeqWord;
+#endif
+
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+  // Published form of a reading in compact builds: rs is left out, getLatestReading() recomputes it from the voltage
+  typedef struct {
+    uint32_t  timestamp;
+    float     voltage;
+    float     ratio;
+    float     ppm;
+    uint8_t   status;
+    uint8_t   flags;
+    uint8_t   reserved[2];
+  } HMS_MQXXX_Snapshot;
+#else
+  typedef HMS_MQXXX_Reading HMS_MQXXX_Snapshot;
+#endif
+
+/*
+  Persisted calibration record. Layout is fixed (40 bytes, 8-byte multiple so it can be
+  programmed as words or double words) and protected by a CRC-32 over every preceding byte.
+  Bump HMS_MQXXX_CALIBRATION_VERSION whenever a field is added or reinterpreted.
+*/
+typedef struct {
+  uint32_t  magic;                                                          // HMS_MQXXX_CALIBRATION_MAGIC
+  uint16_t  version;                                                        // HMS_MQXXX_CALIBRATION_VERSION
+  uint16_t  length;                                                         // sizeof(HMS_MQXXX_CalibrationRecord)
+  uint8_t   type;                                                           // HMS_MQXXX_Type the record belongs to
+  uint8_t   regression;                                                     // HMS_MQXXX_Regression
+  uint8_t   reserved[2];
+  float     r0;                                                             // Sensor resistance in clean air
+  float     rl;                                                             // Load resistance in kilo ohms
+  float     vcc;                                                            // Sensor supply voltage
+  float     a;                                                              // Curve coefficient a
+  float     b;                                                              // Curve coefficient b
+  uint32_t  timestamp;                                                      // Caller supplied time of calibration (s)
+  uint32_t  crc;                                                            // CRC-32 of all preceding bytes
+} HMS_MQXXX_CalibrationRecord;
+
+uint32_t HMS_MQXXX_Crc32(const void *data, size_t length, uint32_t crc = 0);
+uint32_t HMS_MQXXX_Millis();                                                // Platform uptime (ms), the clock of readings and trace records
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+/*
+  Host builds have no ADC or scheduler of their own. The application (simulator, benchmark,
+  replay tool) supplies them through these hooks; any hook left NULL falls back to a sane
+  default (mid-scale ADC code, real-time sleep, monotonic clock).
+*/
+typedef struct {
+  uint16_t  (*readADC)(uint8_t pin, void *context);
+  void      (*delay)(uint32_t ms, void *context);
+  uint32_t  (*millis)(void *context);
+  void      *context;
+} HMS_MQXXX_HostHooks;
+
+void HMS_MQXXX_SetHostHooks(const HMS_MQXXX_HostHooks *hooks);
+
+#if defined(HMS_MQXXX_SPANS_ENABLED)
+class HMS_MQXXX;
+
+/*
+  Stage spans for simulations. Every stage the cycle-count instrumentation times (see
+  HMS_MQXXX_Stage) is reported once it ends, with begin and end read from `now` (ns), which is
+  normally the simulation's virtual clock. Install before the sensors run; `span` may be
+  called from several tasks at once. HMS_MQXXX_ChromeTrace is the stock implementation.
+*/
+typedef struct {
+  uint64_t  (*now)(void *context);
+  void      (*span)(const HMS_MQXXX *sensor, uint8_t stage, uint64_t begin, uint64_t end, void *context);
+  void      *context;
+} HMS_MQXXX_HostSpans;
+
+void HMS_MQXXX_SetHostSpans(const HMS_MQXXX_HostSpans *spans);
+uint64_t HMS_MQXXX_SpanBegin();
+void HMS_MQXXX_SpanEnd(const HMS_MQXXX *sensor, uint8_t stage, uint64_t begin);
+#endif
+#endif
+
+/*
+  Pulls the current conditions from an external sensor (SHT3x, BME280, ...). Return false when
+  no fresh value is available; the last known conditions are kept.
+*/
+typedef bool (*HMS_MQXXX_EnvironmentCallback)(float *temperature, float *humidity, void *context);
+
+/*
+  Reading observer. The node is owned by the caller and linked into the sensor (intrusive list,
+  no allocation); every reading published by readSensor()/processVoltage() is handed to each
+  attached listener, in the publishing task, right after the snapshot is updated. The optional
+  event callback hears state changes that are not readings (a new R0 from calibrate()).
+*/
+typedef enum {
+  HMS_MQXXX_EVENT_CALIBRATED  = 1                                           // value = new R0, aux = ratio in clean air
+} HMS_MQXXX_Event;
+
+typedef void (*HMS_MQXXX_ReadingCallback)(const HMS_MQXXX_Reading *reading, void *context);
+typedef void (*HMS_MQXXX_EventCallback)(HMS_MQXXX_Event event, uint32_t timestamp, float value, float aux, void *context);
+
+typedef struct HMS_MQXXX_Listener {
+  HMS_MQXXX_ReadingCallback   callback;
+  HMS_MQXXX_EventCallback     event;                                        // NULL = readings only
+  void                        *context;
+  struct HMS_MQXXX_Listener   *next;                                        // Maintained by the sensor
+} HMS_MQXXX_Listener;
+
+/*
+  Incremental least-squares fit of the curve coefficients from (reference ppm, measured ratio)
+  pairs, done in log-log space. Only running means and co-moments of u = log10(ratio) and
+  v = log10(ppm) are kept (Welford update), so the state is O(1) per gas and the same points
+  can be solved for either regression form:
+    HMS_MQXXX_EXPONENTIAL  ppm = a * ratio^b          -> v on u, b = slope, a = 10^intercept
+    HMS_MQXXX_LINEAR       log(ratio) = a*log(ppm)+b  -> u on v, a = slope, b = intercept
+  The residual is the RMS error of the fitted log10 quantity (log ppm or log ratio).
+*/
+class HMS_MQXXX_CurveFit {
+  public:
+    void reset();
+    HMS_MQXXX_StatusTypeDef addPoint(float referencePPM, float ratio);
+    HMS_MQXXX_StatusTypeDef solve(HMS_MQXXX_Regression method, float *a, float *b, float *residual = NULL) const;
+
+    uint16_t getCount() const                               { return count;               }
+
+  private:
+    uint16_t                    count               = 0;                    // Accepted points
+    double                      meanU               = 0;                    // Mean of log10(ratio)
+    double                      meanV               = 0;                    // Mean of log10(ppm)
+    double                      m2U                 = 0;                    // Sum of squared deviations of u
+    double                      m2V                 = 0;                    // Sum of squared deviations of v
+    double                      cUV                 = 0;                    // Sum of co-deviations of u and v
+};
+
+#if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+HAL_StatusTypeDef HMS_MQXXX_STM32SelectChannel(ADC_HandleTypeDef *hadc, uint32_t channel);   // Rank 1, longest sample time
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_STM32FlashErase(uint32_t address, uint32_t sector);        // Page at address (or sector number), flash unlocked
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_STM32FlashProgram(uint32_t address, const void *data, size_t length);  // Length in whole words/doublewords
+#elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+void HMS_MQXXX_ESPSetADCUnit(adc_unit_t unit, adc_oneshot_unit_handle_t handle);  // Share an app-owned oneshot unit, before init()
+#endif
+
+class HMS_MQXXX_Arbiter;
+class HMS_MQXXX_CycleStats;
+
+#if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+template<typename T> class HMS_MQXXX_Task;
+class HMS_MQXXX_Executor;
+#endif
+
 class HMS_MQXXX {
   public:
     #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
@@ -100,79 +411,278 @@ class HMS_MQXXX {
       HMS_MQXXX(uint8_t pin = 36, HMS_MQXXX_Type type = HMS_MQXXX_DEFAULT_TYPE);
     #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
       HMS_MQXXX(uint8_t pin = 0, HMS_MQXXX_Type type = HMS_MQXXX_DEFAULT_TYPE);
+    #elif defined(HMS_MQXXX_PLATFORM_HOST)
+      HMS_MQXXX(uint8_t pin = 0, HMS_MQXXX_Type type = HMS_MQXXX_DEFAULT_TYPE);
     #endif
 
     HMS_MQXXX_StatusTypeDef init();
     HMS_MQXXX_StatusTypeDef update();
+    HMS_MQXXX_StatusTypeDef updateCalibration();                            // update() without the warm-up sample
     float readSensor(float correctionFactor = 0.0);
     float setRatioAndGetPPM(float ratioValue);
+    HMS_MQXXX_Reading processVoltage(float voltage, float correctionFactor = 0.0);
+    void observeVoltage(float voltage);
+    HMS_MQXXX_Reading convertVoltage(float voltage, float correctionFactor = 0.0, uint32_t timestamp = 0) const;
+    float codeToVoltage(float code) const                   { return code * adcScale + adcOffset; }   // Averaged raw code to volts
+    float ratioToPPM(float ratioValue, uint8_t *flags = NULL) const;
+    uint8_t evaluateGases(float ratioValue, float *ppm, uint8_t maxCount, uint8_t *flags = NULL) const;
+    bool getLatestReading(HMS_MQXXX_Reading *reading) const;
+    void addListener(HMS_MQXXX_Listener *listener);                         // Not while a reading is being published
+    void removeListener(HMS_MQXXX_Listener *listener);
     float calibrate(float ratioInCleanAir, float correctionFactor = 0.0);
 
-    void setA(float value);
-    void setB(float value);
+    #if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+      // One async operation per sensor at a time; include HMS_MQXXX_Async.h to await them
+      void setExecutor(HMS_MQXXX_Executor *exec)            { executor = exec;            }
+      HMS_MQXXX_Executor *getExecutor() const               { return executor;            }
+      HMS_MQXXX_Task<float> readAsync(float correctionFactor = 0.0);
+      HMS_MQXXX_Task<float> calibrateAsync(float ratioInCleanAir, uint8_t samples = 1, uint32_t interval = HMS_MQXXX_ASYNC_CALIBRATION_INTERVAL, float correctionFactor = 0.0);
+    #endif
+
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      void setProfile(const HMS_MQXXX_Profile *shared);                    // NULL = built-in profile of the type
+      const HMS_MQXXX_Profile *getProfile() const           { return profile;             }
+    #else
+      void setA(float value);
+      void setB(float value);
+      HMS_MQXXX_StatusTypeDef applyCurveFit(const HMS_MQXXX_CurveFit &fit, float *residual = NULL);
+      void setRL(float value = 10)                          { rl = value;  readingValid = false; }
+      void setVCC(float value = 5)                          { vcc = value; readingValid = false; }
+      void setVoltResolution(float value = 5)               { voltageResolution = value; updateADCScale(); }
+      void setADCBitResolution(uint8_t bits);
+      void setRegressionMethod(HMS_MQXXX_Regression method) { regression = method; readingValid = false; }
+    #endif
     float setRsR0RatioGetPPM(float value);
 
-    void setR0(float value = 10)                            { r0 = value;                 }
-    void setRL(float value = 10)                            { rl = value;                 }
-    void setVCC(float value = 5)                            { vcc = value;                }
-    void setVoltResolution(float value = 5)                 { voltageResolution = value;  }
-    void setRegressionMethod(HMS_MQXXX_Regression method)   { regression = method;        }
+    void setR0(float value = 10)                            { r0 = value;  readingValid = false; }
+    void setADCCorrection(float offset, float gain);
+    HMS_MQXXX_StatusTypeDef calibrateADC();
+    #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+      void setADCChannel(uint32_t channel)                  { adcChannel = channel;       }
+    #endif
+    void setArbiter(HMS_MQXXX_Arbiter *shared, uint32_t channel);          // NULL detaches
+    #if defined(HMS_MQXXX_CYCLES_ENABLED)
+      void setCycleStats(HMS_MQXXX_CycleStats *stats)       { cycleStats = stats;         }   // NULL stops recording
+      HMS_MQXXX_CycleStats *getCycleStats() const           { return cycleStats;          }
+    #endif
+    #if defined(HMS_MQXXX_TRACE_ENABLED)
+      void setTraceId(uint8_t id)                           { traceId = id;               }   // Source of this sensor's trace records
+      uint8_t getTraceId() const                            { return traceId;             }
+    #endif
+    void setCacheMaxAge(uint32_t ms)                        { cacheMaxAge = ms;           }
+    uint32_t getCacheMaxAge() const                         { return cacheMaxAge;         }
+    void invalidateCache()                                  { voltageValid = false; readingValid = false; }
+
+    #if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+      HMS_MQXXX_StatusTypeDef saveCalibration(uint32_t timestamp = 0);
+      HMS_MQXXX_StatusTypeDef restoreCalibration(uint32_t now = 0, uint32_t maxAge = HMS_MQXXX_CALIBRATION_MAX_AGE);
+      void setStorageSlot(uint8_t slot)                     { storageSlot = slot;         }
+      uint8_t getStorageSlot() const                        { return storageSlot;         }
+      uint32_t getCalibrationTimestamp() const              { return calibrationTime;     }
+    #endif
+
+    #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+      void startWarmup();
+      uint32_t getWarmupETA() const;
+      HMS_MQXXX_WarmupState getWarmupState() const          { return (HMS_MQXXX_WarmupState)warmupState; }
+      bool isReady() const                                  { return warmupState == HMS_MQXXX_WARMUP_READY; }
+    #else
+      bool isReady() const                                  { return true;                }
+    #endif
+    uint8_t getReadingFlags() const;
+
+    #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+      void setEnvironment(float temperature, float humidity);
+      void setEnvironmentCallback(HMS_MQXXX_EnvironmentCallback callback, void *context = NULL) { envCallback = callback; envContext = context; }
+      float getTemperature() const                          { return envTemperature;      }
+      float getHumidity() const                             { return envHumidity;         }
+      float getCompensationFactor() const                   { return envFactor;           }
+    #endif
 
     float getRS();  
-    float getVoltage(bool read = true, bool injected = false, int value = 0);
+    float getVoltage(bool read = true, bool injected = false, int value = 0,
+                     HMS_MQXXX_StatusTypeDef *status = NULL);              // NAN and ERROR when no conversion succeeded
 
-    float getA() const                                      { return a;                   }
-    float getB() const                                      { return b;                   }
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      float getA() const                                    { return profile->a;          }
+      float getB() const                                    { return profile->b;          }
+      float getRL() const                                   { return profile->rl;         }
+      float getVCC() const                                  { return profile->vcc;        }
+      float getVoltResolution() const                       { return profile->voltageResolution; }
+      uint8_t getADCBitResolution() const                   { return profile->adcBitResolution;  }
+      float getADCGain() const                              { return adcScale * adcFullScale() / profile->voltageResolution; }
+      HMS_MQXXX_Type getType() const                        { return (HMS_MQXXX_Type)profile->type; }
+      HMS_MQXXX_Regression getRegressionMethod() const      { return (HMS_MQXXX_Regression)profile->regression; }
+    #else
+      float getA() const                                    { return a;                   }
+      float getB() const                                    { return b;                   }
+      float getRL() const                                   { return rl;                  }
+      float getVCC() const                                  { return vcc;                 }
+      float getVoltResolution() const                       { return voltageResolution;   }
+      uint8_t getADCBitResolution() const                   { return adcBitResolution;    }
+      float getADCGain() const                              { return adcGain;             }
+      HMS_MQXXX_Type getType() const                        { return type;                }
+      HMS_MQXXX_Regression getRegressionMethod() const      { return regression;          }
+    #endif
     float getR0() const                                     { return r0;                  }
-    float getRL() const                                     { return rl;                  }
     float getADC() const                                    { return adc;                 }
-    float getVCC() const                                    { return vcc;                 }
-    float getVoltResolution() const                         { return voltageResolution;   }
-    HMS_MQXXX_Type getType() const                          { return type;                }
-    HMS_MQXXX_Regression getRegressionMethod() const        { return regression;          }
+    float getADCOffset() const                              { return adcOffset;           }
+    float getADCScale() const                               { return adcScale;            }
 
   private:
     #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
-      float           voltageResolution   = 5.0;  
-      uint8_t         adcBitResolution    = 10;
       uint8_t         pin                 = A0;
     #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
-      float           voltageResolution   = 3.3;
-      uint8_t         adcBitResolution    = 12;
       const struct device *adc_dev        = NULL;
       uint8_t         pin                 = 0;
       uint8_t         channel             = 0;
-      int16_t         adc_raw             = 0;
-      int             ret                 = 0;
     #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
-      float           voltageResolution   = 3.3;
-      uint8_t         adcBitResolution    = 10;
       uint8_t         pin                 = 36;
+      adc_unit_t      adcUnit             = HMS_MQXXX_ESP_ADC_UNIT;         // Resolved from the GPIO by init()
+      adc_channel_t   adcChannel          = ADC_CHANNEL_0;
     #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
-      float             voltageResolution   = 3.3;  
-      uint8_t           adcBitResolution    = 12;
       ADC_HandleTypeDef *MQXXX_hadc;
+      uint32_t          adcChannel          = HMS_MQXXX_STM32_NO_CHANNEL;   // Sensor channel, needed to switch to VREFINT and back
+    #elif defined(HMS_MQXXX_PLATFORM_HOST)
+      uint8_t         pin                 = 0;
+    #endif
+
+    #if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+      uint8_t                   storageSlot         = 0;                    // Calibration record slot
+      uint32_t                  calibrationTime     = 0;                    // Timestamp of the active calibration
     #endif
             
-    bool                        firstFlag           = false;                // Flag for first initialization
-    float                       vcc                 = 5.0;                  // Sensor supply voltage
-    float                       rl                  = 10;                   // Load resistance in kilo ohms
-    float                       a;                                          // Coefficient a for the equation
-    float                       b;                                          // Coefficient b for the equation
-    float                       adc;                                        // Raw ADC value
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      const HMS_MQXXX_Profile   *profile;                                   // Shared curve, divider and ADC settings
+    #else
+      float                     voltageResolution   = HMS_MQXXX_ADC_VREF_DEFAULT;
+      float                     vcc                 = 5.0;                  // Sensor supply voltage
+      float                     rl                  = 10;                   // Load resistance in kilo ohms
+      float                     a;                                          // Coefficient a for the equation
+      float                     b;                                          // Coefficient b for the equation
+      float                     adcGain             = 1.0f;                 // Measured full scale / voltageResolution
+      HMS_MQXXX_Type            type;                                       // Sensor type
+      HMS_MQXXX_Regression      regression;                                 // Regression method
+      uint16_t                  retryInterval       = HMS_MQXXX_READ_INTERVAL;  // Retry interval in milliseconds
+      uint8_t                   retries             = HMS_MQXXX_READ_RETRIES;   // Number of read retries
+      uint8_t                   adcBitResolution    = HMS_MQXXX_ADC_BITS_DEFAULT;
+    #endif
     float                       r0;                                         // Sensor resistance in clean air
-    float                       ppm;                                        // Calculated ppm value
-    float                       rsAir;                                      // Sensor resistance in clean air
-    float                       ratio;                                      // Rs/R0 ratio
-    float                       rsCalc;                                     // Calculated sensor resistance
-    float                       sensorVolt;                                 // Sensor voltage
-    uint8_t                     retries             = 2;                    // Number of read retries
-    uint8_t                     retryInterval       = 20;                   // Retry interval in milliseconds
-    HMS_MQXXX_Type              type;                                       // Sensor type
-    HMS_MQXXX_Regression        regression;                                 // Regression method
+    #if !defined(HMS_MQXXX_COMPACT_ENABLED)
+      float                     sensorVolt;                                 // Last acquired voltage (acquisition task only)
+      float                     cachedCorrection    = 0;                    // correctionFactor cachedPPM was computed with
+      float                     cachedPPM           = 0;
+    #endif
+    uint32_t                    voltageTime         = 0;                    // mqMillis() when the cached voltage was acquired
+    uint32_t                    cacheMaxAge         = HMS_MQXXX_CACHE_MAX_AGE;  // Voltage reuse window (ms), 0 = always acquire
+    float                       adcOffset           = 0.0f;                 // Voltage at code 0
+    float                       adcScale            = 0.0f;                 // Volts per code including gain
+    #if defined(HMS_MQXXX_ADC_CALIBRATION_ENABLED) && (HMS_MQXXX_ADC_CALIBRATION_ENABLED == 1)
+      uint32_t                  adcCalTime          = 0;                    // Time of the last ADC calibration (ms)
+    #endif
+    HMS_MQXXX_Arbiter           *arbiter            = NULL;                 // Shared ADC, NULL = direct access
+    HMS_MQXXX_Listener          *listeners          = NULL;                 // Reading observers, newest first
+    uint32_t                    arbiterChannel      = 0;                    // Channel handed to the arbiter
+    #if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+      HMS_MQXXX_Executor        *executor           = NULL;                 // Resumes async reads, NULL = block in mqDelay()
+    #endif
+    #if defined(HMS_MQXXX_CYCLES_ENABLED)
+      HMS_MQXXX_CycleStats      *cycleStats         = NULL;                 // Stage latency histograms, NULL = not timed
+    #endif
+    uint16_t                    adc                 = 0;                    // Last raw ADC code
+    bool                        voltageValid        = false;                // The cached voltage is a real sample
+    bool                        readingValid        = false;                // The cached reading matches it and the configuration
+    #if defined(HMS_MQXXX_TRACE_ENABLED)
+      uint8_t                   traceId             = 0;
+    #endif
+
+    #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+      float                     envTemperature      = HMS_MQXXX_TEMP_BASELINE;      // Last ambient temperature (°C)
+      float                     envHumidity         = HMS_MQXXX_HUMIDITY_BASELINE;  // Last relative humidity (%RH)
+      float                     envFactor           = 1.0f;                 // Cached combined Rs factor for the above
+      HMS_MQXXX_EnvironmentCallback envCallback     = NULL;                 // Optional environment source
+      void                      *envContext         = NULL;
+    #endif
+
+    // Seqlock around the latest reading: odd sequence = write in progress, 0 = nothing published
+    HMS_MQXXX_SeqWord           latestSeq           = 0;
+    HMS_MQXXX_SeqWord           latestWords[sizeof(HMS_MQXXX_Snapshot) / sizeof(HMS_MQXXX_SeqWord)] = {};
+
+    #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+      uint8_t                   warmupState         = HMS_MQXXX_WARMUP_COLD;    // HMS_MQXXX_WarmupState
+      uint8_t                   warmupStable        = 0;                    // Consecutive flat samples
+      uint32_t                  warmupStart         = 0;                    // Power-on time (ms)
+      uint32_t                  warmupLast          = 0;                    // Time of the last tracked sample (ms)
+      uint32_t                  warmupInterval      = 0;                    // Smoothed sample interval (ms)
+      float                     warmupRs            = 0;                    // Smoothed Rs
+      float                     warmupSlope         = 0;                    // Smoothed relative Rs slope (1/s)
+      float                     warmupVariance      = 0;                    // Smoothed relative Rs variance
+      float                     warmupTau           = 0;                    // Estimated slope decay constant (s)
+    #endif
 
     void mqDelay(uint32_t ms);
-    void setDefaultValues();                                                // Helper function to set default sensor values
+    HMS_MQXXX_StatusTypeDef readADC(uint16_t *code);
+    uint32_t mqMillis();
+    void updateADCScale();
+    void applyADCGain(float gain);
+    float adcFullScale() const                              { return (float)((1UL << getADCBitResolution()) - 1); }
+    void publishReading(const HMS_MQXXX_Reading &reading);
+    void publishEvent(HMS_MQXXX_Event event, float value, float aux);
+    HMS_MQXXX_Reading finishReading(float voltage, float correctionFactor, uint32_t timestamp);
+    HMS_MQXXX_Reading failReading();
+    HMS_MQXXX_Reading convertReading(float voltage, float correctionFactor, uint32_t timestamp, bool timed) const;
+    bool voltageFresh();
+    void stampVoltage()                                     { voltageTime = mqMillis(); voltageValid = true; readingValid = false; }
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      // Compact builds cache only published samples: the voltage is read back from the reading snapshot
+      void keepVoltage(float voltage)                       { (void)voltage;              }
+      float cachedVoltage() const;
+    #else
+      void keepVoltage(float voltage)                       { sensorVolt = voltage; stampVoltage(); }
+      float cachedVoltage() const                           { return sensorVolt;          }
+    #endif
+    float sampleVoltage();
+    float calibrateVoltage(float voltage, float ratioInCleanAir, float correctionFactor);
+    #if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+      HMS_MQXXX_Task<float> acquireAsync();
+    #endif
+    float sensorSupply() const                              { return (getType() == HMS_MQXXX_MQ303A) ? getVCC() - 0.45f : getVCC(); }
+    void initCommon();                                                      // Shared tail of every platform init()
+    void setDefaultValues(HMS_MQXXX_Type sensorType);                       // Helper function to set default sensor values
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      uint8_t readRetries() const                           { return profile->retries;    }
+      uint16_t readInterval() const                         { return profile->retryInterval; }
+    #else
+      uint8_t readRetries() const                           { return retries;             }
+      uint16_t readInterval() const                         { return retryInterval;       }
+    #endif
+
+    #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+      void trackWarmup(float rs);
+    #endif
+
+    #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+      void pollEnvironment();
+    #endif
+
+    #if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+      HMS_MQXXX_StatusTypeDef storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record);
+      HMS_MQXXX_StatusTypeDef storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record);
+    #endif
 };
 
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+/*
+  Upper bound for sizeof(HMS_MQXXX) in compact builds, checked by a static_assert in the driver.
+  The figure is fixed per target and does not grow with the options: every feature (warm-up,
+  compensation, storage, ADC calibration, async, cycle stats, trace) enabled at once has to fit,
+  on every platform handle. As shipped that is 152 bytes with ESP-IDF on a 32-bit MCU (108 with
+  the defaults on Arduino) and 192 on 64-bit hosts. A change that adds state has to find the
+  room elsewhere; define it smaller to pin a target's own footprint.
+*/
+  #ifndef HMS_MQXXX_COMPACT_BUDGET
+    #define HMS_MQXXX_COMPACT_BUDGET  ((sizeof(void *) > 4) ? 192 : 152)
+  #endif
+#endif
+
 #endif // HMS_MQXXX_DRIVER_H
\ No newline at end of file
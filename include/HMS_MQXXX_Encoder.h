@@ -0,0 +1,79 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Encoder.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       CBOR / MessagePack encoding of MQXXX readings into caller buffers
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_ENCODER_H
+#define HMS_MQXXX_ENCODER_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#define HMS_MQXXX_REPORT_MAX_SIZE   160                                     // Any report, either encoding
+
+typedef enum {
+  HMS_MQXXX_ENCODING_CBOR     = 0,                                          // RFC 8949
+  HMS_MQXXX_ENCODING_MSGPACK  = 1
+} HMS_MQXXX_Encoding;
+
+/*
+  Everything the encoder writes, gathered from one reading by HMS_MQXXX_MakeReport(). Plain
+  data, so a report can also be built by hand (or replayed from a log) without a sensor.
+*/
+typedef struct {
+  uint32_t  timestamp;                                                      // Reading timestamp (ms)
+  float     ratio;
+  float     ppm;                                                            // Active curve
+  float     gasPPM[HMS_MQXXX_MAX_GASES];                                    // Per gas of the sensor's curve table
+  uint8_t   gas[HMS_MQXXX_MAX_GASES];                                       // HMS_MQXXX_Gas of each gasPPM entry
+  uint8_t   gasCount;
+  uint8_t   type;                                                           // HMS_MQXXX_Type
+  uint8_t   status;                                                         // HMS_MQXXX_StatusTypeDef
+  uint8_t   flags;                                                          // HMS_MQXXX_ReadingFlags
+} HMS_MQXXX_Report;
+
+/*
+  Encodes a report as one map, keys as text:
+    { "ts": uint, "type": uint, "status": uint, "flags": uint, "ratio": f32, "ppm": f32,
+      "gases": { "<gas name>": f32, ... } }                   "gases" only when gasCount > 0
+  Bytes go straight into the caller's buffer, no heap and no formatted strings; integers take
+  the shortest form and floats are always single precision, so the size depends only on the
+  integer values and the gas list. Returns the encoded length, or 0 if it does not fit (the
+  buffer contents are then unspecified). HMS_MQXXX_EncodedSize() is the same pass writing
+  nothing, for sizing buffers and frames up front.
+*/
+void HMS_MQXXX_MakeReport(const HMS_MQXXX &sensor, const HMS_MQXXX_Reading &reading, HMS_MQXXX_Report *report);
+size_t HMS_MQXXX_EncodeReport(const HMS_MQXXX_Report *report, HMS_MQXXX_Encoding encoding, uint8_t *buffer, size_t capacity);
+size_t HMS_MQXXX_EncodedSize(const HMS_MQXXX_Report *report, HMS_MQXXX_Encoding encoding);
+
+#endif // HMS_MQXXX_ENCODER_H
@@ -0,0 +1,186 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_FlashLog.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Wear-leveled ring log of MQXXX readings and events on raw flash
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_FLASHLOG_H
+#define HMS_MQXXX_FLASHLOG_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#if defined(HMS_MQXXX_PLATFORM_ESP_IDF) || (defined(HMS_MQXXX_PLATFORM_ARDUINO) && defined(ESP32))
+  #define HMS_MQXXX_FLASHLOG_ESP_PARTITION
+  #include "esp_partition.h"
+#endif
+
+typedef enum {
+  HMS_MQXXX_FLASHLOG_READING      = 0x01,                                   // value = ppm, aux = ratio, code = status
+  HMS_MQXXX_FLASHLOG_CALIBRATION  = 0x02,                                   // value = R0, aux = ratio in clean air
+  HMS_MQXXX_FLASHLOG_BOOT         = 0x03,                                   // Written by begin(), value = pages recovered
+  HMS_MQXXX_FLASHLOG_EVENT        = 0x04                                    // Application event from logEvent()
+} HMS_MQXXX_FlashLogKind;
+
+/*
+  One 24 byte record. Sequence numbers continue across reboots, so a gap in what a reader
+  returns means records were lost (torn page, or recycled by the ring).
+*/
+typedef struct {
+  uint32_t  sequence;                                                       // Record number, monotonic
+  uint32_t  timestamp;                                                      // Sensor clock (ms), 0 for boot records
+  float     value;
+  float     aux;
+  uint8_t   kind;                                                           // HMS_MQXXX_FlashLogKind
+  uint8_t   source;                                                         // Id given to attach(), or the caller's
+  uint8_t   code;                                                           // Reading status or event code
+  uint8_t   flags;                                                          // HMS_MQXXX_ReadingFlags of a reading
+  uint32_t  crc;                                                            // CRC-32 of the fields above
+} HMS_MQXXX_FlashLogRecord;
+
+/*
+  Append-only ring of erase sectors, each split into pages of HMS_MQXXX_FLASHLOG_PAGE_SIZE:
+    page      16 byte header (magic, page sequence, record count, CRC) + records
+    sector    pages written in order; page 0's sequence orders the sectors
+    ring      when the newest sector is full the next one (the oldest) is erased and reused
+  Records collect in a RAM page and are programmed in one write when it fills, on flush(), or
+  right away for calibrations. Each page is programmed once, each sector erased once per trip
+  around the ring, so wear is even. Most readings cost RAM time only; the one that fills the
+  page (every RECORDS_PER_PAGE-th) programs it from the listener, one page write and no erase.
+
+  Erases (milliseconds to seconds, CPU stalled on internal flash) never run from the reading
+  listener. maintain() erases the next sector ahead of time when the head is nearly full; call
+  it between readings from the task that reads the sensor, since it shares the RAM page with
+  the listener. If it falls behind, records wait in the RAM page and, once that is full too,
+  are dropped and counted (getDroppedCount()).
+
+  begin() locates the newest sector from page 0 headers, then walks that sector's page headers
+  to the first erased one; nothing else is read. A torn page (power lost mid-program) fails
+  its CRC and is skipped, as is a record with a bad CRC.
+
+  attach() logs every reading the sensor publishes and every calibrate(). Single writer, like
+  HMS_MQXXX_History: use the log (and its readers, maintain() and flush()) from the one task
+  whose readSensor() calls run the listener; nothing here is locked.
+*/
+class HMS_MQXXX_FlashLog {
+  public:
+    HMS_MQXXX_FlashLog();
+    ~HMS_MQXXX_FlashLog()                                   { detach();                   }
+    HMS_MQXXX_FlashLog(const HMS_MQXXX_FlashLog &) = delete;
+    HMS_MQXXX_FlashLog &operator=(const HMS_MQXXX_FlashLog &) = delete;
+
+    HMS_MQXXX_StatusTypeDef begin();                                        // NOT_FOUND without a backend/partition
+    void attach(HMS_MQXXX *source, uint8_t id = 0);
+    void detach();
+
+    HMS_MQXXX_StatusTypeDef append(HMS_MQXXX_FlashLogKind kind, uint32_t timestamp, float value, float aux = 0,
+                                   uint8_t source = 0, uint8_t code = 0, uint8_t flags = 0);
+    HMS_MQXXX_StatusTypeDef logEvent(uint8_t code, uint32_t timestamp, float value = 0, float aux = 0);
+    HMS_MQXXX_StatusTypeDef flush();                                        // Program the pending records now
+    HMS_MQXXX_StatusTypeDef maintain();                                     // Erase ahead, on the sensor's task between readings
+    HMS_MQXXX_StatusTypeDef erase();                                        // Wipe every sector, sequences restart at 0
+
+    bool isReady() const                                    { return ready;               }
+    uint32_t getNextSequence() const                        { return recordSequence;      }
+    uint16_t getPendingCount() const                        { return pending;             }
+    uint32_t getEraseCount() const                          { return erases;              }   // Sector erases since begin()
+    uint32_t getDroppedCount() const                        { return dropped;             }   // Records lost waiting for maintain()
+    uint32_t getCapacity() const;                                           // Records the ring holds
+
+  private:
+    friend class HMS_MQXXX_FlashLogReader;
+
+    typedef struct {
+      uint32_t                  magic;                                      // HMS_MQXXX_FLASHLOG_MAGIC
+      uint32_t                  sequence;                                   // Page number, monotonic
+      uint16_t                  count;                                      // Records in the page
+      uint16_t                  reserved;
+      uint32_t                  crc;                                        // CRC-32 of the fields above
+    } PageHeader;
+
+    enum {
+      PAGES_PER_SECTOR  = HMS_MQXXX_FLASHLOG_SECTOR_SIZE / HMS_MQXXX_FLASHLOG_PAGE_SIZE,
+      RECORDS_PER_PAGE  = (HMS_MQXXX_FLASHLOG_PAGE_SIZE - sizeof(PageHeader)) / sizeof(HMS_MQXXX_FlashLogRecord)
+    };
+    typedef enum { PAGE_ERASED, PAGE_VALID, PAGE_CORRUPT } PageState;
+
+    uint8_t                     page[HMS_MQXXX_FLASHLOG_PAGE_SIZE];         // Header + pending records
+    bool                        ready               = false;
+    bool                        spare               = false;                // Sector after the head is erased
+    uint8_t                     sourceId            = 0;
+    uint16_t                    pending             = 0;                    // Records in the RAM page
+    uint16_t                    sectors             = 0;
+    uint16_t                    head                = 0;                    // Newest sector
+    uint32_t                    pageIndex           = 0;                    // Next free page in the head sector
+    uint32_t                    pageSequence        = 0;
+    uint32_t                    recordSequence      = 0;
+    uint32_t                    erases              = 0;
+    uint32_t                    dropped             = 0;
+    HMS_MQXXX                   *sensor             = NULL;
+    HMS_MQXXX_Listener          listener;
+    #if defined(HMS_MQXXX_FLASHLOG_ESP_PARTITION)
+    const esp_partition_t       *partition          = NULL;
+    #endif
+
+    PageState readHeader(uint16_t sector, uint32_t index, PageHeader *header);
+    uint32_t pageOffset(uint16_t sector, uint32_t index) const { return (uint32_t)sector * HMS_MQXXX_FLASHLOG_SECTOR_SIZE + index * HMS_MQXXX_FLASHLOG_PAGE_SIZE; }
+    HMS_MQXXX_StatusTypeDef flashOpen();                                    // Sets sectors
+    HMS_MQXXX_StatusTypeDef flashRead(uint32_t offset, void *data, size_t length);
+    HMS_MQXXX_StatusTypeDef flashWrite(uint32_t offset, const void *data, size_t length);
+    HMS_MQXXX_StatusTypeDef flashErase(uint16_t sector);
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+    static void onEvent(HMS_MQXXX_Event event, uint32_t timestamp, float value, float aux, void *context);
+};
+
+/*
+  Reads the flushed records back, oldest first, straight from flash (a record at a time, no
+  page buffer). next() skips torn pages and records that fail their CRC (see getSkippedCount()).
+*/
+class HMS_MQXXX_FlashLogReader {
+  public:
+    explicit HMS_MQXXX_FlashLogReader(HMS_MQXXX_FlashLog &source) : log(source) { rewind(); }
+
+    void rewind();
+    bool next(HMS_MQXXX_FlashLogRecord *record);
+    uint32_t getSkippedCount() const                        { return skipped;             }
+
+  private:
+    HMS_MQXXX_FlashLog          &log;
+    uint16_t                    sector              = 0;
+    uint16_t                    sectorsLeft         = 0;
+    uint32_t                    page                = 0;                    // Next page header to read
+    uint16_t                    index               = 0;                    // Next record in the current page
+    uint16_t                    count               = 0;                    // Records in the current page
+    uint32_t                    skipped             = 0;
+};
+
+#endif // HMS_MQXXX_FLASHLOG_H
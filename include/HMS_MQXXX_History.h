@@ -0,0 +1,146 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_History.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Gorilla-compressed in-RAM history of MQXXX readings
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_HISTORY_H
+#define HMS_MQXXX_HISTORY_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+/*
+  Recent (timestamp, value) history in a fixed ring of compressed blocks, Gorilla style:
+    timestamps  delta-of-delta against the previous interval
+                  '0'                 same interval
+                  '10'   +  3 bits    -4 .. 3 ms (scheduling jitter)
+                  '110'  +  7 bits    -64 .. 63 ms
+                  '1110' + 12 bits    -2048 .. 2047 ms
+                  '1111' + 32 bits    anything else
+    values      XOR with the previous float
+                  '0'                 unchanged
+                  '10'   + n bits     meaningful bits fit the previous leading/trailing window
+                  '11'   + 5 + 5 + n  new window: leading zeros, length - 1, meaningful bits
+  A block holds its first timestamp in the header and is sealed as soon as the next sample
+  does not fit; the oldest block is recycled when the ring is full. setQuantum() rounds values
+  to a power-of-two step so ADC noise stops reaching the low mantissa bits (lossy, error at
+  most half a step). A simulated 1 Hz MQ-2 with +-1 code noise and 0-1 ms period jitter costs
+  about 21 bits per sample lossless (3x against 64 raw bits) and 8 bits with setQuantum(0.1)
+  (8x); on a jitter-free schedule 5 bits (13x).
+
+  attach() records every HMS_MQXXX_OK reading the sensor publishes (ppm of the active curve)
+  through a listener; append() feeds any other series. Single writer: read the history back
+  from the writing task, or while the writer is stopped.
+*/
+class HMS_MQXXX_History {
+  public:
+    HMS_MQXXX_History();
+    ~HMS_MQXXX_History()                                    { detach();                   }
+    HMS_MQXXX_History(const HMS_MQXXX_History &) = delete;
+    HMS_MQXXX_History &operator=(const HMS_MQXXX_History &) = delete;
+
+    void attach(HMS_MQXXX *source);
+    void detach();
+    HMS_MQXXX_StatusTypeDef append(uint32_t timestamp, float value);
+    void clear();
+    void setQuantum(float step);                                            // 0 = lossless (default)
+
+    uint32_t getSampleCount() const                         { return samples;             }
+    uint32_t getEncodedBytes() const;                                       // Compressed payload currently held
+    uint32_t getDroppedCount() const                        { return dropped;             }   // Samples lost to recycled blocks
+    size_t getCapacity() const                              { return sizeof(blocks);      }
+
+  private:
+    friend class HMS_MQXXX_HistoryReader;
+
+    typedef struct {
+      uint32_t                  firstTimestamp;
+      uint16_t                  generation;                                 // Bumped on reuse, readers detect overwrites
+      uint16_t                  count;                                      // Samples in the block
+      uint16_t                  bits;                                       // Bits used in data
+      uint8_t                   data[HMS_MQXXX_HISTORY_BLOCK_SIZE];
+    } Block;
+
+    Block                       blocks[HMS_MQXXX_HISTORY_BLOCKS];
+    uint8_t                     oldest              = 0;
+    uint8_t                     current             = 0;
+    uint8_t                     used                = 0;                    // Blocks holding samples
+    uint8_t                     prevLeading         = 0xFF;                 // XOR window, 0xFF = none yet
+    uint8_t                     prevTrailing        = 0;
+    int8_t                      quantumExponent     = 0;
+    bool                        quantized           = false;
+    uint32_t                    prevTimestamp       = 0;
+    int32_t                     prevDelta           = 0;
+    uint32_t                    prevValue           = 0;                    // Float bits
+    uint32_t                    samples             = 0;
+    uint32_t                    dropped             = 0;
+    HMS_MQXXX                   *sensor             = NULL;
+    HMS_MQXXX_Listener          listener;
+
+    bool encode(Block &block, uint32_t timestamp, uint32_t value);
+    void openBlock(uint32_t timestamp);
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+};
+
+/*
+  Streaming decoder, oldest sample first. Holds only the decoder state of one block, so a
+  reader costs a few dozen bytes whatever the history size. next() returns false at the end,
+  or if the writer recycled the block being read (see isOverrun()).
+*/
+class HMS_MQXXX_HistoryReader {
+  public:
+    explicit HMS_MQXXX_HistoryReader(const HMS_MQXXX_History &source) : history(source) { rewind(); }
+
+    void rewind();
+    bool next(uint32_t *timestamp, float *value);
+    bool isOverrun() const                                  { return overrun;             }
+
+  private:
+    const HMS_MQXXX_History     &history;
+    uint8_t                     block               = 0;
+    uint8_t                     blocksLeft          = 0;
+    uint8_t                     leading             = 0;
+    uint8_t                     trailing            = 0;
+    bool                        overrun             = false;
+    uint16_t                    generation          = 0;
+    uint16_t                    index               = 0;                    // Samples decoded from the block
+    uint16_t                    pos                 = 0;                    // Bit position in the block
+    uint32_t                    timestamp           = 0;
+    int32_t                     delta               = 0;
+    uint32_t                    value               = 0;
+
+    bool enterBlock();
+    uint32_t readBits(const uint8_t *data, uint8_t count);
+};
+
+#endif // HMS_MQXXX_HISTORY_H
@@ -0,0 +1,153 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Modbus.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Modbus RTU/TCP slave register map of an MQXXX sensor
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_MODBUS_H
+#define HMS_MQXXX_MODBUS_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#define HMS_MQXXX_MODBUS_RTU_MAX        256                                 // Largest RTU frame (address + PDU + CRC)
+#define HMS_MQXXX_MODBUS_TCP_MAX        260                                 // Largest TCP ADU (MBAP + PDU)
+#define HMS_MQXXX_MODBUS_MBAP_SIZE      7
+#define HMS_MQXXX_MODBUS_NOT_CALIBRATED 0xFFFFFFFFUL                        // Calibration age before any calibrate()
+
+/*
+  Input registers (function 04), refreshed on every published reading. 32-bit values take
+  two registers, high word first; floats are IEEE 754 (ABCD order).
+*/
+typedef enum {
+  HMS_MQXXX_MODBUS_IR_STATUS      = 0,                                      // HMS_MQXXX_StatusTypeDef, NOT_FOUND before the first reading
+  HMS_MQXXX_MODBUS_IR_FLAGS       = 1,                                      // HMS_MQXXX_ReadingFlags
+  HMS_MQXXX_MODBUS_IR_TYPE        = 2,                                      // HMS_MQXXX_Type
+  HMS_MQXXX_MODBUS_IR_GAS_COUNT   = 3,                                      // Valid entries in the per-gas block
+  HMS_MQXXX_MODBUS_IR_TIMESTAMP   = 4,                                      // u32, reading timestamp (ms)
+  HMS_MQXXX_MODBUS_IR_PPM         = 6,                                      // f32, active curve
+  HMS_MQXXX_MODBUS_IR_RATIO       = 8,                                      // f32
+  HMS_MQXXX_MODBUS_IR_VOLTAGE     = 10,                                     // f32
+  HMS_MQXXX_MODBUS_IR_RS          = 12,                                     // f32 (kOhm)
+  HMS_MQXXX_MODBUS_IR_R0          = 14,                                     // f32 (kOhm)
+  HMS_MQXXX_MODBUS_IR_CAL_AGE     = 16,                                     // u32, s from last calibration to the reading
+  HMS_MQXXX_MODBUS_IR_CAL_RESULT  = 18,                                     // Status of the last Modbus calibration, 0xFFFF = none
+  HMS_MQXXX_MODBUS_IR_SEQUENCE    = 19,                                     // Readings published, wraps at 0xFFFF
+  HMS_MQXXX_MODBUS_IR_GAS_PPM     = 20,                                     // f32 per gas, NAN past the gas count
+  HMS_MQXXX_MODBUS_IR_GAS_ID      = 20 + 2 * HMS_MQXXX_MAX_GASES,           // HMS_MQXXX_Gas per gas, 0xFFFF past the gas count
+  HMS_MQXXX_MODBUS_IR_COUNT       = 20 + 3 * HMS_MQXXX_MAX_GASES
+} HMS_MQXXX_ModbusInput;
+
+// Holding registers (03/06/16) and coils (01/05)
+typedef enum {
+  HMS_MQXXX_MODBUS_HR_CLEAN_AIR   = 0,                                      // f32, ratio calibrate() is given, default of the type
+  HMS_MQXXX_MODBUS_HR_COMMAND     = 2,                                      // Write 1 = calibrate, 0 = cancel; reads 1 while pending
+  HMS_MQXXX_MODBUS_HR_COUNT       = 3
+} HMS_MQXXX_ModbusHolding;
+
+typedef enum {
+  HMS_MQXXX_MODBUS_COIL_CALIBRATE = 0,                                      // ON = calibrate, OFF = cancel; reads ON while pending
+  HMS_MQXXX_MODBUS_COIL_COUNT     = 1
+} HMS_MQXXX_ModbusCoil;
+
+typedef enum {
+  HMS_MQXXX_MODBUS_ILLEGAL_FUNCTION = 0x01,
+  HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS  = 0x02,
+  HMS_MQXXX_MODBUS_ILLEGAL_VALUE    = 0x03,
+  HMS_MQXXX_MODBUS_DEVICE_BUSY      = 0x06
+} HMS_MQXXX_ModbusException;
+
+/*
+  Modbus slave for one sensor. The register image is built in the publishing task when a
+  reading arrives (per-gas ppm included), so answering a request is a bounded copy out of
+  it: no ADC access, no curve math, no blocking. The image is guarded by a seqlock like
+  getLatestReading(); a request that keeps overlapping an update gets exception 06 and the
+  master retries.
+
+  Writes never run the sensor from the bus handler. A calibrate request (coil 0 or the
+  command register) only marks itself pending; service(), called from the task that owns the
+  sensor, runs calibrate() with the clean-air ratio in HR0-1 and reports the outcome in
+  IR18. processPDU()/processRTU()/processTCP() may be called from the UART or socket task.
+
+  Transport is the caller's: processRTU() takes one frame delimited by the 3.5 character gap,
+  processTCP() one ADU whose length matches its MBAP header. Both return the number of
+  response bytes, 0 when nothing must be sent (other address, bad CRC, broadcast).
+*/
+class HMS_MQXXX_Modbus {
+  public:
+    explicit HMS_MQXXX_Modbus(uint8_t address = HMS_MQXXX_MODBUS_ADDRESS);
+    ~HMS_MQXXX_Modbus();
+    HMS_MQXXX_Modbus(const HMS_MQXXX_Modbus &) = delete;
+    HMS_MQXXX_Modbus &operator=(const HMS_MQXXX_Modbus &) = delete;
+
+    void attach(HMS_MQXXX *source);
+    void detach();
+    void setAddress(uint8_t address)                        { slaveAddress = address;     }
+    uint8_t getAddress() const                              { return slaveAddress;        }
+
+    size_t processPDU(const uint8_t *request, size_t length, uint8_t *response, size_t capacity);
+    size_t processRTU(const uint8_t *frame, size_t length, uint8_t *response, size_t capacity);
+    size_t processTCP(const uint8_t *adu, size_t length, uint8_t *response, size_t capacity);
+    HMS_MQXXX_StatusTypeDef service();                                      // NOT_FOUND when nothing was pending
+
+    bool readInputs(uint16_t start, uint16_t count, uint16_t *out) const;  // Same snapshot the bus sees
+    uint32_t getRequestCount() const                        { return requests;            }
+    uint32_t getExceptionCount() const                      { return exceptions;          }
+
+    static uint16_t crc16(const uint8_t *data, size_t length);
+
+  private:
+    HMS_MQXXX_Listener          listener;
+    HMS_MQXXX                   *sensor             = NULL;
+    uint8_t                     slaveAddress;
+    HMS_MQXXX_SeqWord           imageSeq            = 0;
+    uint16_t                    image[HMS_MQXXX_MODBUS_IR_COUNT];
+    uint16_t                    cleanAir[2];                                // HR0-1, written by the bus only
+    uint8_t                     pending             = 0;                    // Calibrate request, bus -> service()
+    uint16_t                    sequence            = 0;
+    uint16_t                    calResult           = 0xFFFF;
+    bool                        calibrated          = false;
+    uint32_t                    calibratedAt        = 0;
+    uint32_t                    requests            = 0;
+    uint32_t                    exceptions          = 0;
+
+    void beginUpdate();
+    void endUpdate();
+    void putWord(uint8_t reg, uint16_t value);
+    void putLong(uint8_t reg, uint32_t value);
+    void putFloat(uint8_t reg, float value);
+    size_t exception(uint8_t function, uint8_t code, uint8_t *response);
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+    static void onEvent(HMS_MQXXX_Event event, uint32_t timestamp, float value, float aux, void *context);
+};
+
+#endif // HMS_MQXXX_MODBUS_H
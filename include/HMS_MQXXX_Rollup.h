@@ -0,0 +1,115 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Rollup.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Fixed-RAM min/max/mean rollups of MQXXX readings per gas
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_ROLLUP_H
+#define HMS_MQXXX_ROLLUP_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+typedef struct {
+  float     min;                                                            // NAN when count is 0
+  float     max;
+  float     mean;
+  uint32_t  count;                                                          // Samples aggregated
+} HMS_MQXXX_RollupStats;
+
+/*
+  Hierarchical aggregates over a fixed set of levels (as shipped: 60 one-minute, 24 one-hour
+  and 30 one-day buckets). Every level is a circular array of buckets per gas; a sample lands
+  in the current bucket of each level, so an update is O(levels) per gas and the RAM cost is
+  fixed at compile time. Moving into a new period recycles the oldest bucket; a gap longer
+  than a level's window just clears that level. Means are running means with a Kahan
+  compensation term: a plain float running mean stops moving once count is large (a day of
+  1 s readings is 86400 samples), the compensated one stays within float rounding of the
+  exact mean, and unlike a sum it cannot overflow on saturated FLT_MAX readings.
+
+  Timestamps are the sensor clock (ms) and must not go backwards; only differences are used,
+  so the 49.7 day millis() wrap is harmless. Buckets are aligned to the first sample, not to
+  wall-clock minutes.
+
+  attach() turns every HMS_MQXXX_OK reading into one ppm per gas of the sensor's curve table
+  (evaluateGases() on the reading's ratio); a sensor without a table rolls up the active curve
+  as gas index 0. Single writer: query from the writing task, or while the writer is stopped.
+*/
+class HMS_MQXXX_Rollup {
+  public:
+    HMS_MQXXX_Rollup();
+    ~HMS_MQXXX_Rollup()                                     { detach();                   }
+    HMS_MQXXX_Rollup(const HMS_MQXXX_Rollup &) = delete;
+    HMS_MQXXX_Rollup &operator=(const HMS_MQXXX_Rollup &) = delete;
+
+    void attach(HMS_MQXXX *source);
+    void detach();
+    void append(uint32_t timestamp, const float *values, uint8_t count);    // One value per gas index, NAN skips it
+    void clear();
+
+    uint8_t getGasCount() const                             { return gasCount;            }
+    HMS_MQXXX_Gas getGas(uint8_t index) const;                              // HMS_MQXXX_GAS_COUNT = active curve
+    uint8_t getLevelCount() const                           { return HMS_MQXXX_ROLLUP_LEVELS; }
+    uint16_t getSlotCount(uint8_t level) const;
+    uint32_t getPeriod(uint8_t level) const;                                // ms per bucket
+
+    bool getBucket(uint8_t level, uint8_t gas, uint16_t age, HMS_MQXXX_RollupStats *stats, uint32_t *start = NULL) const;   // age 0 = current
+    bool getWindow(uint8_t level, uint8_t gas, HMS_MQXXX_RollupStats *stats) const;     // Every bucket of the level
+
+  private:
+    typedef struct {
+      float                     min;
+      float                     max;
+      float                     mean;
+      float                     carry;                                      // Kahan compensation of mean
+      uint32_t                  count;
+    } Bucket;
+
+    typedef struct {
+      uint32_t                  start;                                      // Timestamp the current bucket began
+      uint16_t                  current;                                    // Slot of the current bucket
+      uint16_t                  filled;                                     // Buckets in use (up to the slot count)
+    } Level;
+
+    Bucket                      buckets[HMS_MQXXX_ROLLUP_GASES][HMS_MQXXX_ROLLUP_TOTAL_SLOTS];
+    Level                       levels[HMS_MQXXX_ROLLUP_LEVELS];
+    uint8_t                     gases[HMS_MQXXX_ROLLUP_GASES];              // HMS_MQXXX_Gas per index
+    uint8_t                     gasCount            = 0;
+    bool                        started             = false;
+    HMS_MQXXX                   *sensor             = NULL;
+    HMS_MQXXX_Listener          listener;
+
+    void advance(uint8_t level, uint32_t timestamp);
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+};
+
+#endif // HMS_MQXXX_ROLLUP_H
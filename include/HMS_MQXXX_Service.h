@@ -0,0 +1,151 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Service.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       FreeRTOS acquisition task sampling registered MQXXX sensors
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_SERVICE_H
+#define HMS_MQXXX_SERVICE_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#if defined(HMS_MQXXX_PLATFORM_ESP_IDF) || (defined(HMS_MQXXX_SERVICE_FREERTOS) && (HMS_MQXXX_SERVICE_FREERTOS == 1))
+#define HMS_MQXXX_SERVICE_AVAILABLE
+
+#if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #include "freertos/FreeRTOS.h"
+  #include "freertos/task.h"
+  #include "freertos/queue.h"
+  #include "freertos/semphr.h"
+#else
+  #include "FreeRTOS.h"
+  #include "task.h"
+  #include "queue.h"
+  #include "semphr.h"
+#endif
+
+#if defined(HMS_MQXXX_NO_HEAP) && (HMS_MQXXX_NO_HEAP == 1)
+  #if !defined(configSUPPORT_STATIC_ALLOCATION) || (configSUPPORT_STATIC_ALLOCATION != 1)
+    #error "HMS_MQXXX_NO_HEAP needs configSUPPORT_STATIC_ALLOCATION = 1 (or build with HMS_MQXXX_NO_HEAP = 0)"
+  #endif
+  #define HMS_MQXXX_SERVICE_STATIC_TASK                                     // Task created once in place, parked by stop()
+#endif
+
+/*
+  Driver-owned acquisition task. It samples every registered sensor once per period, so the
+  blocking retry loop in getVoltage() only ever runs on the service task (pinned to one core on
+  ESP-IDF). Consumers never touch the ADC, they pick readings up through:
+    - getReading()        latest seqlock snapshot of a sensor, lock-free
+    - task notifications  bit (1 << index) of every sensor sampled this cycle, eSetBits
+    - getQueue()          HMS_MQXXX_ServiceReading items in preallocated slots, oldest dropped
+  Sensors and consumers are registered before start(); the service stores pointers only. The
+  service is the single seqlock writer of its sensors, so nothing else may call readSensor() on
+  them while it runs.
+
+  With HMS_MQXXX_NO_HEAP the task control block and stack live inside the service object. The
+  task is created by the first start() and parked (not deleted) by stop(); a later start()
+  wakes it with the new period and priority, the core it was pinned to stays.
+
+  The task signals a semaphore as it leaves run(). A restart and the destructor wait for that,
+  at most HMS_MQXXX_SERVICE_STOP_TIMEOUT, instead of polling; the destructor must not run on the
+  service task itself (a consumer callback, say), which would wait on its own exit.
+
+  On Linux the service runs on the FreeRTOS POSIX port: build for the host platform with
+  HMS_MQXXX_SERVICE_FREERTOS = 1 and route the host delay hook to vTaskDelay(). The host test
+  (HMS_MQXXX_ServiceTest) does the same on the thread-backed shim in tests/freertos.
+*/
+typedef struct {
+  uint8_t             index;                                                // Registration index of the sensor
+  HMS_MQXXX_Reading   reading;
+} HMS_MQXXX_ServiceReading;
+
+class HMS_MQXXX_Service {
+  public:
+    HMS_MQXXX_Service();
+    ~HMS_MQXXX_Service();
+    HMS_MQXXX_Service(const HMS_MQXXX_Service &) = delete;
+    HMS_MQXXX_Service &operator=(const HMS_MQXXX_Service &) = delete;
+
+    HMS_MQXXX_StatusTypeDef addSensor(HMS_MQXXX *sensor, uint8_t *index = NULL);
+    HMS_MQXXX_StatusTypeDef addConsumer(TaskHandle_t task);
+
+    HMS_MQXXX_StatusTypeDef start(uint32_t periodMs = HMS_MQXXX_SERVICE_PERIOD,
+                                  UBaseType_t priority = HMS_MQXXX_SERVICE_PRIORITY,
+                                  BaseType_t core = HMS_MQXXX_SERVICE_CORE);
+    void stop();
+    void trigger();                                                         // Sample now instead of at the next period
+
+    bool getReading(uint8_t index, HMS_MQXXX_Reading *reading) const;
+
+    bool isRunning() const                                  { return task != NULL;        }
+    uint8_t getSensorCount() const                          { return sensorCount;         }
+    uint32_t getCycleCount() const                          { return cycles;              }
+    uint32_t getDroppedCount() const                        { return dropped;             }
+    QueueHandle_t getQueue() const                          { return queue;               }
+
+  private:
+    HMS_MQXXX                   *sensors[HMS_MQXXX_SERVICE_MAX_SENSORS];
+    TaskHandle_t                consumers[HMS_MQXXX_SERVICE_MAX_CONSUMERS];
+    uint8_t                     sensorCount         = 0;
+    uint8_t                     consumerCount       = 0;
+    volatile bool               running             = false;                // Cleared by stop(), task exits on its own
+    TaskHandle_t volatile       task                = NULL;
+    TickType_t                  period              = 0;
+    volatile uint32_t           cycles              = 0;                    // Completed sampling cycles
+    volatile uint32_t           dropped             = 0;                    // Queue items overwritten before consumption
+    QueueHandle_t               queue               = NULL;
+    SemaphoreHandle_t           exited              = NULL;                 // Given by run() as the task's last act
+    bool                        awaitingExit        = false;                // A started run() has not been waited for
+
+    #if (HMS_MQXXX_SERVICE_QUEUE_DEPTH > 0) && defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+      StaticQueue_t             queueControl;
+      uint8_t                   queueStorage[HMS_MQXXX_SERVICE_QUEUE_DEPTH * sizeof(HMS_MQXXX_ServiceReading)];
+    #endif
+    #if defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+      StaticSemaphore_t         exitedControl;
+    #endif
+    #if defined(HMS_MQXXX_SERVICE_STATIC_TASK)
+      TaskHandle_t              parkedTask          = NULL;                 // Created once, reused by every start()
+      StaticTask_t              taskControl;
+      StackType_t               taskStack[HMS_MQXXX_SERVICE_STACK_DEPTH];
+    #endif
+
+    static void taskEntry(void *arg);
+    void run();
+    void sampleAll();
+    bool waitExit();
+};
+
+#endif // HMS_MQXXX_SERVICE_AVAILABLE
+
+#endif // HMS_MQXXX_SERVICE_H
@@ -0,0 +1,160 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Telemetry.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Batched, delta-coded telemetry frames of MQXXX readings
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_TELEMETRY_H
+#define HMS_MQXXX_TELEMETRY_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#define HMS_MQXXX_TELEMETRY_VERSION     1
+#define HMS_MQXXX_TELEMETRY_URGENT      0x80                                // Header bit: frame sent early for an alarm
+#define HMS_MQXXX_TELEMETRY_BASE        0x80                                // Record bit: full values, base for its source
+#define HMS_MQXXX_TELEMETRY_HEADER_SIZE 8
+#define HMS_MQXXX_TELEMETRY_RECORD_MAX  17                                  // Largest record of either form
+
+typedef HMS_MQXXX_StatusTypeDef (*HMS_MQXXX_FrameSink)(const uint8_t *frame, size_t length, void *context);
+
+typedef struct {
+  uint32_t  timestamp;                                                      // Reading timestamp (ms)
+  float     ppm;
+  float     ratio;
+  uint8_t   source;                                                         // Id given to attach(), 0..127
+  uint8_t   status;                                                         // HMS_MQXXX_StatusTypeDef (low nibble)
+  uint8_t   flags;                                                          // HMS_MQXXX_ReadingFlags (low nibble)
+} HMS_MQXXX_TelemetryRecord;
+
+/*
+  Collects readings from up to HMS_MQXXX_TELEMETRY_SOURCES sensors into one frame, so the
+  radio wakes once per frame instead of once per reading. Frame layout (little-endian):
+    header    version | URGENT, record count, frame sequence (u16), first timestamp (u32)
+    record    source | BASE, status | flags << 4, timestamp - previous timestamp (varint)
+    BASE      ppm (f32), ratio (f32)             first record of its source in the frame
+    otherwise ppm bits - base ppm bits, ratio bits - base ratio bits (varints)
+  Varints are zigzag LEB128. Differences of float bit patterns are lossless and stay small
+  while a sensor's values stay close: a noisy 10 s series costs about 9 bytes a record after
+  its base. Two sensors fill a 51 byte frame with 4 readings, a 242 byte one with 24.
+
+  A frame is handed to the sink when the next record does not fit, when its first record
+  is older than the max age (on add() or poll()), or on flush(). A reading at or above its
+  source's alarm threshold is not left waiting: it is appended and the frame goes at once,
+  marked URGENT, so pending readings share that wakeup. If the sink fails the batch is
+  kept for the next attempt; once a new record no longer fits it is dropped and counted.
+*/
+class HMS_MQXXX_Telemetry {
+  public:
+    explicit HMS_MQXXX_Telemetry(HMS_MQXXX_FrameSink sink, void *context = NULL);
+    ~HMS_MQXXX_Telemetry();
+    HMS_MQXXX_Telemetry(const HMS_MQXXX_Telemetry &) = delete;
+    HMS_MQXXX_Telemetry &operator=(const HMS_MQXXX_Telemetry &) = delete;
+
+    HMS_MQXXX_StatusTypeDef attach(HMS_MQXXX *sensor, uint8_t id);          // ERROR when every source slot is taken
+    void detach(HMS_MQXXX *sensor);
+    void setAlarmThreshold(uint8_t id, float ppm);                          // NAN (default) = never urgent
+    void setMaxAge(uint32_t ms)                             { maxAge = ms;                }
+
+    HMS_MQXXX_StatusTypeDef add(const HMS_MQXXX_TelemetryRecord &record, bool urgent = false);
+    HMS_MQXXX_StatusTypeDef poll(uint32_t now);                             // Sends a batch that has aged out
+    HMS_MQXXX_StatusTypeDef flush();
+
+    uint8_t getPendingCount() const                         { return count;               }
+    size_t getPendingBytes() const                          { return length;              }
+    uint32_t getFramesSent() const                          { return framesSent;          }
+    uint32_t getRecordsSent() const                         { return recordsSent;         }
+    uint32_t getDroppedCount() const                        { return dropped;             }
+
+  private:
+    typedef struct {
+      HMS_MQXXX_Listener        listener;
+      HMS_MQXXX                 *sensor;
+      HMS_MQXXX_Telemetry       *owner;
+      float                     alarm;
+      uint8_t                   id;
+    } Source;
+
+    HMS_MQXXX_FrameSink         sink;
+    void                        *sinkContext;
+    Source                      sources[HMS_MQXXX_TELEMETRY_SOURCES];
+    uint8_t                     frame[HMS_MQXXX_TELEMETRY_FRAME_SIZE];
+    size_t                      length              = 0;                    // Bytes used in frame
+    uint8_t                     count               = 0;                    // Records in frame
+    bool                        urgent              = false;
+    uint16_t                    sequence            = 0;
+    uint32_t                    maxAge              = HMS_MQXXX_TELEMETRY_MAX_AGE;
+    uint32_t                    framesSent          = 0;
+    uint32_t                    recordsSent         = 0;
+    uint32_t                    dropped             = 0;
+    uint32_t                    firstTimestamp      = 0;
+    uint32_t                    lastTimestamp       = 0;
+    uint8_t                     baseCount           = 0;                    // Sources with a base in the frame
+    uint8_t                     baseSource[HMS_MQXXX_TELEMETRY_SOURCES];
+    uint32_t                    basePPM[HMS_MQXXX_TELEMETRY_SOURCES];       // Float bits
+    uint32_t                    baseRatio[HMS_MQXXX_TELEMETRY_SOURCES];
+
+    size_t encode(const HMS_MQXXX_TelemetryRecord &record, uint8_t *out, bool *newBase) const;
+    static void onReading(const HMS_MQXXX_Reading *reading, void *context);
+};
+
+/*
+  Decodes one frame on the receiving side (gateway, host tools), built with the same
+  HMS_MQXXX_TELEMETRY_SOURCES as the sender. next() returns the records in the order they
+  were added and false at the end or on a truncated/malformed frame.
+*/
+class HMS_MQXXX_TelemetryReader {
+  public:
+    HMS_MQXXX_TelemetryReader(const uint8_t *frame, size_t length);
+
+    bool isValid() const                                    { return valid;               }
+    bool isUrgent() const                                   { return valid && (data[0] & HMS_MQXXX_TELEMETRY_URGENT); }
+    uint8_t getCount() const                                { return valid ? data[1] : 0; }
+    uint16_t getSequence() const;
+    bool next(HMS_MQXXX_TelemetryRecord *record);
+
+  private:
+    const uint8_t               *data;
+    size_t                      length;
+    size_t                      pos                 = 0;
+    uint8_t                     index               = 0;
+    bool                        valid               = false;
+    uint32_t                    timestamp           = 0;
+    uint8_t                     baseCount           = 0;
+    uint8_t                     baseSource[HMS_MQXXX_TELEMETRY_SOURCES];
+    uint32_t                    basePPM[HMS_MQXXX_TELEMETRY_SOURCES];
+    uint32_t                    baseRatio[HMS_MQXXX_TELEMETRY_SOURCES];
+
+    bool readVarint(uint32_t *value);
+};
+
+#endif // HMS_MQXXX_TELEMETRY_H
@@ -0,0 +1,148 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Trace.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Binary event trace ring of the MQXXX driver
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_TRACE_H
+#define HMS_MQXXX_TRACE_H
+
+#include "HMS_MQXXX_DRIVER.h"
+
+#include <string.h>
+
+#define HMS_MQXXX_TRACE_MAGIC           0x52544D48UL                        // "HMTR" little endian
+#define HMS_MQXXX_TRACE_VERSION         2                                   // 2: ms time base in every record
+#define HMS_MQXXX_TRACE_USER            0x0100                              // First id free for application events
+
+/*
+  Driver events. Arguments are raw 32-bit words; F marks a float (bit pattern), U an integer.
+*/
+typedef enum {
+  HMS_MQXXX_TRACE_SAMPLE_BEGIN    = 1,                                      // U retries, U read interval (ms)
+  HMS_MQXXX_TRACE_SAMPLE_END      = 2,                                      // F averaged code, F voltage
+  HMS_MQXXX_TRACE_READING         = 3,                                      // F ppm, F ratio
+  HMS_MQXXX_TRACE_SATURATED       = 4,                                      // F ratio, F clamped ppm
+  HMS_MQXXX_TRACE_CALIBRATED      = 5,                                      // F new R0, F ratio in clean air
+  HMS_MQXXX_TRACE_CACHE_HIT       = 6                                       // F ppm, U age of the sample (ms)
+} HMS_MQXXX_TraceEvent;
+
+typedef struct {
+  uint32_t  ticks;                                                          // HMS_MQXXX_GetTicks() when recorded
+  uint32_t  millis;                                                         // HMS_MQXXX_Millis(), coarse time base across tick wraps
+  uint32_t  arg0;
+  uint32_t  arg1;
+  uint16_t  event;                                                          // HMS_MQXXX_TraceEvent or >= HMS_MQXXX_TRACE_USER
+  uint8_t   source;                                                         // Sensor trace id, see setTraceId()
+  uint8_t   lap;                                                            // Ring lap of the write, stored last
+} HMS_MQXXX_TraceRecord;
+
+/*
+  Dump layout: this header followed by `capacity` records in slot order, native (little)
+  endian. The record with claim number i sits in slot i % capacity and is valid when its lap
+  equals (i / capacity) & 0xFF; the ones written are [head - capacity, head).
+*/
+typedef struct {
+  uint32_t  magic;
+  uint16_t  version;
+  uint16_t  recordSize;
+  uint32_t  capacity;
+  uint32_t  head;                                                           // Claim number of the next record
+  uint32_t  tickRate;                                                       // Ticks per second
+  uint32_t  stable;                                                         // Oldest claim number not overwritten during the dump
+} HMS_MQXXX_TraceDumpHeader;
+
+static_assert(sizeof(HMS_MQXXX_TraceRecord) == 20, "Trace records are 20 bytes on every target");
+static_assert(sizeof(HMS_MQXXX_TraceDumpHeader) == 24, "Trace dump header is 24 bytes on every target");
+
+static inline uint32_t HMS_MQXXX_TraceFloat(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+// Names and argument kinds of the driver events, for decoders
+static inline const char *HMS_MQXXX_TraceEventName(uint16_t event) {
+  switch(event) {
+    case HMS_MQXXX_TRACE_SAMPLE_BEGIN:  return "sample-begin";
+    case HMS_MQXXX_TRACE_SAMPLE_END:    return "sample-end";
+    case HMS_MQXXX_TRACE_READING:       return "reading";
+    case HMS_MQXXX_TRACE_SATURATED:     return "saturated";
+    case HMS_MQXXX_TRACE_CALIBRATED:    return "calibrated";
+    case HMS_MQXXX_TRACE_CACHE_HIT:     return "cache-hit";
+    default:                            return (event >= HMS_MQXXX_TRACE_USER) ? "user" : "unknown";
+  }
+}
+
+static inline bool HMS_MQXXX_TraceArgIsFloat(uint16_t event, uint8_t arg) {
+  switch(event) {
+    case HMS_MQXXX_TRACE_SAMPLE_BEGIN:  return false;
+    case HMS_MQXXX_TRACE_CACHE_HIT:     return arg == 0;
+    case HMS_MQXXX_TRACE_SAMPLE_END:
+    case HMS_MQXXX_TRACE_READING:
+    case HMS_MQXXX_TRACE_SATURATED:
+    case HMS_MQXXX_TRACE_CALIBRATED:    return true;
+    default:                            return false;
+  }
+}
+
+#if defined(HMS_MQXXX_TRACE_ENABLED)
+
+/*
+  One RAM ring of HMS_MQXXX_TRACE_RECORDS fixed-size records shared by every sensor and the
+  application. Recording claims a slot with one atomic increment (interrupt lock on AVR and
+  Cortex-M0/M0+ under Arduino, STM32 HAL or Zephyr, which have no atomic read-modify-write
+  and would need libatomic), writes 20 bytes and the lap byte last:
+  no lock, no formatting, safe from any task or ISR, oldest records overwritten. Dumps are
+  taken while recording goes on; records overwritten during the copy are excluded through
+  the header's `stable` field. tools/HMS_MQXXX_TraceDecode turns dumps into timelines.
+
+  Ticks give the resolution but a 32-bit cycle counter wraps within seconds; the millisecond
+  stamp next to them says how many times it wrapped between two records, so the timeline
+  holds across gaps of up to 2^31 ms (about 24 days).
+*/
+void HMS_MQXXX_TraceEmit(uint16_t event, uint8_t source, uint32_t arg0, uint32_t arg1);
+void HMS_MQXXX_TraceEnable(bool enable);                                    // Runtime switch, on by default
+void HMS_MQXXX_TraceClear();                                                // Not while recording
+size_t HMS_MQXXX_TraceDumpSize();
+size_t HMS_MQXXX_TraceDump(uint8_t *out, size_t capacity);                  // 0 when out is too small
+
+#define HMS_MQXXX_TRACE(event, source, arg0, arg1)  HMS_MQXXX_TraceEmit((event), (source), (arg0), (arg1))
+
+#else
+
+#define HMS_MQXXX_TRACE(event, source, arg0, arg1)
+
+#endif
+
+#endif // HMS_MQXXX_TRACE_H
@@ -0,0 +1,62 @@
+/*
+  ====================================================================================================
+  * File:        HMS_MQXXX_Zephyr.h
+  * Author:      Hamas Saeed
+  * Version:     Rev_1.0.0
+  * Date:        Oct 19 2026
+  * Brief:       Zephyr sensor API channels for the hms,mqxxx devicetree driver
+  * 
+  ====================================================================================================
+  * License: 
+  * MIT License
+  * 
+  * Copyright (c) 2025 Hamas Saeed
+  * 
+  * Permission is hereby granted, free of charge, to any person obtaining a copy
+  * of this software and associated documentation files (the "Software"), to deal
+  * in the Software without restriction, including without limitation the rights
+  * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+  * copies of the Software, and to permit persons to whom the Software is
+  * furnished to do so, subject to the following conditions:
+  * 
+  * The above copyright notice and this permission notice shall be included in all
+  * copies or substantial portions of the Software.
+  * 
+  * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+  * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+  * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+  * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+  * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+  * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+  * SOFTWARE.
+  * 
+  * For any inquiries, contact Hamas Saeed at hamasaeed@gmail.com
+  *
+  ====================================================================================================
+ */
+#ifndef HMS_MQXXX_ZEPHYR_H
+#define HMS_MQXXX_ZEPHYR_H
+
+#include <zephyr/drivers/sensor.h>
+
+#include "HMS_MQXXX_DRIVER.h"
+
+/*
+  Channels served by "hms,mqxxx" devices besides the standard ones:
+    SENSOR_CHAN_VOLTAGE          sensor output voltage (V)
+    SENSOR_CHAN_GAS_RES          sensor resistance Rs (ohm)
+    HMS_MQXXX_SENSOR_CHAN_RATIO  Rs/R0 (R0/Rs for MQ-131), compensated
+    HMS_MQXXX_SENSOR_CHAN_PPM    concentration for the default curve of the sensor type
+    HMS_MQXXX_SENSOR_CHAN_GAS(g) concentration of HMS_MQXXX_Gas g, -ENOTSUP if the type has no curve
+  Both sample_fetch()/channel_get() and the RTIO read/decode API (CONFIG_SENSOR_ASYNC_API) are
+  supported; the decoder yields q31 values in the same units.
+*/
+enum hms_mqxxx_sensor_channel {
+  HMS_MQXXX_SENSOR_CHAN_RATIO     = SENSOR_CHAN_PRIV_START,
+  HMS_MQXXX_SENSOR_CHAN_PPM,
+  HMS_MQXXX_SENSOR_CHAN_GAS_BASE
+};
+
+#define HMS_MQXXX_SENSOR_CHAN_GAS(gas)  ((enum sensor_channel)(HMS_MQXXX_SENSOR_CHAN_GAS_BASE + (int)(gas)))
+
+#endif // HMS_MQXXX_ZEPHYR_H
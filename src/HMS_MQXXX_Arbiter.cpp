@@ -0,0 +1,166 @@
+#include "HMS_MQXXX_Arbiter.h"
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <thread>
+#endif
+
+HMS_MQXXX_Arbiter::HMS_MQXXX_Arbiter(HMS_MQXXX_ADCConvert convert, void *context) : convertFn(convert), convertContext(context) {
+  for(uint8_t i = 0; i < HMS_MQXXX_ARBITER_SLOTS; i++) slots[i].state = SLOT_FREE;
+}
+
+#if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+HMS_MQXXX_Arbiter::HMS_MQXXX_Arbiter(ADC_HandleTypeDef *hadc) : convertFn(stm32Convert), convertContext(this), hadc(hadc) {
+  for(uint8_t i = 0; i < HMS_MQXXX_ARBITER_SLOTS; i++) slots[i].state = SLOT_FREE;
+}
+
+// Only ever called by the combiner, so the peripheral and selectedChannel need no locking
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Arbiter::stm32Convert(uint32_t channel, uint16_t *code, void *context) {
+  HMS_MQXXX_Arbiter *arbiter = static_cast<HMS_MQXXX_Arbiter *>(context);
+  if(arbiter->hadc == NULL) return HMS_MQXXX_ERROR;
+
+  if(channel != HMS_MQXXX_STM32_NO_CHANNEL && channel != arbiter->selectedChannel) {
+    if(HMS_MQXXX_STM32SelectChannel(arbiter->hadc, channel) != HAL_OK) {
+      arbiter->selectedChannel = HMS_MQXXX_STM32_NO_CHANNEL;
+      return HMS_MQXXX_ERROR;
+    }
+    arbiter->selectedChannel = channel;
+  }
+
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_ERROR;
+  HAL_ADC_Start(arbiter->hadc);
+  if(HAL_ADC_PollForConversion(arbiter->hadc, 10) == HAL_OK) {
+    *code  = (uint16_t)HAL_ADC_GetValue(arbiter->hadc);
+    status = HMS_MQXXX_OK;
+  }
+  HAL_ADC_Stop(arbiter->hadc);
+  return status;
+}
+#endif
+
+HMS_MQXXX_Arbiter::Key HMS_MQXXX_Arbiter::enter() {
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  return primask;
+  #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  taskENTER_CRITICAL(&mux);                                                 // Spinlock, safe across both cores
+  return 0;
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+  return k_spin_lock(&spin);
+  #elif defined(HMS_MQXXX_PLATFORM_ARDUINO)
+    #if defined(__AVR__)
+    uint32_t sreg = SREG;
+    cli();
+    return sreg;
+    #else
+    noInterrupts();
+    return 0;
+    #endif
+  #else
+  while(__atomic_test_and_set(&spin, __ATOMIC_ACQUIRE)) {}
+  return 0;
+  #endif
+}
+
+void HMS_MQXXX_Arbiter::leave(Key key) {
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  __set_PRIMASK(key);
+  #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  (void)key;
+  taskEXIT_CRITICAL(&mux);
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+  k_spin_unlock(&spin, key);
+  #elif defined(HMS_MQXXX_PLATFORM_ARDUINO)
+    #if defined(__AVR__)
+    SREG = (uint8_t)key;
+    #else
+    (void)key;
+    interrupts();
+    #endif
+  #else
+  (void)key;
+  __atomic_clear(&spin, __ATOMIC_RELEASE);
+  #endif
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Arbiter::convert(uint32_t channel, uint16_t *code) {
+  if(code == NULL || convertFn == NULL) return HMS_MQXXX_ERROR;
+
+  // Post the request
+  int16_t slot = -1;
+  while(slot < 0) {
+    Key key = enter();
+    for(uint8_t i = 0; i < HMS_MQXXX_ARBITER_SLOTS; i++) {
+      if(slots[i].state == SLOT_FREE) {
+        slots[i].channel = channel;
+        slots[i].state   = SLOT_PENDING;
+        slot = i;
+        break;
+      }
+    }
+    if(slot >= 0) requests++;
+    leave(key);
+    if(slot < 0) HMS_MQXXX_ARBITER_YIELD();                                 // Every slot taken, wait for one to drain
+  }
+
+  for(;;) {
+    // Become the combiner if the ADC is idle, otherwise someone else will serve the slot
+    Key key = enter();
+    bool combiner = !busy;
+    if(combiner) busy = true;
+    leave(key);
+
+    if(combiner) {
+      combine();
+      key  = enter();
+      busy = false;
+      leave(key);
+    }
+
+    key = enter();
+    if(slots[slot].state == SLOT_DONE) {
+      *code = slots[slot].code;
+      HMS_MQXXX_StatusTypeDef status = (HMS_MQXXX_StatusTypeDef)slots[slot].status;
+      slots[slot].state = SLOT_FREE;
+      leave(key);
+      return status;
+    }
+    leave(key);
+    HMS_MQXXX_ARBITER_YIELD();
+  }
+}
+
+void HMS_MQXXX_Arbiter::combine() {
+  for(;;) {
+    // Snapshot: requests posted after this point get a conversion of their own
+    uint8_t batch = 0;
+    Key key = enter();
+    for(uint8_t i = 0; i < HMS_MQXXX_ARBITER_SLOTS; i++) {
+      if(slots[i].state == SLOT_PENDING) {
+        slots[i].state = SLOT_SERVICING;
+        batch++;
+      }
+    }
+    leave(key);
+    if(batch == 0) return;
+
+    for(uint8_t i = 0; i < HMS_MQXXX_ARBITER_SLOTS; i++) {
+      if(slots[i].state != SLOT_SERVICING) continue;
+
+      uint32_t channel = slots[i].channel;
+      uint16_t value   = 0;
+      HMS_MQXXX_StatusTypeDef status = convertFn(channel, &value, convertContext);   // Outside the critical section
+      conversions++;
+
+      key = enter();
+      for(uint8_t j = i; j < HMS_MQXXX_ARBITER_SLOTS; j++) {
+        if(slots[j].state != SLOT_SERVICING || slots[j].channel != channel) continue;
+        slots[j].code   = value;
+        slots[j].status = (uint8_t)status;
+        slots[j].state  = SLOT_DONE;
+        if(j != i) coalesced++;
+      }
+      leave(key);
+    }
+  }
+}
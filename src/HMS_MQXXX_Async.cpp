@@ -0,0 +1,258 @@
+#include "HMS_MQXXX_Async.h"
+
+#if defined(HMS_MQXXX_ASYNC_AVAILABLE)
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <thread>
+#endif
+
+#if defined(HMS_MQXXX_ASYNC_POOLED)
+static_assert(HMS_MQXXX_ASYNC_FRAMES <= 32, "One bit per pooled frame");
+
+alignas(__STDCPP_DEFAULT_NEW_ALIGNMENT__) static uint8_t asyncFrames[HMS_MQXXX_ASYNC_FRAMES][HMS_MQXXX_ASYNC_FRAME_SIZE];
+static uint32_t asyncFrameUsed     = 0;                                     // Bit i set = asyncFrames[i] taken
+static uint32_t asyncFrameFailures = 0;
+
+// Lock-free so frames can be taken from the executor callback and from tasks alike
+void *HMS_MQXXX_AsyncFrameAlloc(size_t size) {
+  if(size <= HMS_MQXXX_ASYNC_FRAME_SIZE) {
+    uint32_t used = __atomic_load_n(&asyncFrameUsed, __ATOMIC_RELAXED);
+    for(;;) {
+      uint32_t slot = 0;
+      while(slot < HMS_MQXXX_ASYNC_FRAMES && (used & (1UL << slot))) slot++;
+      if(slot == HMS_MQXXX_ASYNC_FRAMES) break;
+      if(__atomic_compare_exchange_n(&asyncFrameUsed, &used, used | (1UL << slot), true, __ATOMIC_ACQUIRE, __ATOMIC_RELAXED)) {
+        return asyncFrames[slot];
+      }
+    }
+  }
+  __atomic_fetch_add(&asyncFrameFailures, 1, __ATOMIC_RELAXED);
+  return NULL;
+}
+
+void HMS_MQXXX_AsyncFrameFree(void *frame) {
+  uint32_t slot = (uint32_t)(((uint8_t *)frame - &asyncFrames[0][0]) / HMS_MQXXX_ASYNC_FRAME_SIZE);
+  __atomic_fetch_and(&asyncFrameUsed, ~(1UL << slot), __ATOMIC_RELEASE);
+}
+
+uint32_t HMS_MQXXX_AsyncFrameFailures() {
+  return __atomic_load_n(&asyncFrameFailures, __ATOMIC_RELAXED);
+}
+#endif
+
+// Signed distance so deadlines keep working across the 49-day millisecond wrap
+static inline bool dueBy(uint32_t due, uint32_t time) {
+  return (int32_t)(due - time) <= 0;
+}
+
+void HMS_MQXXX_Executor::post(HMS_MQXXX_AsyncNode *node, uint32_t delay) {
+  node->due  = now() + delay;
+  node->next = NULL;
+
+  lock();
+  bool earliest = false;
+  if(head == NULL) {
+    head = tail = node;
+    earliest = true;
+  } else if(dueBy(tail->due, node->due)) {
+    tail->next = node;                                                      // Common case: same interval as everyone else
+    tail = node;
+  } else if(!dueBy(head->due, node->due)) {
+    node->next = head;
+    head = node;
+    earliest = true;
+  } else {
+    HMS_MQXXX_AsyncNode *at = head;
+    while(dueBy(at->next->due, node->due)) at = at->next;                   // Stops before tail, tail is later than node
+    node->next = at->next;
+    at->next = node;
+  }
+  pending++;
+  unlock();
+
+  if(earliest) rearm(delay);
+}
+
+uint32_t HMS_MQXXX_Executor::runDue() {
+  uint32_t time    = now();
+  uint32_t resumed = 0;
+  for(;;) {
+    lock();
+    HMS_MQXXX_AsyncNode *node = head;
+    if(node == NULL || !dueBy(node->due, time)) {
+      unlock();
+      break;
+    }
+    head = node->next;
+    if(head == NULL) tail = NULL;
+    pending--;
+    unlock();
+
+    node->handle.resume();                                                  // May post again, node is not touched after this
+    resumed++;
+  }
+  return resumed;
+}
+
+bool HMS_MQXXX_Executor::nextDelay(uint32_t *delay) {
+  lock();
+  bool busy = (head != NULL);
+  uint32_t due = busy ? head->due : 0;
+  unlock();
+  if(busy) {
+    uint32_t time = now();
+    *delay = dueBy(due, time) ? 0 : due - time;
+  }
+  return busy;
+}
+
+/*
+  Same acquisition as getVoltage(true): retries conversions spaced retryInterval apart, except
+  that the spacing is a suspension on the executor instead of mqDelay(). NAN when no
+  conversion succeeded.
+*/
+HMS_MQXXX_Task<float> HMS_MQXXX::acquireAsync() {
+  float   sum       = 0.0;
+  uint8_t converted = 0;
+  uint8_t retries   = readRetries();
+  for(int i = 0; i < retries; i++) {
+    uint16_t code;
+    if(readADC(&code) == HMS_MQXXX_OK) {
+      adc  = code;
+      sum += code;
+      converted++;
+    }
+    if(executor != NULL) co_await HMS_MQXXX_Sleep(executor, readInterval());
+    else                 mqDelay(readInterval());
+  }
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  if(arbiter == NULL) HAL_ADC_Stop(MQXXX_hadc);
+  #endif
+  co_return (converted > 0) ? codeToVoltage(sum / converted) : NAN;
+}
+
+HMS_MQXXX_Task<float> HMS_MQXXX::readAsync(float correctionFactor) {
+  if(voltageFresh()) co_return readSensor(correctionFactor);               // Cache hit, nothing to wait for
+  HMS_MQXXX_Task<float> acquisition = acquireAsync();
+  float voltage = acquisition.valid() ? co_await acquisition : getVoltage(true, false, 0);   // Frame pool exhausted: block instead
+  co_return isnan(voltage) ? failReading().ppm : processVoltage(voltage, correctionFactor).ppm;
+}
+
+// Averages several clean-air acquisitions, interval ms apart, before deriving R0
+HMS_MQXXX_Task<float> HMS_MQXXX::calibrateAsync(float ratioInCleanAir, uint8_t samples, uint32_t interval, float correctionFactor) {
+  if(samples == 0) samples = 1;
+  float   sum   = 0.0;
+  uint8_t valid = 0;
+  for(uint8_t i = 0; i < samples; i++) {
+    if(i > 0) {
+      if(executor != NULL) co_await HMS_MQXXX_Sleep(executor, interval);
+      else                 mqDelay(interval);
+    }
+    HMS_MQXXX_Task<float> acquisition = acquireAsync();
+    float voltage = acquisition.valid() ? co_await acquisition : getVoltage(true, false, 0);
+    if(isnan(voltage)) continue;                                            // Failed acquisition, not a 0 V sample
+    sum += voltage;
+    valid++;
+  }
+  if(valid == 0) co_return NAN;                                             // R0 left as it was
+  float voltage = sum / valid;
+  keepVoltage(voltage);
+  co_return calibrateVoltage(voltage, ratioInCleanAir, correctionFactor);
+}
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+
+HMS_MQXXX_HostLoop::HMS_MQXXX_HostLoop(bool virtualTime) : virtualClock(virtualTime), epoch(std::chrono::steady_clock::now()) {
+}
+
+uint32_t HMS_MQXXX_HostLoop::now() {
+  if(virtualClock) return clock;
+  return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+bool HMS_MQXXX_HostLoop::runOnce() {
+  uint32_t delay;
+  if(!nextDelay(&delay)) return false;
+  if(delay > 0) {
+    if(virtualClock) clock += delay;
+    else             std::this_thread::sleep_for(std::chrono::milliseconds(delay));
+  }
+  runDue();
+  return true;
+}
+
+#endif
+
+#if defined(HMS_MQXXX_TIMER_EXECUTOR_AVAILABLE)
+
+HMS_MQXXX_TimerExecutor::~HMS_MQXXX_TimerExecutor() {
+  if(timer != NULL) xTimerDelete(timer, portMAX_DELAY);
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_TimerExecutor::begin() {
+  if(timer != NULL) return HMS_MQXXX_OK;
+  #if defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+  timer = xTimerCreateStatic("hms_mq_async", 1, pdFALSE, this, expired, &timerControl);
+  #else
+  timer = xTimerCreate("hms_mq_async", 1, pdFALSE, this, expired);
+  #endif
+  return (timer != NULL) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+void HMS_MQXXX_TimerExecutor::rearm(uint32_t delay) {
+  if(timer == NULL) return;
+  TickType_t ticks = pdMS_TO_TICKS(delay);
+  xTimerChangePeriod(timer, (ticks > 0) ? ticks : 1, 0);                    // Also (re)starts the one-shot timer
+}
+
+void HMS_MQXXX_TimerExecutor::lock() {
+  #if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  taskENTER_CRITICAL(&mux);
+  #else
+  taskENTER_CRITICAL();
+  #endif
+}
+
+void HMS_MQXXX_TimerExecutor::unlock() {
+  #if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  taskEXIT_CRITICAL(&mux);
+  #else
+  taskEXIT_CRITICAL();
+  #endif
+}
+
+void HMS_MQXXX_TimerExecutor::expired(TimerHandle_t timer) {
+  HMS_MQXXX_TimerExecutor *self = static_cast<HMS_MQXXX_TimerExecutor *>(pvTimerGetTimerID(timer));
+  self->runDue();
+  uint32_t delay;
+  if(self->nextDelay(&delay)) self->rearm(delay);
+}
+
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+
+HMS_MQXXX_WorkExecutor::HMS_MQXXX_WorkExecutor(struct k_work_q *queue) : workQueue(queue) {
+  item.owner = this;
+  k_work_init_delayable(&item.work, handler);
+}
+
+HMS_MQXXX_WorkExecutor::~HMS_MQXXX_WorkExecutor() {
+  k_work_cancel_delayable(&item.work);
+}
+
+void HMS_MQXXX_WorkExecutor::rearm(uint32_t delay) {
+  k_work_reschedule_for_queue((workQueue != NULL) ? workQueue : &k_sys_work_q, &item.work, K_MSEC(delay));
+}
+
+void HMS_MQXXX_WorkExecutor::handler(struct k_work *work) {
+  Item *entry = CONTAINER_OF(k_work_delayable_from_work(work), Item, work);
+  HMS_MQXXX_WorkExecutor *self = entry->owner;
+  self->runDue();
+  uint32_t delay;
+  if(self->nextDelay(&delay)) self->rearm(delay);
+}
+
+#endif
+
+#endif // HMS_MQXXX_ASYNC_AVAILABLE
@@ -0,0 +1,210 @@
+#include "HMS_MQXXX_ChromeTrace.h"
+
+#if defined(HMS_MQXXX_SPANS_ENABLED)
+
+#include "HMS_MQXXX_Cycles.h"
+
+#include <chrono>
+
+#include <math.h>
+#include <stdarg.h>
+#include <string.h>
+
+static const char *const stageNames[HMS_MQXXX_STAGE_COUNT] = {
+  "acquire", "mqDelay", "average", "rs", "ratio", "curve", "readSensor"
+};
+
+static inline uint64_t steadyNanoseconds() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+// Trace-event timestamps are microseconds with a fractional part
+static inline double toMicroseconds(uint64_t ns) {
+  return (double)ns / 1000.0;
+}
+
+// Names end up inside JSON strings: keep them printable and quote-free
+static size_t copyName(const char *name, char *out, size_t size) {
+  size_t n = 0;
+  for(const char *c = (name != NULL) ? name : ""; *c != '\0' && n + 1 < size; c++) {
+    out[n++] = ((unsigned char)*c < 0x20 || *c == '"' || *c == '\\') ? '_' : *c;
+  }
+  out[n] = '\0';
+  return n;
+}
+
+HMS_MQXXX_ChromeTrace::~HMS_MQXXX_ChromeTrace() {
+  close();
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_ChromeTrace::open(const char *path, Clock source, void *context) {
+  close();
+  if(path == NULL) return HMS_MQXXX_ERROR;
+  file = fopen(path, "w");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+
+  clock        = source;
+  clockContext = context;
+  epoch        = steadyNanoseconds();
+  events       = 0;
+  alarms       = 0;
+  fprintf(file, "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n");
+  fprintf(file, "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"HMS_MQXXX\"}}");
+
+  HMS_MQXXX_HostSpans spans = { onNow, onSpan, this };
+  HMS_MQXXX_SetHostSpans(&spans);
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX_ChromeTrace::close() {
+  if(file == NULL) return;
+  HMS_MQXXX_SetHostSpans(NULL);
+  while(!tracks.empty()) detach(tracks.back()->sensor);
+
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  fprintf(file, "\n]}\n");
+  fclose(file);
+  file = NULL;
+}
+
+uint64_t HMS_MQXXX_ChromeTrace::now() {
+  return (clock != NULL) ? clock(clockContext) : steadyNanoseconds() - epoch;
+}
+
+HMS_MQXXX_ChromeTrace::Track *HMS_MQXXX_ChromeTrace::find(const HMS_MQXXX *sensor) {
+  for(const std::unique_ptr<Track> &track : tracks) {
+    if(track->sensor == sensor) return track.get();
+  }
+  return NULL;
+}
+
+void HMS_MQXXX_ChromeTrace::emit(const char *format, ...) {
+  if(file == NULL) return;
+  va_list args;
+  va_start(args, format);
+  fputs(",\n", file);
+  vfprintf(file, format, args);
+  va_end(args);
+  events++;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_ChromeTrace::attach(HMS_MQXXX *sensor, const char *name) {
+  if(sensor == NULL || file == NULL) return HMS_MQXXX_ERROR;
+  detach(sensor);
+
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  std::unique_ptr<Track> track(new Track());
+  track->listener.callback = onReading;
+  track->listener.event    = NULL;
+  track->listener.context  = track.get();
+  track->listener.next     = NULL;
+  track->sensor            = sensor;
+  track->owner             = this;
+  track->tid               = (tracks.empty() ? 0 : tracks.back()->tid) + 1;
+  track->alarm             = NAN;
+  track->alarmed           = false;
+  track->sampleOpen        = false;
+  track->sampleBegin       = 0;
+
+  if(copyName(name, track->name, sizeof(track->name)) == 0) snprintf(track->name, sizeof(track->name), "sensor %lu", (unsigned long)track->tid);
+
+  emit("{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"name\":\"%s\"}}", (unsigned long)track->tid, track->name);
+  emit("{\"name\":\"thread_sort_index\",\"ph\":\"M\",\"pid\":1,\"tid\":%lu,\"args\":{\"sort_index\":%lu}}", (unsigned long)track->tid,
+       (unsigned long)track->tid);
+  sensor->addListener(&track->listener);
+  tracks.push_back(std::move(track));
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX_ChromeTrace::detach(HMS_MQXXX *sensor) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  for(size_t i = 0; i < tracks.size(); i++) {
+    if(tracks[i]->sensor != sensor || sensor == NULL) continue;
+    sensor->removeListener(&tracks[i]->listener);
+    tracks.erase(tracks.begin() + i);
+    return;
+  }
+}
+
+void HMS_MQXXX_ChromeTrace::setAlarmThreshold(HMS_MQXXX *sensor, float ppm) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  Track *track = find(sensor);
+  if(track == NULL) return;
+  track->alarm   = ppm;
+  track->alarmed = false;
+}
+
+void HMS_MQXXX_ChromeTrace::mark(const HMS_MQXXX *sensor, const char *name) {
+  std::lock_guard<std::recursive_mutex> guard(lock);
+  Track *track = find(sensor);
+  char   label[32];
+  copyName(name, label, sizeof(label));
+  if(track != NULL) {
+    emit("{\"name\":\"%s\",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu}", label, toMicroseconds(now()),
+         (unsigned long)track->tid);
+  } else {
+    emit("{\"name\":\"%s\",\"cat\":\"mark\",\"ph\":\"i\",\"s\":\"g\",\"ts\":%.3f,\"pid\":1,\"tid\":0}", label, toMicroseconds(now()));
+  }
+}
+
+uint64_t HMS_MQXXX_ChromeTrace::onNow(void *context) {
+  return static_cast<HMS_MQXXX_ChromeTrace *>(context)->now();
+}
+
+void HMS_MQXXX_ChromeTrace::onSpan(const HMS_MQXXX *sensor, uint8_t stage, uint64_t begin, uint64_t end, void *context) {
+  HMS_MQXXX_ChromeTrace *self = static_cast<HMS_MQXXX_ChromeTrace *>(context);
+  if(stage >= HMS_MQXXX_STAGE_COUNT) return;
+
+  std::lock_guard<std::recursive_mutex> guard(self->lock);
+  Track *track = self->find(sensor);
+  if(track == NULL) return;
+  uint64_t entry = steadyNanoseconds();
+  if(stage == HMS_MQXXX_STAGE_ACQUIRE && !track->sampleOpen) {
+    track->sampleOpen  = true;
+    track->sampleBegin = begin;
+  }
+  self->emit("{\"name\":\"%s\",\"cat\":\"stage\",\"ph\":\"X\",\"ts\":%.3f,\"dur\":%.3f,\"pid\":1,\"tid\":%lu}", stageNames[stage],
+             toMicroseconds(begin), toMicroseconds(end - begin), (unsigned long)track->tid);
+  self->overhead += steadyNanoseconds() - entry;
+}
+
+void HMS_MQXXX_ChromeTrace::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  Track                 *track = static_cast<Track *>(context);
+  HMS_MQXXX_ChromeTrace *self  = track->owner;
+
+  std::lock_guard<std::recursive_mutex> guard(self->lock);
+  uint64_t entry = steadyNanoseconds();
+  uint64_t at    = self->now();
+  uint64_t begin = track->sampleOpen ? track->sampleBegin : at;             // processVoltage(): acquired elsewhere
+  track->sampleOpen = false;
+  if(isfinite(reading->ppm)) self->record(track, reading, begin, at);
+  self->overhead += steadyNanoseconds() - entry;
+}
+
+/*
+  Runs inside readSensor(), after the acquisition spans and before the readSensor span ends,
+  so the alarm latency covers acquisition, conversion and the listeners ahead of this one.
+*/
+void HMS_MQXXX_ChromeTrace::record(Track *track, const HMS_MQXXX_Reading *reading, uint64_t begin, uint64_t at) {
+  emit("{\"name\":\"%s ppm\",\"ph\":\"C\",\"ts\":%.3f,\"pid\":1,\"args\":{\"ppm\":%.6g}}", track->name, toMicroseconds(at),
+       (double)reading->ppm);
+  if(isnan(track->alarm)) return;
+
+  bool alarm = (reading->status == HMS_MQXXX_OK) && reading->ppm >= track->alarm;
+  if(alarm && !track->alarmed) {
+    uint32_t id = ++alarms;
+    emit("{\"name\":\"sample-to-alarm\",\"cat\":\"alarm\",\"ph\":\"b\",\"id\":%lu,\"ts\":%.3f,\"pid\":1,\"tid\":%lu}",
+       (unsigned long)id, toMicroseconds(begin), (unsigned long)track->tid);
+    emit("{\"name\":\"sample-to-alarm\",\"cat\":\"alarm\",\"ph\":\"e\",\"id\":%lu,\"ts\":%.3f,\"pid\":1,\"tid\":%lu,"
+       "\"args\":{\"latency_us\":%.3f,\"ppm\":%.6g,\"threshold\":%.6g}}", (unsigned long)id, toMicroseconds(at),
+       (unsigned long)track->tid, toMicroseconds(at - begin), (double)reading->ppm, (double)track->alarm);
+    emit("{\"name\":\"alarm\",\"cat\":\"alarm\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu}", toMicroseconds(at),
+       (unsigned long)track->tid);
+  } else if(!alarm && track->alarmed) {
+    emit("{\"name\":\"alarm-clear\",\"cat\":\"alarm\",\"ph\":\"i\",\"s\":\"t\",\"ts\":%.3f,\"pid\":1,\"tid\":%lu}",
+       toMicroseconds(at), (unsigned long)track->tid);
+  }
+  track->alarmed = alarm;
+}
+
+#endif
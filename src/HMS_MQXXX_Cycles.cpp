@@ -0,0 +1,135 @@
+#include "HMS_MQXXX_Cycles.h"
+
+#if defined(HMS_MQXXX_CYCLES_ENABLED) || defined(HMS_MQXXX_TRACE_ENABLED)
+
+#include <string.h>
+#include <limits.h>
+
+#if defined(ESP_PLATFORM)
+  #include "esp_cpu.h"
+  #include "esp_rom_sys.h"
+#elif defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <time.h>
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_STM32_HAL) && defined(DWT_CTRL_CYCCNTENA_Msk)
+  #define HMS_MQXXX_CYCLES_DWT                                              // Cortex-M0/M0+ have no cycle counter
+#endif
+
+void HMS_MQXXX_StartTicks() {
+  #if defined(HMS_MQXXX_CYCLES_DWT)
+  CoreDebug->DEMCR = CoreDebug->DEMCR | CoreDebug_DEMCR_TRCENA_Msk;      // No compound ops on volatile (C++20)
+  DWT->CTRL        = DWT->CTRL | DWT_CTRL_CYCCNTENA_Msk;
+  #endif
+}
+
+uint32_t HMS_MQXXX_GetTicks() {
+  #if defined(ESP_PLATFORM)
+  return (uint32_t)esp_cpu_get_cycle_count();
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+  return k_cycle_get_32();
+  #elif defined(HMS_MQXXX_CYCLES_DWT)
+  return DWT->CYCCNT;
+  #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  return HAL_GetTick();
+  #elif defined(HMS_MQXXX_PLATFORM_ARDUINO)
+  return micros();
+  #elif defined(HMS_MQXXX_PLATFORM_HOST)
+  struct timespec ts;
+  clock_gettime(CLOCK_MONOTONIC, &ts);
+  return (uint32_t)((uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec);
+  #endif
+}
+
+uint32_t HMS_MQXXX_GetTickRate() {
+  #if defined(ESP_PLATFORM)
+  return esp_rom_get_cpu_ticks_per_us() * 1000000UL;
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+  return (uint32_t)sys_clock_hw_cycles_per_sec();
+  #elif defined(HMS_MQXXX_CYCLES_DWT)
+  return SystemCoreClock;
+  #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  return 1000UL;
+  #elif defined(HMS_MQXXX_PLATFORM_ARDUINO)
+  return 1000000UL;
+  #elif defined(HMS_MQXXX_PLATFORM_HOST)
+  return 1000000000UL;
+  #endif
+}
+
+#if defined(HMS_MQXXX_CYCLES_ENABLED)
+
+static_assert(HMS_MQXXX_CYCLE_BUCKETS >= 2 && HMS_MQXXX_CYCLE_BUCKETS <= 32, "Buckets are powers of two of a 32-bit count");
+
+static inline uint8_t bucketOf(uint32_t ticks) {
+  if(ticks < 2) return 0;
+  #if UINT_MAX == 0xFFFFFFFFU
+  uint8_t bucket = (uint8_t)(31 - __builtin_clz(ticks));
+  #else
+  uint8_t bucket = (uint8_t)(31 - __builtin_clzl(ticks));                   // 16-bit int (AVR): long is 32 bits
+  #endif
+  return (bucket < HMS_MQXXX_CYCLE_BUCKETS) ? bucket : (uint8_t)(HMS_MQXXX_CYCLE_BUCKETS - 1);
+}
+
+HMS_MQXXX_CycleStats::HMS_MQXXX_CycleStats() {
+  HMS_MQXXX_StartTicks();
+  clear();
+}
+
+void HMS_MQXXX_CycleStats::record(HMS_MQXXX_Stage stage, uint32_t ticks) {
+  if(stage >= HMS_MQXXX_STAGE_COUNT) return;
+  Histogram &h = stages[stage];
+  h.buckets[bucketOf(ticks)]++;
+  if(h.count == 0 || ticks < h.min) h.min = ticks;
+  if(ticks > h.max) h.max = ticks;
+  h.total += ticks;
+  h.count++;
+}
+
+void HMS_MQXXX_CycleStats::clear() {
+  memset(stages, 0, sizeof(stages));
+}
+
+uint32_t HMS_MQXXX_CycleStats::getCount(HMS_MQXXX_Stage stage) const {
+  return (stage < HMS_MQXXX_STAGE_COUNT) ? stages[stage].count : 0;
+}
+
+uint32_t HMS_MQXXX_CycleStats::getMin(HMS_MQXXX_Stage stage) const {
+  return (stage < HMS_MQXXX_STAGE_COUNT) ? stages[stage].min : 0;
+}
+
+uint32_t HMS_MQXXX_CycleStats::getMax(HMS_MQXXX_Stage stage) const {
+  return (stage < HMS_MQXXX_STAGE_COUNT) ? stages[stage].max : 0;
+}
+
+uint32_t HMS_MQXXX_CycleStats::getMean(HMS_MQXXX_Stage stage) const {
+  if(stage >= HMS_MQXXX_STAGE_COUNT || stages[stage].count == 0) return 0;
+  return (uint32_t)(stages[stage].total / stages[stage].count);
+}
+
+uint32_t HMS_MQXXX_CycleStats::getBucket(HMS_MQXXX_Stage stage, uint8_t bucket) const {
+  return (stage < HMS_MQXXX_STAGE_COUNT && bucket < HMS_MQXXX_CYCLE_BUCKETS) ? stages[stage].buckets[bucket] : 0;
+}
+
+uint32_t HMS_MQXXX_CycleStats::getPercentile(HMS_MQXXX_Stage stage, float fraction) const {
+  if(stage >= HMS_MQXXX_STAGE_COUNT || stages[stage].count == 0) return 0;
+  const Histogram &h = stages[stage];
+  if(!(fraction > 0)) return h.min;
+  if(fraction >= 1)   return h.max;
+
+  uint32_t rank = (uint32_t)(fraction * (float)h.count);                    // Samples at or below the answer, minus one
+  uint32_t seen = 0;
+  for(uint8_t b = 0; b < HMS_MQXXX_CYCLE_BUCKETS; b++) {
+    seen += h.buckets[b];
+    if(seen > rank) {
+      if(b == HMS_MQXXX_CYCLE_BUCKETS - 1) return h.max;                  // Open-ended last bucket
+      uint32_t edge = (uint32_t)((2UL << b) - 1);
+      return (edge < h.max) ? edge : h.max;
+    }
+  }
+  return h.max;
+}
+
+#endif // HMS_MQXXX_CYCLES_ENABLED
+
+#endif
@@ -1,20 +1,69 @@
 #include "HMS_MQXXX_DRIVER.h"
+#include "HMS_MQXXX_Arbiter.h"
+#include "HMS_MQXXX_Cycles.h"
+#include "HMS_MQXXX_Trace.h"
 
+#include <string.h>
+
+#if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #include "esp_timer.h"
+  #if defined(HMS_MQXXX_ADC_CALIBRATION_ENABLED) && (HMS_MQXXX_ADC_CALIBRATION_ENABLED == 1)
+    #include "esp_adc/adc_cali.h"
+    #include "esp_adc/adc_cali_scheme.h"
+  #endif
+#endif
+
+#if defined(HMS_MQXXX_PLATFORM_HOST)
+  #include <chrono>
+  #include <thread>
+
+static HMS_MQXXX_HostHooks hostHooks = { NULL, NULL, NULL, NULL };
+
+void HMS_MQXXX_SetHostHooks(const HMS_MQXXX_HostHooks *hooks) {
+  if(hooks == NULL) {
+    hostHooks = HMS_MQXXX_HostHooks{ NULL, NULL, NULL, NULL };
+  } else {
+    hostHooks = *hooks;
+  }
+}
+
+#if defined(HMS_MQXXX_SPANS_ENABLED)
+static HMS_MQXXX_HostSpans hostSpans = { NULL, NULL, NULL };
+
+void HMS_MQXXX_SetHostSpans(const HMS_MQXXX_HostSpans *spans) {
+  if(spans == NULL) {
+    hostSpans = HMS_MQXXX_HostSpans{ NULL, NULL, NULL };
+  } else {
+    hostSpans = *spans;
+  }
+}
+
+uint64_t HMS_MQXXX_SpanBegin() {
+  return (hostSpans.span != NULL && hostSpans.now != NULL) ? hostSpans.now(hostSpans.context) : 0;
+}
+
+void HMS_MQXXX_SpanEnd(const HMS_MQXXX *sensor, uint8_t stage, uint64_t begin) {
+  if(hostSpans.span == NULL || hostSpans.now == NULL) return;
+  hostSpans.span(sensor, stage, begin, hostSpans.now(hostSpans.context), hostSpans.context);
+}
+#endif
+#endif
 
 #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
-HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin), type(type) {
-  setDefaultValues();
+HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin) {
+  setDefaultValues(type);
 }
 
 HMS_MQXXX_StatusTypeDef HMS_MQXXX::init() {
   // For Arduino, set pin as INPUT
   pinMode(pin, INPUT);
+  initCommon();
   return HMS_MQXXX_OK;
 }
 
 #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
-HMS_MQXXX::HMS_MQXXX(ADC_HandleTypeDef *hadc, HMS_MQXXX_Type type) : type(type) {
-  setDefaultValues();
+HMS_MQXXX::HMS_MQXXX(ADC_HandleTypeDef *hadc, HMS_MQXXX_Type type) {
+  setDefaultValues(type);
   MQXXX_hadc = hadc;
 }
 
@@ -24,77 +73,167 @@ HMS_MQXXX_StatusTypeDef HMS_MQXXX::init() {
     return HMS_MQXXX_ERROR;
   }
 
-  setRegressionMethod(regression);
+  initCommon();
+  #if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+    #if defined(HMS_MQXXX_STORAGE_TIME)
+  uint32_t now = HMS_MQXXX_STORAGE_TIME();
+    #else
+  uint32_t now = 0;                                                         // No wall clock: the age check is off, records never expire
+    #endif
+  if(restoreCalibration(now) == HMS_MQXXX_OK) {                           // Warm boot, keep the stored R0
+    readSensor();
+    return HMS_MQXXX_OK;
+  }
+  #endif
+
   float calcR0 = 0;
-  for(int i = 0; i<=HMS_CALIBRATIION_SAMPLES; i++)
+  int   valid  = 0;
+  for(int i = 0; i<HMS_CALIBRATIION_SAMPLES; i++)
     {
-      calcR0 += calibrate(HMS_MQXXX_MQ2_CLEAN_AIR_RATIO,0);
+      float sample = calibrate(HMS_MQXXX_MQ2_CLEAN_AIR_RATIO,0);
+      if(isnan(sample)) continue;                                           // Failed conversion, not a 0 V sample
+      calcR0 += sample;
+      valid++;
     }
-  setR0(calcR0/HMS_CALIBRATIION_SAMPLES);  
+  if(valid == 0) return HMS_MQXXX_ERROR;
+  setR0(calcR0/valid);  
+  #if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+  saveCalibration(now);
+  #endif
   // Just initialize any required variables
   readSensor();
   return HMS_MQXXX_OK;
 }
 
 #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
-HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin), type(type) {
-  setDefaultValues();
+HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin) {
+  setDefaultValues(type);
+}
+
+// One oneshot driver per ADC unit, shared by every sensor on it (the IDF allows only one)
+static adc_oneshot_unit_handle_t espAdcUnits[2] = { NULL, NULL };
+
+void HMS_MQXXX_ESPSetADCUnit(adc_unit_t unit, adc_oneshot_unit_handle_t handle) {
+  if((int)unit < 2) espAdcUnits[unit] = handle;
 }
 
 HMS_MQXXX_StatusTypeDef HMS_MQXXX::init() {
-  // Initialize ESP-IDF ADC
+  if(adc_oneshot_io_to_channel(pin, &adcUnit, &adcChannel) != ESP_OK || (int)adcUnit >= 2) {
+    return HMS_MQXXX_ERROR;                                                 // Not an ADC-capable GPIO
+  }
+  if(espAdcUnits[adcUnit] == NULL) {
+    adc_oneshot_unit_init_cfg_t unitConfig = {};
+    unitConfig.unit_id = adcUnit;
+    if(adc_oneshot_new_unit(&unitConfig, &espAdcUnits[adcUnit]) != ESP_OK) return HMS_MQXXX_ERROR;
+  }
+  adc_oneshot_chan_cfg_t channelConfig = {};
+  channelConfig.atten    = HMS_MQXXX_ESP_ADC_ATTEN;
+  channelConfig.bitwidth = HMS_MQXXX_ESP_ADC_BITWIDTH;
+  if(adc_oneshot_config_channel(espAdcUnits[adcUnit], adcChannel, &channelConfig) != ESP_OK) return HMS_MQXXX_ERROR;
+
+  // Codes come back at the configured width (adc_bitwidth_t values are bit counts)
+  uint8_t bits = (HMS_MQXXX_ESP_ADC_BITWIDTH == ADC_BITWIDTH_DEFAULT) ? (uint8_t)SOC_ADC_RTC_MAX_BITWIDTH : (uint8_t)HMS_MQXXX_ESP_ADC_BITWIDTH;
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  if(getADCBitResolution() != bits) return HMS_MQXXX_ERROR;                 // Shared profile disagrees with the ADC
+  #else
+  setADCBitResolution(bits);
+  #endif
+
+  initCommon();
   return HMS_MQXXX_OK;
 }
 
 #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
-HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin), type(type) {
-  setDefaultValues();
+HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin) {
+  setDefaultValues(type);
 }
 
 HMS_MQXXX_StatusTypeDef HMS_MQXXX::init() {
   // Initialize Zephyr ADC
+  initCommon();
+  return HMS_MQXXX_OK;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_HOST)
+HMS_MQXXX::HMS_MQXXX(uint8_t pin, HMS_MQXXX_Type type) : pin(pin) {
+  setDefaultValues(type);
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::init() {
+  // Host ADC comes from HMS_MQXXX_SetHostHooks(), nothing to bring up
+  initCommon();
   return HMS_MQXXX_OK;
 }
 #endif
 
-void HMS_MQXXX::setDefaultValues() {
-  switch(type) {
-    case HMS_MQXXX_MQ2:
-      a = HMS_MQXXX_MQ2_A_DEFAULT;
-      b = HMS_MQXXX_MQ2_B_DEFAULT;
-      regression = HMS_MQXXX_MQ2_REGRESSION;
-      break;
-    case HMS_MQXXX_MQ135:
-      a = HMS_MQXXX_MQ135_A_DEFAULT;
-      b = HMS_MQXXX_MQ135_B_DEFAULT;
-      regression = HMS_MQXXX_MQ135_REGRESSION;
-      break;
-    case HMS_MQXXX_MQ131:
-      a = HMS_MQXXX_MQ131_A_DEFAULT;
-      b = HMS_MQXXX_MQ131_B_DEFAULT;
-      regression = HMS_MQXXX_MQ131_REGRESSION;
-      break;
-    case HMS_MQXXX_MQ303A:
-      a = HMS_MQXXX_MQ303A_A_DEFAULT;
-      b = HMS_MQXXX_MQ303A_B_DEFAULT;
-      regression = HMS_MQXXX_MQ303A_REGRESSION;
-      break;
-    default:
-      a = HMS_MQXXX_GENERIC_A_DEFAULT;
-      b = HMS_MQXXX_GENERIC_B_DEFAULT;
-      regression = HMS_MQXXX_GENERIC_REGRESSION;
-      break;
-  }
-  setA(a);
-  setB(b);
+#define HMS_MQXXX_PROFILE(sensor, kind) {                                            \
+    HMS_MQXXX_##sensor##_A_DEFAULT, HMS_MQXXX_##sensor##_B_DEFAULT, 5.0f, 10.0f,             \
+    HMS_MQXXX_ADC_VREF_DEFAULT, HMS_MQXXX_READ_INTERVAL, HMS_MQXXX_READ_RETRIES,             \
+    HMS_MQXXX_ADC_BITS_DEFAULT, (uint8_t)(kind), (uint8_t)HMS_MQXXX_##sensor##_REGRESSION, { 0, 0 } }
+
+// Indexed by HMS_MQXXX_Type; types without an entry fall back to the generic (MQ135) curve
+static const HMS_MQXXX_Profile builtinProfiles[] = {
+  HMS_MQXXX_PROFILE(MQ2,    HMS_MQXXX_MQ2),
+  HMS_MQXXX_PROFILE(MQ131,  HMS_MQXXX_MQ131),
+  HMS_MQXXX_PROFILE(MQ135,  HMS_MQXXX_MQ135),
+  HMS_MQXXX_PROFILE(MQ303A, HMS_MQXXX_MQ303A)
+};
+static const HMS_MQXXX_Profile genericProfile = HMS_MQXXX_PROFILE(GENERIC, HMS_MQXXX_MQ135);
+
+const HMS_MQXXX_Profile *HMS_MQXXX_GetProfile(HMS_MQXXX_Type type) {
+  if((unsigned)type < sizeof(builtinProfiles) / sizeof(builtinProfiles[0])) return &builtinProfiles[type];
+  return &genericProfile;
 }
 
+void HMS_MQXXX::setDefaultValues(HMS_MQXXX_Type sensorType) {
+  const HMS_MQXXX_Profile *defaults = HMS_MQXXX_GetProfile(sensorType);
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  profile = defaults;
+  #else
+  type              = sensorType;
+  regression        = (HMS_MQXXX_Regression)defaults->regression;
+  vcc               = defaults->vcc;
+  rl                = defaults->rl;
+  voltageResolution = defaults->voltageResolution;
+  adcBitResolution  = defaults->adcBitResolution;
+  retries           = defaults->retries;
+  retryInterval     = defaults->retryInterval;
+  setA(defaults->a);
+  setB(defaults->b);
+  #endif
+  applyADCGain(1.0f);
+}
+
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+static_assert(sizeof(HMS_MQXXX) <= HMS_MQXXX_COMPACT_BUDGET, "HMS_MQXXX grew past HMS_MQXXX_COMPACT_BUDGET");
+
+/*
+  Switches the instance to another shared profile. The ADC correction is per-unit, so the gain
+  measured by calibrateADC()/setADCCorrection() survives the swap.
+*/
+void HMS_MQXXX::setProfile(const HMS_MQXXX_Profile *shared) {
+  float gain = getADCGain();
+  profile = (shared != NULL) ? shared : HMS_MQXXX_GetProfile((HMS_MQXXX_Type)profile->type);
+  applyADCGain(gain);
+  readingValid = false;
+}
+#endif
+
+// log10(FLT_MAX) and log10(FLT_MIN) as constants: a static initialised by a call costs a guard check every use
+static constexpr double HMS_MQXXX_LOG10_FLT_MAX = 38.531839419103626;
+static constexpr double HMS_MQXXX_LOG10_FLT_MIN = -37.92977945366163;
+
 static inline bool willOverflow(double log_ppm) {
-  static const double maxLog = log10((double)FLT_MAX);
-  static const double minLog = log10((double)FLT_MIN);
+  constexpr double maxLog = HMS_MQXXX_LOG10_FLT_MAX;
+  constexpr double minLog = HMS_MQXXX_LOG10_FLT_MIN;
   return (log_ppm > maxLog || log_ppm < minLog);
 }
 
+static inline float rsFromVoltage(float voltage, float supply, float rl) {
+  float rs = ((supply * rl) / voltage) - rl;                                // Voltage divider with the load resistor
+  return (rs < 0) ? 0 : rs;                                                 // No negative values accepted.
+}
+
 static inline double safePow(double base, double exp){
   if(exp == 0.0) return 1.0;
   if(exp == 1.0) return base;
@@ -111,9 +250,385 @@ void HMS_MQXXX::mqDelay(uint32_t ms) {
         k_msleep(ms);
     #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
         HAL_Delay(ms);
+    #elif defined(HMS_MQXXX_PLATFORM_HOST)
+        if(hostHooks.delay != NULL) {
+          hostHooks.delay(ms, hostHooks.context);
+        } else {
+          std::this_thread::sleep_for(std::chrono::milliseconds(ms));
+        }
+    #endif
+}
+
+uint32_t HMS_MQXXX_Millis() {
+    #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
+        return millis();
+    #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+        return (uint32_t)(esp_timer_get_time() / 1000);
+    #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+        return k_uptime_get_32();
+    #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+        return HAL_GetTick();
+    #elif defined(HMS_MQXXX_PLATFORM_HOST)
+        if(hostHooks.millis != NULL) return hostHooks.millis(hostHooks.context);
+        static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+        return (uint32_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+    #endif
+}
+
+uint32_t HMS_MQXXX::mqMillis() {
+    return HMS_MQXXX_Millis();
+}
+
+#if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+// Recomputes the combined factor only when the conditions actually change
+void HMS_MQXXX::setEnvironment(float temperature, float humidity) {
+  if(isnan(temperature) || isinf(temperature)) temperature = envTemperature;
+  if(isnan(humidity)    || isinf(humidity))    humidity    = envHumidity;
+  if(temperature == envTemperature && humidity == envHumidity) return;
+
+  envTemperature = temperature;
+  envHumidity    = humidity;
+
+  float factor = 1.0f;
+  #if (HMS_MQXXX_ENABLE_TEMP_COMPENSATION == 1)
+  factor *= HMS_MQXXX_TEMP_FACTOR(temperature, getType());
+  #endif
+  #if (HMS_MQXXX_ENABLE_HUMIDITY_COMPENSATION == 1)
+  factor *= HMS_MQXXX_HUMIDITY_FACTOR(humidity, getType());
+  #endif
+  envFactor = (factor > 0.01f) ? factor : 0.01f;                            // Extreme inputs must not flip the ratio sign
+  readingValid = false;
+}
+
+void HMS_MQXXX::pollEnvironment() {
+  if(envCallback == NULL) return;
+
+  float temperature = envTemperature;
+  float humidity    = envHumidity;
+  if(envCallback(&temperature, &humidity, envContext)) {
+    setEnvironment(temperature, humidity);
+  }
+}
+#endif
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::update() {
+  updateCalibration();
+  #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+  if(warmupState != HMS_MQXXX_WARMUP_READY) {
+    HMS_MQXXX_StatusTypeDef status;
+    float                   voltage = getVoltage(true, false, 0, &status);
+    if(status != HMS_MQXXX_OK) return status;
+    trackWarmup(rsFromVoltage(voltage, sensorSupply(), getRL()));
+  }
+  #endif
+  return HMS_MQXXX_OK;
+}
+
+// Periodic ADC calibration only, for callers that take their own readings (readSensor() feeds the warm-up)
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::updateCalibration() {
+  #if defined(HMS_MQXXX_ADC_CALIBRATION_ENABLED) && (HMS_MQXXX_ADC_CALIBRATION_ENABLED == 1) && (HMS_MQXXX_ADC_CAL_INTERVAL > 0)
+  if(mqMillis() - adcCalTime >= HMS_MQXXX_ADC_CAL_INTERVAL) {
+    calibrateADC();
+  }
+  #endif
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX::initCommon() {
+  #if defined(HMS_MQXXX_ADC_CALIBRATION_ENABLED) && (HMS_MQXXX_ADC_CALIBRATION_ENABLED == 1)
+  calibrateADC();                                                           // Not every platform has a reference
+  #endif
+  #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+  startWarmup();
+  #endif
+  #if defined(HMS_MQXXX_TRACE_ENABLED)
+  HMS_MQXXX_StartTicks();                                                   // Cycle counter behind trace timestamps
+  #endif
+}
+
+// Offset and gain are folded into a single volts-per-code scale so a sample costs one multiply-add
+void HMS_MQXXX::updateADCScale() {
+  applyADCGain(getADCGain());
+}
+
+// Compact builds keep no separate gain, it is recovered from adcScale by getADCGain()
+void HMS_MQXXX::applyADCGain(float gain) {
+  #if !defined(HMS_MQXXX_COMPACT_ENABLED)
+  adcGain  = gain;
+  #endif
+  adcScale = getVoltResolution() * gain / adcFullScale();
+  invalidateCache();                                                        // Cached voltage used the old scale
+}
+
+#if !defined(HMS_MQXXX_COMPACT_ENABLED)
+void HMS_MQXXX::setADCBitResolution(uint8_t bits) {
+  if(bits < 1)  bits = 1;
+  if(bits > 16) bits = 16;                                                  // readADC() yields 16-bit codes
+  adcBitResolution = bits;
+  updateADCScale();
+}
+#endif
+
+void HMS_MQXXX::setADCCorrection(float offset, float gain) {
+  if(isnan(offset) || isinf(offset)) offset = 0.0f;
+  if(isnan(gain) || isinf(gain) || gain <= 0) gain = 1.0f;
+  adcOffset = offset;
+  applyADCGain(gain);
+}
+
+#if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  #if !defined(HMS_MQXXX_STM32_SAMPLETIME)
+    #if defined(ADC_SAMPLETIME_480CYCLES)
+      #define HMS_MQXXX_STM32_SAMPLETIME    ADC_SAMPLETIME_480CYCLES
+    #elif defined(ADC_SAMPLETIME_640CYCLES_5)
+      #define HMS_MQXXX_STM32_SAMPLETIME    ADC_SAMPLETIME_640CYCLES_5
+    #elif defined(ADC_SAMPLETIME_601CYCLES_5)
+      #define HMS_MQXXX_STM32_SAMPLETIME    ADC_SAMPLETIME_601CYCLES_5
+    #elif defined(ADC_SAMPLETIME_239CYCLES_5)
+      #define HMS_MQXXX_STM32_SAMPLETIME    ADC_SAMPLETIME_239CYCLES_5
+    #elif defined(ADC_SAMPLETIME_160CYCLES_5)
+      #define HMS_MQXXX_STM32_SAMPLETIME    ADC_SAMPLETIME_160CYCLES_5
+    #else
+      #define HMS_MQXXX_STM32_SAMPLETIME    0
     #endif
+  #endif
+
+// Longest sampling time is used for both channels: VREFINT needs it and the MQ divider is high impedance
+HAL_StatusTypeDef HMS_MQXXX_STM32SelectChannel(ADC_HandleTypeDef *hadc, uint32_t channel) {
+  ADC_ChannelConfTypeDef config;
+  memset(&config, 0, sizeof(config));
+  config.Channel      = channel;
+  #if defined(ADC_REGULAR_RANK_1)
+  config.Rank         = ADC_REGULAR_RANK_1;
+  #else
+  config.Rank         = 1;
+  #endif
+  config.SamplingTime = HMS_MQXXX_STM32_SAMPLETIME;
+  #if defined(ADC_SINGLE_ENDED)
+  config.SingleDiff   = ADC_SINGLE_ENDED;
+  #endif
+  #if defined(ADC_OFFSET_NONE)
+  config.OffsetNumber = ADC_OFFSET_NONE;
+  #endif
+  return HAL_ADC_ConfigChannel(hadc, &config);
 }
+#endif
+
+/*
+  Measures the real ADC reference against an internal one and derives gain (and offset where the
+  platform calibration provides it):
+    STM32  VREFINT vs its factory VREFINT_CAL word         -> VDDA, needs setADCChannel()
+    ESP32  eFuse line/curve fitting scheme, two codes      -> offset and gain
+    AVR    1.1 V bandgap measured against AVcc             -> Vcc
+  Results outside HMS_MQXXX_ADC_GAIN_MIN..MAX are rejected and the previous correction kept.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::calibrateADC() {
+  #if !defined(HMS_MQXXX_ADC_CALIBRATION_ENABLED) || (HMS_MQXXX_ADC_CALIBRATION_ENABLED == 0)
+  return HMS_MQXXX_NOT_FOUND;
+  #else
+  adcCalTime   = mqMillis();
+  float gain   = getADCGain();
+  float offset = adcOffset;
+
+    #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  if(MQXXX_hadc == NULL || adcChannel == HMS_MQXXX_STM32_NO_CHANNEL) return HMS_MQXXX_NOT_FOUND;
+
+  uint32_t code = 0;
+  if(arbiter != NULL) {
+    uint16_t value = 0;
+    if(arbiter->convert(ADC_CHANNEL_VREFINT, &value) == HMS_MQXXX_OK) code = value;   // Arbiter owns channel switching
+  } else {
+    if(HMS_MQXXX_STM32SelectChannel(MQXXX_hadc, ADC_CHANNEL_VREFINT) == HAL_OK) {
+      HAL_ADC_Start(MQXXX_hadc);
+      if(HAL_ADC_PollForConversion(MQXXX_hadc, 10) == HAL_OK) code = HAL_ADC_GetValue(MQXXX_hadc);
+      HAL_ADC_Stop(MQXXX_hadc);
+    }
+    HMS_MQXXX_STM32SelectChannel(MQXXX_hadc, adcChannel);
+  }
+  if(code == 0) return HMS_MQXXX_ERROR;
+
+  float fullScale = adcFullScale();
+      #if defined(VREFINT_CAL_ADDR)
+        #if defined(VREFINT_CAL_VREF)
+  float calVolts  = VREFINT_CAL_VREF / 1000.0f;
+        #else
+  float calVolts  = HMS_MQXXX_STM32_VREFINT_CAL_MV / 1000.0f;
+        #endif
+  float vrefint   = calVolts * (*VREFINT_CAL_ADDR) / 4095.0f;               // Factory value is a 12-bit code
+      #else
+  float vrefint   = HMS_MQXXX_STM32_VREFINT_TYPICAL_MV / 1000.0f;
+      #endif
+  float vdda      = vrefint * fullScale / (float)code;
+  gain            = vdda / getVoltResolution();
+
+    #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  adc_cali_handle_t handle = NULL;
+  esp_err_t         err    = ESP_ERR_NOT_SUPPORTED;
+      #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+  adc_cali_curve_fitting_config_t config = {};
+  config.unit_id  = adcUnit;
+  config.chan     = adcChannel;
+  config.atten    = HMS_MQXXX_ESP_ADC_ATTEN;
+  config.bitwidth = HMS_MQXXX_ESP_ADC_BITWIDTH;
+  err = adc_cali_create_scheme_curve_fitting(&config, &handle);
+      #elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+  adc_cali_line_fitting_config_t config = {};
+  config.unit_id  = adcUnit;
+  config.atten    = HMS_MQXXX_ESP_ADC_ATTEN;
+  config.bitwidth = HMS_MQXXX_ESP_ADC_BITWIDTH;
+  err = adc_cali_create_scheme_line_fitting(&config, &handle);
+      #endif
+  if(err != ESP_OK) return HMS_MQXXX_NOT_FOUND;                             // eFuse values not burnt
+
+  int fullScale = (1 << getADCBitResolution()) - 1;
+  int lowCode   = fullScale / 8;                                            // Linearise inside the usable range
+  int highCode  = fullScale - lowCode;
+  int lowMv     = 0;
+  int highMv    = 0;
+  err = adc_cali_raw_to_voltage(handle, lowCode, &lowMv);
+  if(err == ESP_OK) err = adc_cali_raw_to_voltage(handle, highCode, &highMv);
+      #if ADC_CALI_SCHEME_CURVE_FITTING_SUPPORTED
+  adc_cali_delete_scheme_curve_fitting(handle);
+      #elif ADC_CALI_SCHEME_LINE_FITTING_SUPPORTED
+  adc_cali_delete_scheme_line_fitting(handle);
+      #endif
+  if(err != ESP_OK || highMv <= lowMv) return HMS_MQXXX_ERROR;
+
+  float voltsPerCode = (highMv - lowMv) / 1000.0f / (float)(highCode - lowCode);
+  offset             = lowMv / 1000.0f - lowCode * voltsPerCode;
+  gain               = voltsPerCode * fullScale / getVoltResolution();
+
+    #elif defined(HMS_MQXXX_PLATFORM_ARDUINO) && defined(__AVR__) && defined(ADMUX)
+  uint8_t savedMux = ADMUX;
+      #if defined(__AVR_ATmega32U4__) || defined(__AVR_ATmega1280__) || defined(__AVR_ATmega2560__)
+  ADMUX = _BV(REFS0) | _BV(MUX4) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+      #else
+  ADMUX = _BV(REFS0) | _BV(MUX3) | _BV(MUX2) | _BV(MUX1);
+      #endif
+  delay(2);                                                                 // Let the bandgap settle on the mux
+  ADCSRA |= _BV(ADSC);
+  while(bit_is_set(ADCSRA, ADSC));
+  uint16_t code = ADC;
+  ADMUX = savedMux;
+  if(code == 0) return HMS_MQXXX_ERROR;
 
+  float vcc = (HMS_MQXXX_AVR_BANDGAP_MV / 1000.0f) * 1023.0f / (float)code;
+  gain      = vcc / getVoltResolution();
+
+    #else
+  (void)gain; (void)offset;
+  return HMS_MQXXX_NOT_FOUND;                                               // Use setADCCorrection() instead
+    #endif
+
+  if(gain < HMS_MQXXX_ADC_GAIN_MIN || gain > HMS_MQXXX_ADC_GAIN_MAX) return HMS_MQXXX_ERROR;
+  setADCCorrection(offset, gain);
+  return HMS_MQXXX_OK;
+  #endif
+}
+
+#if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+void HMS_MQXXX::startWarmup() {
+  warmupState    = HMS_MQXXX_WARMUP_COLD;
+  warmupStable   = 0;
+  warmupStart    = mqMillis();
+  warmupLast     = warmupStart;
+  warmupInterval = 0;
+  warmupRs       = 0;
+  warmupSlope    = 0;
+  warmupVariance = 0;
+  warmupTau      = 0;
+}
+
+/*
+  Heater warm-up looks like an exponential approach of Rs to its clean-air value. Each sample
+  updates a smoothed Rs, its relative slope and the variance of the raw sample around it. The
+  sensor is declared ready after HMS_MQXXX_WARMUP_STABLE_SAMPLES consecutive samples that are
+  both flat and quiet (and not before HMS_MQXXX_WARMUP_MIN_TIME), or unconditionally once the
+  datasheet preheat time has passed. The slope's decay rate gives the time constant for the ETA.
+*/
+void HMS_MQXXX::trackWarmup(float rs) {
+  uint32_t now     = mqMillis();
+  uint32_t elapsed = now - warmupStart;
+
+  if(elapsed >= (uint32_t)HMS_MQXXX_GET_PREHEAT_TIME(getType()) * 1000UL) {
+    warmupState = HMS_MQXXX_WARMUP_READY;                                   // Worst case timer always wins
+    return;
+  }
+
+  if(warmupState == HMS_MQXXX_WARMUP_COLD || warmupRs <= 0) {
+    if(rs > 0) {
+      warmupRs    = rs;
+      warmupLast  = now;
+      warmupState = HMS_MQXXX_WARMUP_HEATING;
+    }
+    return;
+  }
+
+  uint32_t deltaMs = now - warmupLast;
+  if(deltaMs == 0) return;
+  float dt = deltaMs / 1000.0f;
+
+  const float alpha   = HMS_MQXXX_WARMUP_ALPHA;
+  float deviation     = (rs - warmupRs) / warmupRs;
+  float smoothedRs    = warmupRs + alpha * (rs - warmupRs);
+  float slope         = (smoothedRs - warmupRs) / warmupRs / dt;
+  float previousSlope = warmupSlope;
+
+  warmupSlope    += alpha * (slope - warmupSlope);
+  warmupVariance  = (1.0f - alpha) * (warmupVariance + alpha * deviation * deviation);
+  warmupRs        = smoothedRs;
+  warmupInterval  = (warmupInterval == 0) ? deltaMs : (uint32_t)(warmupInterval + alpha * ((float)deltaMs - warmupInterval));
+  warmupLast      = now;
+
+  float magnitude = fabsf(warmupSlope);
+  float previous  = fabsf(previousSlope);
+  if(magnitude > 0 && previous > magnitude) {
+    float tau = dt / logf(previous / magnitude);
+    warmupTau = (warmupTau == 0) ? tau : warmupTau + alpha * (tau - warmupTau);
+  }
+
+  bool flat  = magnitude <= HMS_MQXXX_WARMUP_SLOPE_LIMIT;
+  bool quiet = warmupVariance <= HMS_MQXXX_WARMUP_NOISE_LIMIT * HMS_MQXXX_WARMUP_NOISE_LIMIT;
+  if(flat && quiet) {
+    if(warmupStable < UINT8_MAX) warmupStable++;
+    warmupState = HMS_MQXXX_WARMUP_SETTLING;
+  } else {
+    warmupStable = 0;
+    warmupState  = HMS_MQXXX_WARMUP_HEATING;
+  }
+
+  if(warmupStable >= HMS_MQXXX_WARMUP_STABLE_SAMPLES && elapsed >= HMS_MQXXX_WARMUP_MIN_TIME * 1000UL) {
+    warmupState = HMS_MQXXX_WARMUP_READY;
+  }
+}
+
+// Seconds until the sensor is expected to be ready, never more than the remaining preheat time
+uint32_t HMS_MQXXX::getWarmupETA() const {
+  if(warmupState == HMS_MQXXX_WARMUP_READY) return 0;
+
+  uint32_t elapsed    = (warmupLast - warmupStart) / 1000UL;
+  uint32_t preheat    = HMS_MQXXX_GET_PREHEAT_TIME(getType());
+  uint32_t cap        = (elapsed < preheat) ? preheat - elapsed : 0;
+  uint32_t minimum    = (elapsed < HMS_MQXXX_WARMUP_MIN_TIME) ? HMS_MQXXX_WARMUP_MIN_TIME - elapsed : 0;
+  float    streak     = (float)(HMS_MQXXX_WARMUP_STABLE_SAMPLES - (warmupStable < HMS_MQXXX_WARMUP_STABLE_SAMPLES ? warmupStable : HMS_MQXXX_WARMUP_STABLE_SAMPLES));
+  float    estimate   = streak * warmupInterval / 1000.0f;
+
+  if(warmupState == HMS_MQXXX_WARMUP_HEATING) {
+    float magnitude = fabsf(warmupSlope);
+    if(warmupTau <= 0 || magnitude <= 0) return cap;                         // No decay observed yet
+    if(magnitude > HMS_MQXXX_WARMUP_SLOPE_LIMIT) {
+      estimate += warmupTau * logf(magnitude / HMS_MQXXX_WARMUP_SLOPE_LIMIT);
+    }
+  }
+
+  uint32_t eta = (uint32_t)(estimate + 0.5f);
+  if(eta < minimum) eta = minimum;
+  if(eta > cap)     eta = cap;
+  return eta;
+}
+#endif
+
+#if !defined(HMS_MQXXX_COMPACT_ENABLED)
 void HMS_MQXXX::setA(float value) {
   if(isinf(value) || isnan(value)) {
     a = 0;
@@ -124,6 +639,7 @@ void HMS_MQXXX::setA(float value) {
   } else {
     a = value;
   }
+  readingValid = false;
 }
 
 void HMS_MQXXX::setB(float value) {
@@ -136,154 +652,654 @@ void HMS_MQXXX::setB(float value) {
   } else {
     b = value;
   }
+  readingValid = false;
 }
+#endif
 
 float HMS_MQXXX::setRsR0RatioGetPPM(float value) {
   return setRatioAndGetPPM(value);
 }
 
 float HMS_MQXXX::getRS() {
-  sensorVolt = getVoltage(true, false, 0);                                 // Read the voltage from the sensor
-  rsCalc = ((vcc * rl) / sensorVolt) - rl;                              // Get value of RS in a gas
-  if(rsCalc < 0)  rsCalc = 0;                                           // No negative values accepted.
-  return rsCalc;
+  return rsFromVoltage(sampleVoltage(), getVCC(), getRL());                          // Read the voltage and get RS in a gas
 }
 
-float HMS_MQXXX::getVoltage(bool read, bool injected, int value) {
+// Sample younger than the cache max-age, so consumers close together share one acquisition
+bool HMS_MQXXX::voltageFresh() {
+  return cacheMaxAge > 0 && voltageValid && (uint32_t)(mqMillis() - voltageTime) < cacheMaxAge;
+}
+
+float HMS_MQXXX::sampleVoltage() {
+  return voltageFresh() ? cachedVoltage() : getVoltage(true, false, 0);
+}
+
+// One raw conversion, through the shared-ADC arbiter when one is attached; ERROR when it failed or timed out
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::readADC(uint16_t *code) {
+  if(arbiter != NULL) {
+    return arbiter->convert(arbiterChannel, code);
+  }
+  #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
+  *code = analogRead(pin);
+  #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  // STM32 HAL ADC reading - assumes ADC is configured in CubeMX
+  HAL_ADC_Start(MQXXX_hadc);
+  if(HAL_ADC_PollForConversion(MQXXX_hadc, 10) != HAL_OK) return HMS_MQXXX_ERROR;
+  *code = (uint16_t)HAL_ADC_GetValue(MQXXX_hadc); // User needs to adapt this
+  #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  int raw = 0;
+  if(espAdcUnits[adcUnit] == NULL || adc_oneshot_read(espAdcUnits[adcUnit], adcChannel, &raw) != ESP_OK) return HMS_MQXXX_ERROR;
+  *code = (uint16_t)raw;
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
+  // Zephyr ADC reading - needs ADC device binding
+  *code = 2048; // Placeholder - needs actual Zephyr implementation
+  #elif defined(HMS_MQXXX_PLATFORM_HOST)
+  *code = (hostHooks.readADC != NULL) ? hostHooks.readADC(pin, hostHooks.context) : (uint16_t)(1 << (getADCBitResolution() - 1));
+  #endif
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX::setArbiter(HMS_MQXXX_Arbiter *shared, uint32_t channel) {
+  arbiter        = shared;
+  arbiterChannel = channel;
+  #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  adcChannel     = channel;                                                 // Also the channel calibrateADC() returns to
+  #endif
+  invalidateCache();
+}
+
+/*
+  Averages readRetries() conversions. A conversion that fails (arbiter timeout, ADC error) is
+  left out of the average rather than counted as code 0; when none succeeds the sample is
+  ERROR, the voltage NAN, and the previous sample stays the cached one.
+*/
+float HMS_MQXXX::getVoltage(bool read, bool injected, int value, HMS_MQXXX_StatusTypeDef *status) {
   float voltage;
+  if(status != NULL) *status = HMS_MQXXX_OK;
   if(read) {
-    float avg = 0.0;
+    float   avg       = 0.0;
+    uint8_t converted = 0;
 
+    uint8_t retries = readRetries();
+    HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_SAMPLE_BEGIN, traceId, retries, readInterval());
     for (int i = 0; i < retries; i++) {
-        #if defined(HMS_MQXXX_PLATFORM_ARDUINO)
-            adc = analogRead(pin);
-        #elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
-            // STM32 HAL ADC reading - assumes ADC is configured in CubeMX
-            HAL_ADC_Start(MQXXX_hadc);
-            HAL_ADC_PollForConversion(MQXXX_hadc, 10);
-            adc = HAL_ADC_GetValue(MQXXX_hadc); // User needs to adapt this
-            //adc = 2048; // Placeholder - needs actual HAL implementation
-        #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
-            // ESP-IDF ADC reading - needs ADC configuration
-            adc = 2048; // Placeholder - needs actual ESP-IDF implementation
-        #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR)
-            // Zephyr ADC reading - needs ADC device binding
-            adc = 2048; // Placeholder - needs actual Zephyr implementation
-        #endif
-        avg += adc;
-        mqDelay(retryInterval);
+        HMS_MQXXX_CYCLES_BEGIN(acquireStart);
+        uint16_t code;
+        if(readADC(&code) == HMS_MQXXX_OK) {
+          adc  = code;
+          avg += code;
+          converted++;
+        }
+        HMS_MQXXX_CYCLES_END(HMS_MQXXX_STAGE_ACQUIRE, acquireStart);
+        HMS_MQXXX_CYCLES_BEGIN(delayStart);
+        mqDelay(readInterval());
+        HMS_MQXXX_CYCLES_END(HMS_MQXXX_STAGE_DELAY, delayStart);
     }
     #if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
-    HAL_ADC_Stop(MQXXX_hadc);
+    if(arbiter == NULL) HAL_ADC_Stop(MQXXX_hadc);
     #endif
+    if(converted == 0) {
+      if(status != NULL) *status = HMS_MQXXX_ERROR;
+      return NAN;
+    }
 
-    voltage = (avg / retries) * voltageResolution / ((pow(2, adcBitResolution)) - 1);
-    sensorVolt = voltage; // Update the sensor voltage
+    HMS_MQXXX_CYCLES_BEGIN(averageStart);
+    voltage = codeToVoltage(avg / converted);
+    HMS_MQXXX_CYCLES_END(HMS_MQXXX_STAGE_AVERAGE, averageStart);
+    HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_SAMPLE_END, traceId, HMS_MQXXX_TraceFloat(avg / converted), HMS_MQXXX_TraceFloat(voltage));
+    keepVoltage(voltage); // Update the sensor voltage
   }
   else if(injected) {
     // External voltage injection (for testing or external ADC)
-    voltage = (value) * voltageResolution / ((pow(2, adcBitResolution)) - 1);
-    sensorVolt = voltage;
+    voltage = codeToVoltage(value);
+    keepVoltage(voltage);
   } else {
     // Return cached voltage
-    voltage = sensorVolt;
+    voltage = cachedVoltage();
   }
   return voltage;
 }
 
-// Simplified read sensor function - always reads fresh data
+// Acquires unless the last sample is younger than the cache max-age (setCacheMaxAge())
 float HMS_MQXXX::readSensor(float correctionFactor) {
-  // Special voltage adjustment for MQ303A
-  if(type == HMS_MQXXX_MQ303A) {
-    vcc = vcc - 0.45; // Adjust VCC for MQ303A calculations
+  if(voltageFresh()) {
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+    if(readingValid) {
+      // No ppm cache: reconvert the published sample (the correction may differ), publish nothing
+      float ppm = convertVoltage(cachedVoltage(), correctionFactor, voltageTime).ppm;
+      HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_CACHE_HIT, traceId, HMS_MQXXX_TraceFloat(ppm), mqMillis() - voltageTime);
+      return ppm;
+    }
+    #else
+    if(readingValid && correctionFactor == cachedCorrection) {
+      HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_CACHE_HIT, traceId, HMS_MQXXX_TraceFloat(cachedPPM), mqMillis() - voltageTime);
+      return cachedPPM;                                                     // Same sample, same config
+    }
+    #endif
+    return finishReading(cachedVoltage(), correctionFactor, voltageTime).ppm;  // Config changed, no new acquisition
   }
+  HMS_MQXXX_CYCLES_BEGIN(readingStart);
+  HMS_MQXXX_StatusTypeDef status;
+  float                   voltage = getVoltage(true, false, 0, &status);
+  float                   ppm     = (status == HMS_MQXXX_OK) ? processVoltage(voltage, correctionFactor).ppm : failReading().ppm;
+  HMS_MQXXX_CYCLES_END(HMS_MQXXX_STAGE_READING, readingStart);
+  return ppm;
+}
 
-  // Get fresh sensor resistance reading
-  getRS();
+/*
+  Entry point for voltages acquired outside getVoltage() (Zephyr ADC API, external ADC, shared
+  ADC arbiter). Does everything readSensor() does after acquisition: warm-up tracking, environment
+  poll, conversion and publishing. Only the acquisition task may call it (seqlock writer).
+*/
+HMS_MQXXX_Reading HMS_MQXXX::processVoltage(float voltage, float correctionFactor) {
+  observeVoltage(voltage);
+  #if !defined(HMS_MQXXX_COMPACT_ENABLED)
+  sensorVolt = voltage;                                                     // May come from outside getVoltage()
+  #endif
+  stampVoltage();                                                           // Compact: finishReading() publishes the voltage
+  return finishReading(voltage, correctionFactor, mqMillis());
+}
+
+HMS_MQXXX_Reading HMS_MQXXX::finishReading(float voltage, float correctionFactor, uint32_t timestamp) {
+  HMS_MQXXX_Reading reading = convertReading(voltage, correctionFactor, timestamp, true);
+  HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_READING, traceId, HMS_MQXXX_TraceFloat(reading.ppm), HMS_MQXXX_TraceFloat(reading.ratio));
+  publishReading(reading);
+  #if !defined(HMS_MQXXX_COMPACT_ENABLED)
+  cachedPPM        = reading.ppm;
+  cachedCorrection = correctionFactor;
+  #endif
+  readingValid     = true;
+  return reading;
+}
+
+// No conversion succeeded: listeners and snapshot readers see an ERROR reading, not a stale one
+HMS_MQXXX_Reading HMS_MQXXX::failReading() {
+  HMS_MQXXX_Reading reading;
+  memset(&reading, 0, sizeof(reading));
+  reading.timestamp = mqMillis();
+  reading.voltage   = NAN;
+  reading.rs        = NAN;
+  reading.ratio     = NAN;
+  reading.ppm       = NAN;
+  reading.status    = HMS_MQXXX_ERROR;
+  publishReading(reading);
+  readingValid      = false;
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  voltageValid      = false;                                                // The snapshot no longer holds the sample
+  #endif
+  return reading;
+}
+
+// State bookkeeping for a fresh sample without converting it (streaming paths convert later)
+void HMS_MQXXX::observeVoltage(float voltage) {
+  #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+  if(warmupState != HMS_MQXXX_WARMUP_READY) trackWarmup(rsFromVoltage(voltage, sensorSupply(), getRL()));
+  #else
+  (void)voltage;
+  #endif
+
+  #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+  pollEnvironment();
+  #endif
+}
+
+/*
+  Pure conversion of a sensor voltage into a full reading. Only reads configuration, so any
+  number of tasks may call it concurrently; the MQ-303A supply drop is applied locally.
+*/
+HMS_MQXXX_Reading HMS_MQXXX::convertVoltage(float voltage, float correctionFactor, uint32_t timestamp) const {
+  return convertReading(voltage, correctionFactor, timestamp, false);
+}
+
+// `timed` only from the acquisition task: the cycle histograms are not safe to record from several tasks
+HMS_MQXXX_Reading HMS_MQXXX::convertReading(float voltage, float correctionFactor, uint32_t timestamp, bool timed) const {
+  HMS_MQXXX_Reading reading;
+  memset(&reading, 0, sizeof(reading));
+  reading.timestamp = timestamp;
+  reading.voltage   = voltage;
+  HMS_MQXXX_CYCLES_BEGIN_IF(timed, rsStart);
+  reading.rs        = rsFromVoltage(voltage, sensorSupply(), getRL());
+  HMS_MQXXX_CYCLES_END_IF(timed, HMS_MQXXX_STAGE_RS, rsStart);
 
   // Automatic ratio calculation based on sensor type
-  if(type == HMS_MQXXX_MQ131) {
-    ratio = r0 / rsCalc;        // R0/Rs ratio for MQ-131 (inverted)
+  HMS_MQXXX_CYCLES_BEGIN_IF(timed, ratioStart);
+  float value;
+  if(getType() == HMS_MQXXX_MQ131) {
+    value = r0 / reading.rs;    // R0/Rs ratio for MQ-131 (inverted)
   } else {
-    ratio = rsCalc / r0;        // Rs/R0 ratio for other sensors (MQ-2, MQ-135, MQ-303A)
+    value = reading.rs / r0;    // Rs/R0 ratio for other sensors (MQ-2, MQ-135, MQ-303A)
   }
-  
-  ratio += correctionFactor;
-  if(ratio <= 0) ratio = 0.001; // Prevent division by zero, use small positive value
+
+  #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+  // Bring Rs back to the 20 °C / 60 %RH baseline the curves were measured at
+  if(getType() == HMS_MQXXX_MQ131) {
+    value *= envFactor;
+  } else {
+    value /= envFactor;
+  }
+  #endif
+
+  value += correctionFactor;
+  if(value <= 0) value = 0.001; // Prevent division by zero, use small positive value
+  reading.ratio = value;
+  HMS_MQXXX_CYCLES_END_IF(timed, HMS_MQXXX_STAGE_RATIO, ratioStart);
+
+  #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+  if(warmupState != HMS_MQXXX_WARMUP_READY) reading.flags |= HMS_MQXXX_FLAG_WARMUP;
+  #endif
+
+  reading.status = (getA() == 0) ? HMS_MQXXX_ERROR : HMS_MQXXX_OK;
+  HMS_MQXXX_CYCLES_BEGIN_IF(timed, curveStart);
+  reading.ppm    = ratioToPPM(value, &reading.flags);
+  HMS_MQXXX_CYCLES_END_IF(timed, HMS_MQXXX_STAGE_CURVE, curveStart);
+  #if defined(HMS_MQXXX_TRACE_ENABLED)
+  if(reading.flags & HMS_MQXXX_FLAG_SATURATED) {
+    HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_SATURATED, traceId, HMS_MQXXX_TraceFloat(value), HMS_MQXXX_TraceFloat(reading.ppm));
+  }
+  #endif
+  return reading;
+}
+
+static float curveDouble(HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags) {
+  if(ratioValue <= 0 || a == 0) return 0;
 
   double tempPPM, logPPM;
   if(regression == HMS_MQXXX_EXPONENTIAL) {
-    if(ratio <= 0 || a == 0) return 0;
     // PPM = a * ratio^b (exponential form)
-    logPPM = log10((double)a) + (double)b * log10((double)ratio);
-    if(willOverflow(logPPM)) 
-      tempPPM = (logPPM > 0) ? FLT_MAX : 0.0;
-    else 
-      tempPPM = safePow(10.0, logPPM);
+    logPPM = log10((double)a) + (double)b * log10((double)ratioValue);
   } else {
-    if(ratio <= 0 || a == 0) return 0;
     // PPM = 10^((log(ratio) - b) / a) (linear form)
-    logPPM = (log10((double)ratio) - (double)b)/(double)a;
-    if(willOverflow(logPPM)) 
-      tempPPM = (logPPM > 0) ? FLT_MAX : 0.0;
-    else 
-      tempPPM = safePow(10.0, logPPM);
+    logPPM = (log10((double)ratioValue) - (double)b)/(double)a;
   }
 
-  // Restore VCC if it was adjusted
-  if(type == HMS_MQXXX_MQ303A) {
-    vcc = vcc + 0.45;
+  if(willOverflow(logPPM)) {
+    tempPPM = (logPPM > 0) ? FLT_MAX : 0.0;
+    if(flags != NULL) *flags |= HMS_MQXXX_FLAG_SATURATED;
+  } else {
+    tempPPM = safePow(10.0, logPPM);
   }
 
   if(tempPPM < 0) tempPPM = 0;
   if(isinf(tempPPM) || isnan(tempPPM)) tempPPM = FLT_MAX;
+  return (float)tempPPM;
+}
 
-  ppm = (float)tempPPM;
+static float curveFloat(HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags) {
+  constexpr float maxLog = (float)HMS_MQXXX_LOG10_FLT_MAX;
+  constexpr float minLog = (float)HMS_MQXXX_LOG10_FLT_MIN;
+  if(ratioValue <= 0 || a == 0) return 0;
+
+  float ppm, logPPM;
+  if(regression == HMS_MQXXX_EXPONENTIAL) {
+    logPPM = log10f(a) + b * log10f(ratioValue);
+  } else {
+    logPPM = (log10f(ratioValue) - b) / a;
+  }
+
+  if(logPPM > maxLog || logPPM < minLog) {
+    ppm = (logPPM > 0) ? FLT_MAX : 0.0f;
+    if(flags != NULL) *flags |= HMS_MQXXX_FLAG_SATURATED;
+  } else {
+    ppm = powf(10.0f, logPPM);
+  }
+
+  if(ppm < 0) ppm = 0;
+  if(isinf(ppm) || isnan(ppm)) ppm = FLT_MAX;
   return ppm;
 }
 
+// log2 of a positive normal float: exponent from the bits, atanh series on the mantissa in [0.707, 1.414)
+static inline float fastLog2(float x) {
+  uint32_t bits;
+  memcpy(&bits, &x, sizeof(bits));
+  int   exponent = (int)((bits >> 23) & 0xFF) - 127;
+  bits = (bits & 0x007FFFFFUL) | 0x3F800000UL;
+  float mantissa;
+  memcpy(&mantissa, &bits, sizeof(mantissa));
+  if(mantissa > 1.41421356f) {
+    mantissa *= 0.5f;
+    exponent++;
+  }
+  float t  = (mantissa - 1.0f) / (mantissa + 1.0f);
+  float t2 = t * t;
+  float ln = 2.0f * t * (1.0f + t2 * (1.0f / 3 + t2 * (1.0f / 5 + t2 * (1.0f / 7))));
+  return (float)exponent + ln * 1.44269504f;
+}
+
+// 2^x for -126 <= x < 128: rounded integer part into the exponent bits, Taylor series on the rest
+static inline float fastExp2(float x) {
+  int   whole = (int)(x + ((x >= 0) ? 0.5f : -0.5f));
+  float y     = (x - (float)whole) * 0.693147181f;                           // |y| <= ln2 / 2
+  float power = 1.0f + y * (1.0f + y * (0.5f + y * (1.0f / 6 + y * (1.0f / 24 + y * (1.0f / 120 + y * (1.0f / 720))))));
+  if(whole > 127) {
+    whole--;
+    power *= 2.0f;
+  }
+  uint32_t bits = (uint32_t)(whole + 127) << 23;
+  float    scale;
+  memcpy(&scale, &bits, sizeof(scale));
+  return power * scale;
+}
+
+static float curveFast(HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags) {
+  if(ratioValue <= 0 || a == 0) return 0;
+  bool exponential = (regression == HMS_MQXXX_EXPONENTIAL);
+  if(!(ratioValue >= FLT_MIN && ratioValue <= FLT_MAX) || isnan(b) || isinf(b) ||
+     (exponential && !(a >= FLT_MIN && a <= FLT_MAX))) {
+    return curveFloat(regression, a, b, ratioValue, flags);                // Subnormal, non-finite or log of a <= 0
+  }
+
+  float log2PPM;
+  if(exponential) {
+    log2PPM = fastLog2(a) + b * fastLog2(ratioValue);
+  } else {
+    log2PPM = (fastLog2(ratioValue) * 0.301029996f - b) / a * 3.32192809f;
+  }
+  if(isnan(log2PPM)) return FLT_MAX;
+  if(log2PPM >= 128.0f || log2PPM < -126.0f) {                              // Same bounds as willOverflow(), in log2
+    if(flags != NULL) *flags |= HMS_MQXXX_FLAG_SATURATED;
+    return (log2PPM > 0) ? FLT_MAX : 0.0f;
+  }
+  float ppm = fastExp2(log2PPM);
+  return (isinf(ppm) || isnan(ppm)) ? FLT_MAX : ppm;
+}
+
+float HMS_MQXXX_CurveToPPM(HMS_MQXXX_MathMode mode, HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags) {
+  switch(mode) {
+    case HMS_MQXXX_MATH_FLOAT:  return curveFloat(regression, a, b, ratioValue, flags);
+    case HMS_MQXXX_MATH_FAST:   return curveFast(regression, a, b, ratioValue, flags);
+    default:                    return curveDouble(regression, a, b, ratioValue, flags);
+  }
+}
+
+static inline float curveToPPM(HMS_MQXXX_Regression regression, float a, float b, float ratioValue, uint8_t *flags) {
+  #if (HMS_MQXXX_MATH_MODE == 1)
+  return curveFloat(regression, a, b, ratioValue, flags);
+  #elif (HMS_MQXXX_MATH_MODE == 2)
+  return curveFast(regression, a, b, ratioValue, flags);
+  #else
+  return curveDouble(regression, a, b, ratioValue, flags);
+  #endif
+}
+
+float HMS_MQXXX::ratioToPPM(float ratioValue, uint8_t *flags) const {
+  return curveToPPM(getRegressionMethod(), getA(), getB(), ratioValue, flags);
+}
+
+/*
+  Every gas of this sensor type from one ratio, in HMS_MQXXX_GetGasCurves() order. Returns the
+  number of entries written; the active a/b coefficients are not involved.
+*/
+uint8_t HMS_MQXXX::evaluateGases(float ratioValue, float *ppm, uint8_t maxCount, uint8_t *flags) const {
+  uint8_t count;
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(getType(), &count);
+  if(ppm == NULL) return 0;
+  if(count > maxCount) count = maxCount;
+  for(uint8_t i = 0; i < count; i++) {
+    ppm[i] = curveToPPM(curves[i].regression, curves[i].a, curves[i].b, ratioValue, flags);
+  }
+  return count;
+}
+
 // Function to set ratio manually and calculate PPM (for external calculations)
 float HMS_MQXXX::setRatioAndGetPPM(float ratioValue) {
-  ratio = ratioValue;
-  
-  double tempPPM, logPPM;
-  if(regression == HMS_MQXXX_EXPONENTIAL) {
-    if(ratio <= 0 || a == 0) return 0;
-    logPPM = log10((double)a) + (double)b * log10((double)ratio);
-    if(willOverflow(logPPM)) 
-      tempPPM = (logPPM > 0) ? FLT_MAX : 0.0;
-    else 
-      tempPPM = safePow(10.0, logPPM);
-  } else {
-    if(ratio <= 0 || a == 0) return 0;
-    logPPM = (log10((double)ratio) - (double)b)/(double)a;
-    if(willOverflow(logPPM)) 
-      tempPPM = (logPPM > 0) ? FLT_MAX : 0.0;
-    else 
-      tempPPM = safePow(10.0, logPPM);
+  return ratioToPPM(ratioValue);
+}
+
+/*
+  Seqlock writer. Only the acquisition task calls this, so the sequence needs no RMW: it goes
+  odd before the payload is touched and even (release) once it is complete.
+*/
+static_assert(sizeof(HMS_MQXXX_Snapshot) % sizeof(HMS_MQXXX_SeqWord) == 0, "Reading must copy as whole sequence words");
+
+void HMS_MQXXX::publishReading(const HMS_MQXXX_Reading &reading) {
+  HMS_MQXXX_SeqWord words[sizeof(latestWords) / sizeof(latestWords[0])];
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  HMS_MQXXX_Snapshot snapshot;
+  memset(&snapshot, 0, sizeof(snapshot));
+  snapshot.timestamp = reading.timestamp;
+  snapshot.voltage   = reading.voltage;
+  snapshot.ratio     = reading.ratio;
+  snapshot.ppm       = reading.ppm;
+  snapshot.status    = reading.status;
+  snapshot.flags     = reading.flags;
+  memcpy(words, &snapshot, sizeof(words));
+  #else
+  memcpy(words, &reading, sizeof(words));
+  #endif
+
+  HMS_MQXXX_SeqWord seq = __atomic_load_n(&latestSeq, __ATOMIC_RELAXED);
+  __atomic_store_n(&latestSeq, (HMS_MQXXX_SeqWord)(seq + 1), __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+  for(size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+    __atomic_store_n(&latestWords[i], words[i], __ATOMIC_RELAXED);
   }
+  HMS_MQXXX_SeqWord next = (HMS_MQXXX_SeqWord)(seq + 2);
+  __atomic_store_n(&latestSeq, (next == 0) ? (HMS_MQXXX_SeqWord)2 : next, __ATOMIC_RELEASE);   // 0 stays "never published"
 
-  if(tempPPM < 0) tempPPM = 0;
-  if(isinf(tempPPM) || isnan(tempPPM)) tempPPM = FLT_MAX;
+  for(HMS_MQXXX_Listener *listener = listeners; listener != NULL; listener = listener->next) {
+    if(listener->callback != NULL) listener->callback(&reading, listener->context);
+  }
+}
 
-  ppm = (float)tempPPM;
-  return ppm;
+void HMS_MQXXX::publishEvent(HMS_MQXXX_Event event, float value, float aux) {
+  if(listeners == NULL) return;
+  uint32_t timestamp = mqMillis();
+  for(HMS_MQXXX_Listener *listener = listeners; listener != NULL; listener = listener->next) {
+    if(listener->event != NULL) listener->event(event, timestamp, value, aux, listener->context);
+  }
+}
+
+void HMS_MQXXX::addListener(HMS_MQXXX_Listener *listener) {
+  if(listener == NULL) return;
+  removeListener(listener);                                                 // Attaching twice must not loop the list
+  listener->next = listeners;
+  listeners      = listener;
+}
+
+void HMS_MQXXX::removeListener(HMS_MQXXX_Listener *listener) {
+  for(HMS_MQXXX_Listener **link = &listeners; *link != NULL; link = &(*link)->next) {
+    if(*link == listener) {
+      *link          = listener->next;
+      listener->next = NULL;
+      return;
+    }
+  }
+}
+
+/*
+  Seqlock reader. Lock-free and safe from any task or ISR; returns false when nothing has been
+  published yet or the writer kept overlapping the copy (a higher priority reader must not spin
+  on a preempted writer).
+*/
+bool HMS_MQXXX::getLatestReading(HMS_MQXXX_Reading *reading) const {
+  if(reading == NULL) return false;
+
+  HMS_MQXXX_SeqWord words[sizeof(latestWords) / sizeof(latestWords[0])];
+  for(uint8_t attempt = 0; attempt < HMS_MQXXX_SNAPSHOT_RETRIES; attempt++) {
+    HMS_MQXXX_SeqWord begin = __atomic_load_n(&latestSeq, __ATOMIC_ACQUIRE);
+    if(begin == 0) return false;
+    if(begin & 1) continue;
+    for(size_t i = 0; i < sizeof(words) / sizeof(words[0]); i++) {
+      words[i] = __atomic_load_n(&latestWords[i], __ATOMIC_RELAXED);
+    }
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&latestSeq, __ATOMIC_RELAXED) == begin) {
+      #if defined(HMS_MQXXX_COMPACT_ENABLED)
+      HMS_MQXXX_Snapshot snapshot;
+      memcpy(&snapshot, words, sizeof(snapshot));
+      memset(reading, 0, sizeof(*reading));
+      reading->timestamp = snapshot.timestamp;
+      reading->voltage   = snapshot.voltage;
+      reading->rs        = rsFromVoltage(snapshot.voltage, sensorSupply(), getRL());   // NAN voltage gives NAN
+      reading->ratio     = snapshot.ratio;
+      reading->ppm       = snapshot.ppm;
+      reading->status    = snapshot.status;
+      reading->flags     = snapshot.flags;
+      #else
+      memcpy(reading, words, sizeof(*reading));
+      #endif
+      return true;
+    }
+  }
+  return false;
+}
+
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+// Writer side of the seqlock, so the copy never races; only called while voltageValid
+float HMS_MQXXX::cachedVoltage() const {
+  HMS_MQXXX_Reading reading;
+  return getLatestReading(&reading) ? reading.voltage : NAN;
+}
+#endif
+
+uint8_t HMS_MQXXX::getReadingFlags() const {
+  HMS_MQXXX_Reading reading;
+  return getLatestReading(&reading) ? reading.flags : (uint8_t)HMS_MQXXX_FLAG_NONE;
 }
 
 float HMS_MQXXX::calibrate(float ratioInCleanAir, float correctionFactor) {
-  // Read fresh voltage for calibration
-  sensorVolt = getVoltage(true, false, 0);
-  
-  float tempRSAir;
+  // Always a new acquisition: a cached sample may predate the clean air (and init() averages calls)
+  HMS_MQXXX_StatusTypeDef status;
+  float                   voltage = getVoltage(true, false, 0, &status);
+  if(status != HMS_MQXXX_OK) return NAN;                                    // R0 left as it was
+  return calibrateVoltage(voltage, ratioInCleanAir, correctionFactor);
+}
+
+// Clean-air voltage to R0, shared by calibrate() and calibrateAsync()
+float HMS_MQXXX::calibrateVoltage(float voltage, float ratioInCleanAir, float correctionFactor) {
+  float tempRSAir = rsFromVoltage(voltage, getVCC(), getRL());
   float temR0;
-  tempRSAir = ((vcc * rl) / sensorVolt) - rl;
-  if(tempRSAir < 0) tempRSAir = 0;
+  #if defined(HMS_MQXXX_COMPENSATION_ENABLED)
+  pollEnvironment();
+  tempRSAir /= envFactor;                                                   // Store R0 at baseline conditions
+  #endif
   temR0 = tempRSAir / ratioInCleanAir;
   temR0 += correctionFactor;
   if(temR0 < 0) temR0 = 0;
   
   // Automatically set the calculated R0 value
   r0 = temR0;
+  readingValid = false;
+  HMS_MQXXX_TRACE(HMS_MQXXX_TRACE_CALIBRATED, traceId, HMS_MQXXX_TraceFloat(temR0), HMS_MQXXX_TraceFloat(ratioInCleanAir));
+  publishEvent(HMS_MQXXX_EVENT_CALIBRATED, temR0, ratioInCleanAir);
   
   return temR0;
-}
\ No newline at end of file
+}
+
+static const HMS_MQXXX_GasCurve mq2Curves[] = {
+  { HMS_MQXXX_GAS_LPG,        HMS_MQXXX_MQ2_REGRESSION,    HMS_MQXXX_MQ2_A_LPG,          HMS_MQXXX_MQ2_B_LPG          },
+  { HMS_MQXXX_GAS_CO,         HMS_MQXXX_MQ2_REGRESSION,    HMS_MQXXX_MQ2_A_CO,           HMS_MQXXX_MQ2_B_CO           },
+  { HMS_MQXXX_GAS_H2,         HMS_MQXXX_MQ2_REGRESSION,    HMS_MQXXX_MQ2_A_H2,           HMS_MQXXX_MQ2_B_H2           },
+  { HMS_MQXXX_GAS_ALCOHOL,    HMS_MQXXX_MQ2_REGRESSION,    HMS_MQXXX_MQ2_A_ALCOHOL,      HMS_MQXXX_MQ2_B_ALCOHOL      },
+  { HMS_MQXXX_GAS_PROPANE,    HMS_MQXXX_MQ2_REGRESSION,    HMS_MQXXX_MQ2_A_PROPANE,      HMS_MQXXX_MQ2_B_PROPANE      }
+};
+
+static const HMS_MQXXX_GasCurve mq135Curves[] = {
+  { HMS_MQXXX_GAS_CO2,        HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_CO2,        HMS_MQXXX_MQ135_B_CO2        },
+  { HMS_MQXXX_GAS_CO,         HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_CO,         HMS_MQXXX_MQ135_B_CO         },
+  { HMS_MQXXX_GAS_NH3,        HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_NH3,        HMS_MQXXX_MQ135_B_NH3        },
+  { HMS_MQXXX_GAS_TOLUENE,    HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_TOLUENE,    HMS_MQXXX_MQ135_B_TOLUENE    },
+  { HMS_MQXXX_GAS_ACETONE,    HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_ACETONE,    HMS_MQXXX_MQ135_B_ACETONE    },
+  { HMS_MQXXX_GAS_ALCOHOL,    HMS_MQXXX_MQ135_REGRESSION,  HMS_MQXXX_MQ135_A_ALCOHOL,    HMS_MQXXX_MQ135_B_ALCOHOL    }
+};
+
+static const HMS_MQXXX_GasCurve mq131Curves[] = {
+  { HMS_MQXXX_GAS_O3,         HMS_MQXXX_MQ131_REGRESSION,  HMS_MQXXX_MQ131_A_O3,         HMS_MQXXX_MQ131_B_O3         },
+  { HMS_MQXXX_GAS_NO2,        HMS_MQXXX_MQ131_REGRESSION,  HMS_MQXXX_MQ131_A_NO2,        HMS_MQXXX_MQ131_B_NO2        },
+  { HMS_MQXXX_GAS_CL2,        HMS_MQXXX_MQ131_REGRESSION,  HMS_MQXXX_MQ131_A_CL2,        HMS_MQXXX_MQ131_B_CL2        }
+};
+
+static const HMS_MQXXX_GasCurve mq303aCurves[] = {
+  { HMS_MQXXX_GAS_ETHANOL,    HMS_MQXXX_MQ303A_REGRESSION, HMS_MQXXX_MQ303A_A_ETHANOL,   HMS_MQXXX_MQ303A_B_ETHANOL   },
+  { HMS_MQXXX_GAS_H2,         HMS_MQXXX_MQ303A_REGRESSION, HMS_MQXXX_MQ303A_A_HYDROGEN,  HMS_MQXXX_MQ303A_B_HYDROGEN  },
+  { HMS_MQXXX_GAS_ISO_BUTANE, HMS_MQXXX_MQ303A_REGRESSION, HMS_MQXXX_MQ303A_A_ISO_BUTANE, HMS_MQXXX_MQ303A_B_ISO_BUTANE }
+};
+
+#define HMS_MQXXX_COUNT_OF(x) ((uint8_t)(sizeof(x) / sizeof((x)[0])))
+static_assert(HMS_MQXXX_COUNT_OF(mq2Curves)    <= HMS_MQXXX_MAX_GASES, "Raise HMS_MQXXX_MAX_GASES");
+static_assert(HMS_MQXXX_COUNT_OF(mq135Curves)  <= HMS_MQXXX_MAX_GASES, "Raise HMS_MQXXX_MAX_GASES");
+static_assert(HMS_MQXXX_COUNT_OF(mq131Curves)  <= HMS_MQXXX_MAX_GASES, "Raise HMS_MQXXX_MAX_GASES");
+static_assert(HMS_MQXXX_COUNT_OF(mq303aCurves) <= HMS_MQXXX_MAX_GASES, "Raise HMS_MQXXX_MAX_GASES");
+
+const HMS_MQXXX_GasCurve *HMS_MQXXX_GetGasCurves(HMS_MQXXX_Type type, uint8_t *count) {
+  const HMS_MQXXX_GasCurve *curves;
+  uint8_t n;
+  switch(type) {
+    case HMS_MQXXX_MQ2:     curves = mq2Curves;     n = HMS_MQXXX_COUNT_OF(mq2Curves);     break;
+    case HMS_MQXXX_MQ131:   curves = mq131Curves;   n = HMS_MQXXX_COUNT_OF(mq131Curves);   break;
+    case HMS_MQXXX_MQ303A:  curves = mq303aCurves;  n = HMS_MQXXX_COUNT_OF(mq303aCurves);  break;
+    case HMS_MQXXX_MQ135:
+    default:                curves = mq135Curves;   n = HMS_MQXXX_COUNT_OF(mq135Curves);   break;   // Generic follows MQ-135
+  }
+  if(count != NULL) *count = n;
+  return curves;
+}
+
+const char *HMS_MQXXX_GetGasName(HMS_MQXXX_Gas gas) {
+  static const char *const names[HMS_MQXXX_GAS_COUNT] = {
+    "LPG", "CO", "H2", "Alcohol", "Propane", "CO2", "NH3",
+    "Toluene", "Acetone", "O3", "NO2", "Cl2", "Ethanol", "iso-Butane"
+  };
+  return ((unsigned)gas < HMS_MQXXX_GAS_COUNT) ? names[gas] : "Unknown";
+}
+
+void HMS_MQXXX_CurveFit::reset() {
+  count = 0;
+  meanU = meanV = 0;
+  m2U   = m2V   = cUV = 0;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_CurveFit::addPoint(float referencePPM, float ratio) {
+  if(!(referencePPM > 0) || !(ratio > 0))       return HMS_MQXXX_ERROR;    // Log domain only, also rejects NaN
+  if(isinf(referencePPM) || isinf(ratio))       return HMS_MQXXX_ERROR;
+  if(count == UINT16_MAX)                       return HMS_MQXXX_ERROR;
+
+  double u  = log10((double)ratio);
+  double v  = log10((double)referencePPM);
+  double du = u - meanU;                                                    // Deviations from the old means
+  double dv = v - meanV;
+
+  count++;
+  meanU += du / count;
+  meanV += dv / count;
+  m2U   += du * (u - meanU);
+  m2V   += dv * (v - meanV);
+  cUV   += du * (v - meanV);
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_CurveFit::solve(HMS_MQXXX_Regression method, float *a, float *b, float *residual) const {
+  if(a == NULL || b == NULL || count < 2) return HMS_MQXXX_ERROR;
+
+  double slope, intercept, sse;
+  if(method == HMS_MQXXX_EXPONENTIAL) {
+    if(m2U <= 0) return HMS_MQXXX_ERROR;                                    // All points at one ratio
+    slope     = cUV / m2U;
+    intercept = meanV - slope * meanU;
+    sse       = m2V - slope * cUV;
+    *a        = (float)pow(10.0, intercept);
+    *b        = (float)slope;
+  } else {
+    if(m2V <= 0) return HMS_MQXXX_ERROR;                                    // All points at one concentration
+    slope     = cUV / m2V;
+    intercept = meanU - slope * meanV;
+    sse       = m2U - slope * cUV;
+    *a        = (float)slope;
+    *b        = (float)intercept;
+  }
+
+  if(residual != NULL) *residual = (float)sqrt((sse > 0 ? sse : 0) / count);
+  return HMS_MQXXX_OK;
+}
+
+#if !defined(HMS_MQXXX_COMPACT_ENABLED)
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::applyCurveFit(const HMS_MQXXX_CurveFit &fit, float *residual) {
+  float fitA, fitB;
+  HMS_MQXXX_StatusTypeDef status = fit.solve(regression, &fitA, &fitB, residual);
+  if(status != HMS_MQXXX_OK) return status;
+
+  setA(fitA);
+  setB(fitB);
+  return HMS_MQXXX_OK;
+}
+#endif
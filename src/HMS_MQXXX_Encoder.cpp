@@ -0,0 +1,119 @@
+#include "HMS_MQXXX_Encoder.h"
+
+#include <string.h>
+
+/*
+  Both formats are written by one pass over the report through a handful of primitives. A
+  writer without a buffer only counts, which is how the exact size is known up front.
+*/
+typedef struct {
+  uint8_t             *out;
+  size_t              capacity;
+  size_t              length;
+  HMS_MQXXX_Encoding  encoding;
+} Writer;
+
+static inline void putByte(Writer *w, uint8_t byte) {
+  if(w->out != NULL && w->length < w->capacity) w->out[w->length] = byte;
+  w->length++;
+}
+
+static void putBigEndian(Writer *w, uint32_t value, uint8_t bytes) {
+  while(bytes-- > 0) putByte(w, (uint8_t)(value >> (8 * bytes)));
+}
+
+// CBOR initial byte + argument, shortest form
+static void putCborHead(Writer *w, uint8_t major, uint32_t value) {
+  major <<= 5;
+  if(value < 24)            putByte(w, (uint8_t)(major | value));
+  else if(value <= 0xFF)    { putByte(w, major | 24); putBigEndian(w, value, 1); }
+  else if(value <= 0xFFFF)  { putByte(w, major | 25); putBigEndian(w, value, 2); }
+  else                      { putByte(w, major | 26); putBigEndian(w, value, 4); }
+}
+
+static void putUint(Writer *w, uint32_t value) {
+  if(w->encoding == HMS_MQXXX_ENCODING_CBOR) {
+    putCborHead(w, 0, value);
+  } else if(value < 0x80) {
+    putByte(w, (uint8_t)value);                                             // Positive fixint
+  } else if(value <= 0xFF) {
+    putByte(w, 0xCC); putBigEndian(w, value, 1);
+  } else if(value <= 0xFFFF) {
+    putByte(w, 0xCD); putBigEndian(w, value, 2);
+  } else {
+    putByte(w, 0xCE); putBigEndian(w, value, 4);
+  }
+}
+
+static void putMap(Writer *w, uint8_t entries) {
+  if(w->encoding == HMS_MQXXX_ENCODING_CBOR) putCborHead(w, 5, entries);
+  else                                       putByte(w, (uint8_t)(0x80 | entries));   // fixmap, entries < 16
+}
+
+static void putText(Writer *w, const char *text) {
+  size_t length = strlen(text);
+  if(w->encoding == HMS_MQXXX_ENCODING_CBOR) {
+    putCborHead(w, 3, (uint32_t)length);
+  } else if(length < 32) {
+    putByte(w, (uint8_t)(0xA0 | length));                                   // fixstr
+  } else {
+    putByte(w, 0xD9); putBigEndian(w, (uint32_t)length, 1);
+  }
+  for(size_t i = 0; i < length; i++) putByte(w, (uint8_t)text[i]);
+}
+
+static void putFloat(Writer *w, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putByte(w, (w->encoding == HMS_MQXXX_ENCODING_CBOR) ? 0xFA : 0xCA);
+  putBigEndian(w, bits, 4);
+}
+
+static size_t encode(const HMS_MQXXX_Report *report, HMS_MQXXX_Encoding encoding, uint8_t *buffer, size_t capacity) {
+  if(report == NULL) return 0;
+  Writer  w     = { buffer, capacity, 0, encoding };
+  uint8_t gases = (report->gasCount < HMS_MQXXX_MAX_GASES) ? report->gasCount : HMS_MQXXX_MAX_GASES;
+
+  putMap(&w, (gases > 0) ? 7 : 6);
+  putText(&w, "ts");      putUint(&w, report->timestamp);
+  putText(&w, "type");    putUint(&w, report->type);
+  putText(&w, "status");  putUint(&w, report->status);
+  putText(&w, "flags");   putUint(&w, report->flags);
+  putText(&w, "ratio");   putFloat(&w, report->ratio);
+  putText(&w, "ppm");     putFloat(&w, report->ppm);
+  if(gases > 0) {
+    putText(&w, "gases");
+    putMap(&w, gases);
+    for(uint8_t i = 0; i < gases; i++) {
+      putText(&w, HMS_MQXXX_GetGasName((HMS_MQXXX_Gas)report->gas[i]));
+      putFloat(&w, report->gasPPM[i]);
+    }
+  }
+
+  if(buffer != NULL && w.length > capacity) return 0;
+  return w.length;
+}
+
+void HMS_MQXXX_MakeReport(const HMS_MQXXX &sensor, const HMS_MQXXX_Reading &reading, HMS_MQXXX_Report *report) {
+  if(report == NULL) return;
+  uint8_t count;
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(sensor.getType(), &count);
+
+  report->timestamp = reading.timestamp;
+  report->ratio     = reading.ratio;
+  report->ppm       = reading.ppm;
+  report->type      = (uint8_t)sensor.getType();
+  report->status    = reading.status;
+  report->flags     = reading.flags;
+  report->gasCount  = sensor.evaluateGases(reading.ratio, report->gasPPM, HMS_MQXXX_MAX_GASES);
+  for(uint8_t i = 0; i < report->gasCount && i < count; i++) report->gas[i] = (uint8_t)curves[i].gas;
+}
+
+size_t HMS_MQXXX_EncodeReport(const HMS_MQXXX_Report *report, HMS_MQXXX_Encoding encoding, uint8_t *buffer, size_t capacity) {
+  if(buffer == NULL) return 0;
+  return encode(report, encoding, buffer, capacity);
+}
+
+size_t HMS_MQXXX_EncodedSize(const HMS_MQXXX_Report *report, HMS_MQXXX_Encoding encoding) {
+  return encode(report, encoding, NULL, 0);
+}
@@ -0,0 +1,391 @@
+#include "HMS_MQXXX_FlashLog.h"
+
+#include <string.h>
+#include <stdio.h>
+
+static_assert(sizeof(HMS_MQXXX_FlashLogRecord) == 24, "Record layout is part of the flash format");
+static_assert(HMS_MQXXX_FLASHLOG_SECTOR_SIZE % HMS_MQXXX_FLASHLOG_PAGE_SIZE == 0, "Pages must tile a sector");
+static_assert(HMS_MQXXX_FLASHLOG_PAGE_SIZE >= 64, "A page holds a header and at least two records");
+
+#define HMS_MQXXX_FLASHLOG_HEADER_CRC_SPAN  12                              // magic, sequence, count, reserved
+
+static bool isErased(const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+  for(size_t i = 0; i < length; i++) {
+    if(bytes[i] != 0xFF) return false;
+  }
+  return true;
+}
+
+HMS_MQXXX_FlashLog::HMS_MQXXX_FlashLog() {
+  listener.callback = onReading;
+  listener.event    = onEvent;
+  listener.context  = this;
+  listener.next     = NULL;
+  memset(page, 0xFF, sizeof(page));
+}
+
+void HMS_MQXXX_FlashLog::attach(HMS_MQXXX *source, uint8_t id) {
+  detach();
+  sensor   = source;
+  sourceId = id;
+  if(sensor != NULL) sensor->addListener(&listener);
+}
+
+void HMS_MQXXX_FlashLog::detach() {
+  if(sensor != NULL) sensor->removeListener(&listener);
+  sensor = NULL;
+}
+
+void HMS_MQXXX_FlashLog::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  HMS_MQXXX_FlashLog *self = static_cast<HMS_MQXXX_FlashLog *>(context);
+  self->append(HMS_MQXXX_FLASHLOG_READING, reading->timestamp, reading->ppm, reading->ratio,
+               self->sourceId, reading->status, reading->flags);
+}
+
+void HMS_MQXXX_FlashLog::onEvent(HMS_MQXXX_Event event, uint32_t timestamp, float value, float aux, void *context) {
+  HMS_MQXXX_FlashLog *self = static_cast<HMS_MQXXX_FlashLog *>(context);
+  if(event != HMS_MQXXX_EVENT_CALIBRATED) return;
+  if(self->append(HMS_MQXXX_FLASHLOG_CALIBRATION, timestamp, value, aux, self->sourceId) == HMS_MQXXX_OK) {
+    self->flush();                                                          // Rare and worth a partly filled page
+  }
+}
+
+uint32_t HMS_MQXXX_FlashLog::getCapacity() const {
+  return (uint32_t)(sectors > 0 ? sectors - 1 : 0) * PAGES_PER_SECTOR * RECORDS_PER_PAGE;   // One sector is always being refilled
+}
+
+HMS_MQXXX_FlashLog::PageState HMS_MQXXX_FlashLog::readHeader(uint16_t sector, uint32_t index, PageHeader *header) {
+  if(flashRead(pageOffset(sector, index), header, sizeof(PageHeader)) != HMS_MQXXX_OK) return PAGE_CORRUPT;
+  if(isErased(header, sizeof(PageHeader)))                                            return PAGE_ERASED;
+  if(header->magic != HMS_MQXXX_FLASHLOG_MAGIC || header->count > RECORDS_PER_PAGE)   return PAGE_CORRUPT;
+  if(header->crc != HMS_MQXXX_Crc32(header, HMS_MQXXX_FLASHLOG_HEADER_CRC_SPAN))      return PAGE_CORRUPT;
+  return PAGE_VALID;
+}
+
+/*
+  Recovery reads one header per sector to find the newest (highest page-0 sequence), then that
+  sector's page headers up to the first erased page. Pages within a sector are consecutive, so
+  the next page sequence is the sector's base plus the pages used. The next record sequence
+  comes from the last record of the newest page that still has a valid one.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::begin() {
+  ready   = false;
+  spare   = false;                                                          // Unknown, maintain() erases it when due
+  pending = 0;
+  erases  = 0;
+  dropped = 0;
+
+  HMS_MQXXX_StatusTypeDef status = flashOpen();
+  if(status != HMS_MQXXX_OK) return status;
+  if(sectors < 2)            return HMS_MQXXX_ERROR;
+
+  PageHeader header;
+  bool       found = false;
+  uint32_t   base  = 0;
+  for(uint16_t s = 0; s < sectors; s++) {
+    if(readHeader(s, 0, &header) != PAGE_VALID) continue;
+    if(!found || (int32_t)(header.sequence - base) > 0) {
+      found = true;
+      base  = header.sequence;
+      head  = s;
+    }
+  }
+
+  uint32_t recovered = 0;
+  if(!found) {                                                              // Blank (or foreign) flash: start at sector 0
+    head           = sectors - 1;
+    pageIndex      = PAGES_PER_SECTOR;
+    pageSequence   = 0;
+    recordSequence = 0;
+  } else {
+    pageIndex = 1;
+    while(pageIndex < PAGES_PER_SECTOR && readHeader(head, pageIndex, &header) != PAGE_ERASED) pageIndex++;
+    pageSequence   = base + pageIndex;
+    recordSequence = base * RECORDS_PER_PAGE;                               // Bound on older records if none survives here
+    recovered      = pageIndex;
+
+    for(uint32_t p = pageIndex; p-- > 0;) {
+      HMS_MQXXX_FlashLogRecord last;
+      if(readHeader(head, p, &header) != PAGE_VALID || header.count == 0) continue;
+      uint32_t offset = pageOffset(head, p) + sizeof(PageHeader) + (uint32_t)(header.count - 1) * sizeof(HMS_MQXXX_FlashLogRecord);
+      if(flashRead(offset, &last, sizeof(last)) != HMS_MQXXX_OK) continue;
+      if(last.crc != HMS_MQXXX_Crc32(&last, offsetof(HMS_MQXXX_FlashLogRecord, crc))) continue;
+      recordSequence = last.sequence + 1;
+      break;
+    }
+  }
+
+  ready = true;
+  status = maintain();                                                      // Blank flash or a full head sector
+  if(status != HMS_MQXXX_OK) return status;
+  return append(HMS_MQXXX_FLASHLOG_BOOT, 0, (float)recovered);
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::append(HMS_MQXXX_FlashLogKind kind, uint32_t timestamp, float value, float aux,
+                                                  uint8_t source, uint8_t code, uint8_t flags) {
+  if(!ready) return HMS_MQXXX_ERROR;
+  if(pending >= RECORDS_PER_PAGE) {                                         // Waiting for maintain(), or a failed program
+    HMS_MQXXX_StatusTypeDef status = flush();
+    if(status != HMS_MQXXX_OK) {
+      recordSequence++;                                                     // Leave a gap for readers to see
+      dropped++;
+      return status;
+    }
+  }
+
+  HMS_MQXXX_FlashLogRecord record;
+  record.sequence  = recordSequence++;
+  record.timestamp = timestamp;
+  record.value     = value;
+  record.aux       = aux;
+  record.kind      = (uint8_t)kind;
+  record.source    = source;
+  record.code      = code;
+  record.flags     = flags;
+  record.crc       = HMS_MQXXX_Crc32(&record, offsetof(HMS_MQXXX_FlashLogRecord, crc));
+  memcpy(page + sizeof(PageHeader) + pending * sizeof(record), &record, sizeof(record));
+  pending++;
+
+  return (pending == RECORDS_PER_PAGE) ? flush() : HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::logEvent(uint8_t code, uint32_t timestamp, float value, float aux) {
+  return append(HMS_MQXXX_FLASHLOG_EVENT, timestamp, value, aux, sourceId, code);
+}
+
+/*
+  A page slot is consumed even when programming fails: it may hold partial data and NOR flash
+  cannot be rewritten without an erase. The records stay pending for the next slot. flush()
+  never erases (it runs from the reading listener); a full head sector moves on only into a
+  sector maintain() has already erased, until then the records wait in RAM.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flush() {
+  if(!ready)        return HMS_MQXXX_ERROR;
+  if(pending == 0)  return HMS_MQXXX_OK;
+
+  if(pageIndex >= PAGES_PER_SECTOR) {                                       // Sector full: move into the spare one
+    if(!spare) return HMS_MQXXX_ERROR;
+    head      = (uint16_t)((head + 1) % sectors);
+    pageIndex = 0;
+    spare     = false;
+  }
+
+  PageHeader header;
+  header.magic    = HMS_MQXXX_FLASHLOG_MAGIC;
+  header.sequence = pageSequence;
+  header.count    = pending;
+  header.reserved = 0xFFFF;
+  header.crc      = HMS_MQXXX_Crc32(&header, HMS_MQXXX_FLASHLOG_HEADER_CRC_SPAN);
+  memcpy(page, &header, sizeof(header));
+
+  HMS_MQXXX_StatusTypeDef status = flashWrite(pageOffset(head, pageIndex), page,
+                                              sizeof(PageHeader) + pending * sizeof(HMS_MQXXX_FlashLogRecord));
+  pageIndex++;
+  pageSequence++;
+  if(status == HMS_MQXXX_OK) pending = 0;
+  return status;
+}
+
+/*
+  Erases the sector after the head (the oldest) once the head has HMS_MQXXX_FLASHLOG_ERASE_AHEAD
+  free pages or fewer, so the listener never waits for an erase; then programs a page that
+  filled up in the meantime.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::maintain() {
+  if(!ready) return HMS_MQXXX_ERROR;
+  if(!spare && PAGES_PER_SECTOR - pageIndex <= HMS_MQXXX_FLASHLOG_ERASE_AHEAD) {
+    if(flashErase((uint16_t)((head + 1) % sectors)) != HMS_MQXXX_OK) return HMS_MQXXX_ERROR;
+    erases++;
+    spare = true;
+  }
+  return (pending >= RECORDS_PER_PAGE) ? flush() : HMS_MQXXX_OK;
+}
+
+// Starts the log over: the ring is blank and sequence numbers restart at 0, as after begin() on new flash
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::erase() {
+  if(sectors == 0) return HMS_MQXXX_ERROR;
+  spare = false;
+  for(uint16_t s = 0; s < sectors; s++) {
+    if(flashErase(s) != HMS_MQXXX_OK) return HMS_MQXXX_ERROR;
+    erases++;
+  }
+  head           = sectors - 1;
+  pageIndex      = PAGES_PER_SECTOR;
+  spare          = true;                                                    // Sector 0 is the next head
+  pending        = 0;
+  pageSequence   = 0;
+  recordSequence = 0;
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX_FlashLogReader::rewind() {
+  sectorsLeft = log.ready ? log.sectors : 0;
+  sector      = (sectorsLeft > 0) ? (uint16_t)((log.head + 1) % log.sectors) : 0;   // Oldest sector follows the newest
+  page        = 0;
+  index       = 0;
+  count       = 0;
+  skipped     = 0;
+}
+
+bool HMS_MQXXX_FlashLogReader::next(HMS_MQXXX_FlashLogRecord *record) {
+  while(sectorsLeft > 0) {
+    if(index < count) {
+      uint32_t offset = log.pageOffset(sector, page - 1) + sizeof(HMS_MQXXX_FlashLog::PageHeader) + (uint32_t)index * sizeof(*record);
+      index++;
+      if(log.flashRead(offset, record, sizeof(*record)) == HMS_MQXXX_OK &&
+         record->crc == HMS_MQXXX_Crc32(record, offsetof(HMS_MQXXX_FlashLogRecord, crc))) return true;
+      skipped++;
+      continue;
+    }
+
+    index = 0;
+    count = 0;
+    HMS_MQXXX_FlashLog::PageHeader header;
+    HMS_MQXXX_FlashLog::PageState  state = (page < HMS_MQXXX_FlashLog::PAGES_PER_SECTOR) ?
+                                           log.readHeader(sector, page, &header) : HMS_MQXXX_FlashLog::PAGE_ERASED;
+    if(state == HMS_MQXXX_FlashLog::PAGE_ERASED) {                          // End of this sector's pages
+      sector = (uint16_t)((sector + 1) % log.sectors);
+      sectorsLeft--;
+      page   = 0;
+      continue;
+    }
+    page++;
+    if(state == HMS_MQXXX_FlashLog::PAGE_VALID) count = header.count;
+    else                                        skipped++;                  // Torn page, its records are unreachable
+  }
+  return false;
+}
+
+#if defined(HMS_MQXXX_FLASHLOG_ESP_PARTITION)
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashOpen() {
+  partition = esp_partition_find_first(ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, HMS_MQXXX_FLASHLOG_PARTITION);
+  if(partition == NULL) return HMS_MQXXX_NOT_FOUND;
+  uint32_t count = partition->size / HMS_MQXXX_FLASHLOG_SECTOR_SIZE;
+  sectors = (uint16_t)((count > 0xFFFF) ? 0xFFFF : count);
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashRead(uint32_t offset, void *data, size_t length) {
+  return (esp_partition_read(partition, offset, data, length) == ESP_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashWrite(uint32_t offset, const void *data, size_t length) {
+  return (esp_partition_write(partition, offset, data, length) == ESP_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashErase(uint16_t sector) {
+  esp_err_t err = esp_partition_erase_range(partition, (size_t)sector * HMS_MQXXX_FLASHLOG_SECTOR_SIZE, HMS_MQXXX_FLASHLOG_SECTOR_SIZE);
+  return (err == ESP_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+/*
+  Sectors are consecutive from HMS_MQXXX_STM32_LOG_ADDRESS; on sector-erase parts they must be
+  the same size and numbered from HMS_MQXXX_STM32_LOG_SECTOR. Reads are plain memory reads.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashOpen() {
+  sectors = HMS_MQXXX_FLASHLOG_SECTORS;
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashRead(uint32_t offset, void *data, size_t length) {
+  memcpy(data, (const void *)(HMS_MQXXX_STM32_LOG_ADDRESS + offset), length);
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashWrite(uint32_t offset, const void *data, size_t length) {
+  HAL_FLASH_Unlock();
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_STM32FlashProgram(HMS_MQXXX_STM32_LOG_ADDRESS + offset, data, length);
+  HAL_FLASH_Lock();
+  return status;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashErase(uint16_t sector) {
+  HAL_FLASH_Unlock();
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_STM32FlashErase(HMS_MQXXX_STM32_LOG_ADDRESS + (uint32_t)sector * HMS_MQXXX_FLASHLOG_SECTOR_SIZE,
+                                                             HMS_MQXXX_STM32_LOG_SECTOR + sector);
+  HAL_FLASH_Lock();
+  return status;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_HOST)
+/*
+  File stand-in with NOR semantics: created erased (0xFF), a write can only clear bits (it is
+  ANDed into what is there), so double-programming bugs show up on the host too.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashOpen() {
+  sectors = HMS_MQXXX_FLASHLOG_SECTORS;
+
+  FILE *file = fopen(HMS_MQXXX_HOST_LOG_PATH, "rb");
+  if(file != NULL) {
+    bool sized = (fseek(file, 0, SEEK_END) == 0) && (ftell(file) >= (long)sectors * HMS_MQXXX_FLASHLOG_SECTOR_SIZE);
+    fclose(file);
+    if(sized) return HMS_MQXXX_OK;
+  }
+
+  file = fopen(HMS_MQXXX_HOST_LOG_PATH, "wb");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+  uint8_t blank[HMS_MQXXX_FLASHLOG_PAGE_SIZE];
+  memset(blank, 0xFF, sizeof(blank));
+  bool written = true;
+  for(uint32_t i = 0; i < (uint32_t)sectors * PAGES_PER_SECTOR && written; i++) {
+    written = (fwrite(blank, sizeof(blank), 1, file) == 1);
+  }
+  written = (fclose(file) == 0) && written;
+  return written ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashRead(uint32_t offset, void *data, size_t length) {
+  FILE *file = fopen(HMS_MQXXX_HOST_LOG_PATH, "rb");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+  bool read = (fseek(file, (long)offset, SEEK_SET) == 0) && (fread(data, length, 1, file) == 1);
+  fclose(file);
+  return read ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashWrite(uint32_t offset, const void *data, size_t length) {
+  uint8_t merged[HMS_MQXXX_FLASHLOG_PAGE_SIZE];
+  if(length > sizeof(merged) || flashRead(offset, merged, length) != HMS_MQXXX_OK) return HMS_MQXXX_ERROR;
+  for(size_t i = 0; i < length; i++) merged[i] &= ((const uint8_t *)data)[i];
+
+  FILE *file = fopen(HMS_MQXXX_HOST_LOG_PATH, "r+b");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+  bool written = (fseek(file, (long)offset, SEEK_SET) == 0) && (fwrite(merged, length, 1, file) == 1);
+  written = (fclose(file) == 0) && written;
+  return written ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashErase(uint16_t sector) {
+  FILE *file = fopen(HMS_MQXXX_HOST_LOG_PATH, "r+b");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+  uint8_t blank[HMS_MQXXX_FLASHLOG_PAGE_SIZE];
+  memset(blank, 0xFF, sizeof(blank));
+  bool written = (fseek(file, (long)pageOffset(sector, 0), SEEK_SET) == 0);
+  for(uint32_t i = 0; i < PAGES_PER_SECTOR && written; i++) {
+    written = (fwrite(blank, sizeof(blank), 1, file) == 1);
+  }
+  written = (fclose(file) == 0) && written;
+  return written ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+#else
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashOpen() {
+  return HMS_MQXXX_NOT_FOUND;                                               // No raw flash backend on this platform yet
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashRead(uint32_t offset, void *data, size_t length) {
+  (void)offset; (void)data; (void)length;
+  return HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashWrite(uint32_t offset, const void *data, size_t length) {
+  (void)offset; (void)data; (void)length;
+  return HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_FlashLog::flashErase(uint16_t sector) {
+  (void)sector;
+  return HMS_MQXXX_ERROR;
+}
+#endif
@@ -0,0 +1,275 @@
+#include "HMS_MQXXX_History.h"
+
+#include <string.h>
+#include <math.h>
+
+#define HMS_MQXXX_HISTORY_BLOCK_BITS    (HMS_MQXXX_HISTORY_BLOCK_SIZE * 8)
+
+static_assert(HMS_MQXXX_HISTORY_BLOCKS >= 2 && HMS_MQXXX_HISTORY_BLOCKS <= 255, "Ring index is a uint8_t");
+static_assert(HMS_MQXXX_HISTORY_BLOCK_BITS <= 0xFFFF, "Bit positions are 16-bit");
+
+// MSB-first bit writer; bytes are cleared as they are entered so a recycled block needs no wipe
+static bool putBits(uint8_t *data, uint16_t *pos, uint32_t value, uint8_t count) {
+  if((uint32_t)*pos + count > HMS_MQXXX_HISTORY_BLOCK_BITS) return false;
+  while(count > 0) {
+    uint16_t byte  = *pos >> 3;
+    uint8_t  shift = *pos & 7;
+    uint8_t  room  = 8 - shift;
+    uint8_t  take  = (count < room) ? count : room;
+    if(shift == 0) data[byte] = 0;
+    uint8_t  chunk = (uint8_t)((value >> (count - take)) & ((1U << take) - 1));
+    data[byte] |= (uint8_t)(chunk << (room - take));
+    *pos  += take;
+    count -= take;
+  }
+  return true;
+}
+
+static inline uint8_t leadingZeros(uint32_t x) {
+  uint8_t n = 0;
+  while(n < 32 && !(x & (0x80000000UL >> n))) n++;
+  return n;
+}
+
+static inline uint8_t trailingZeros(uint32_t x) {
+  uint8_t n = 0;
+  while(n < 32 && !(x & (1UL << n))) n++;
+  return n;
+}
+
+static inline uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+HMS_MQXXX_History::HMS_MQXXX_History() {
+  listener.callback = onReading;
+  listener.event    = NULL;
+  listener.context  = this;
+  listener.next     = NULL;
+  memset(blocks, 0, sizeof(blocks));
+}
+
+void HMS_MQXXX_History::attach(HMS_MQXXX *source) {
+  detach();
+  sensor = source;
+  if(sensor != NULL) sensor->addListener(&listener);
+}
+
+void HMS_MQXXX_History::detach() {
+  if(sensor != NULL) sensor->removeListener(&listener);
+  sensor = NULL;
+}
+
+void HMS_MQXXX_History::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  if(reading->status != HMS_MQXXX_OK) return;
+  static_cast<HMS_MQXXX_History *>(context)->append(reading->timestamp, reading->ppm);
+}
+
+void HMS_MQXXX_History::clear() {
+  for(uint8_t i = 0; i < HMS_MQXXX_HISTORY_BLOCKS; i++) {
+    blocks[i].generation++;                                                 // Invalidate running readers
+    blocks[i].count = 0;
+    blocks[i].bits  = 0;
+  }
+  oldest  = 0;
+  current = 0;
+  used    = 0;
+  samples = 0;
+}
+
+// Quantum is rounded down to a power of two so quantised values keep low mantissa bits zero
+void HMS_MQXXX_History::setQuantum(float step) {
+  if(isnan(step) || isinf(step) || step <= 0) {
+    quantized = false;
+    return;
+  }
+  int exponent;
+  frexpf(step, &exponent);                                                  // step = m * 2^exponent, 0.5 <= m < 1
+  quantumExponent = (int8_t)(exponent - 1);
+  quantized       = true;
+}
+
+uint32_t HMS_MQXXX_History::getEncodedBytes() const {
+  uint32_t total = 0;
+  for(uint8_t i = 0, b = oldest; i < used; i++, b = (uint8_t)((b + 1) % HMS_MQXXX_HISTORY_BLOCKS)) {
+    total += (blocks[b].bits + 7) / 8;
+  }
+  return total;
+}
+
+void HMS_MQXXX_History::openBlock(uint32_t timestamp) {
+  if(used == HMS_MQXXX_HISTORY_BLOCKS) {                                    // Ring full: recycle the oldest block
+    samples -= blocks[oldest].count;
+    dropped += blocks[oldest].count;
+    oldest   = (uint8_t)((oldest + 1) % HMS_MQXXX_HISTORY_BLOCKS);
+    used--;
+  }
+  if(used > 0) current = (uint8_t)((current + 1) % HMS_MQXXX_HISTORY_BLOCKS);
+  Block &block = blocks[current];
+  block.generation++;
+  block.firstTimestamp = timestamp;
+  block.count          = 0;
+  block.bits           = 0;
+  used++;
+  prevTimestamp = timestamp;
+  prevDelta     = 0;
+  prevValue     = 0;
+  prevLeading   = 0xFF;
+  prevTrailing  = 0;
+}
+
+/*
+  Appends one sample to the block. Encoder state only advances once the whole sample fit, so
+  a failed attempt leaves the block exactly as it was (the partial bits past block.bits are
+  ignored and overwritten by the next writer).
+*/
+bool HMS_MQXXX_History::encode(Block &block, uint32_t timestamp, uint32_t value) {
+  uint16_t pos = block.bits;
+
+  int32_t delta = (int32_t)(timestamp - prevTimestamp);
+  if(block.count > 0) {
+    int32_t dod = delta - prevDelta;
+    bool    ok;
+    if(dod == 0)                          ok = putBits(block.data, &pos, 0x0, 1);
+    else if(dod >= -4    && dod <= 3)     ok = putBits(block.data, &pos, 0x2, 2)  && putBits(block.data, &pos, (uint32_t)dod & 0x7, 3);
+    else if(dod >= -64   && dod <= 63)    ok = putBits(block.data, &pos, 0x6, 3)  && putBits(block.data, &pos, (uint32_t)dod & 0x7F, 7);
+    else if(dod >= -2048 && dod <= 2047)  ok = putBits(block.data, &pos, 0xE, 4)  && putBits(block.data, &pos, (uint32_t)dod & 0xFFF, 12);
+    else                                  ok = putBits(block.data, &pos, 0xF, 4)  && putBits(block.data, &pos, (uint32_t)dod, 32);
+    if(!ok) return false;
+  }
+
+  uint8_t leading  = prevLeading;
+  uint8_t trailing = prevTrailing;
+  if(block.count == 0) {
+    if(!putBits(block.data, &pos, value, 32)) return false;               // First value verbatim
+  } else {
+    uint32_t x = value ^ prevValue;
+    if(x == 0) {
+      if(!putBits(block.data, &pos, 0x0, 1)) return false;
+    } else {
+      uint8_t lz = leadingZeros(x);
+      uint8_t tz = trailingZeros(x);
+      if(lz > 31) lz = 31;                                                  // 5-bit field
+      if(prevLeading != 0xFF && lz >= prevLeading && tz >= prevTrailing) {
+        uint8_t length = (uint8_t)(32 - prevLeading - prevTrailing);
+        if(!putBits(block.data, &pos, 0x2, 2) || !putBits(block.data, &pos, x >> prevTrailing, length)) return false;
+      } else {
+        uint8_t length = (uint8_t)(32 - lz - tz);
+        if(!putBits(block.data, &pos, 0x3, 2) || !putBits(block.data, &pos, lz, 5) ||
+           !putBits(block.data, &pos, (uint32_t)(length - 1), 5) || !putBits(block.data, &pos, x >> tz, length)) return false;
+        leading  = lz;
+        trailing = tz;
+      }
+    }
+  }
+
+  block.bits    = pos;
+  block.count++;
+  prevTimestamp = timestamp;
+  prevDelta     = (block.count > 1) ? delta : 0;
+  prevValue     = value;
+  prevLeading   = leading;
+  prevTrailing  = trailing;
+  return true;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_History::append(uint32_t timestamp, float value) {
+  if(isnan(value) || isinf(value)) return HMS_MQXXX_ERROR;
+  if(quantized) value = ldexpf(roundf(ldexpf(value, -quantumExponent)), quantumExponent);
+
+  uint32_t bits = floatBits(value);
+  if(used == 0 || !encode(blocks[current], timestamp, bits)) {
+    openBlock(timestamp);
+    if(!encode(blocks[current], timestamp, bits)) return HMS_MQXXX_ERROR;  // Only with a block under 4 bytes
+  }
+  samples++;
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX_HistoryReader::rewind() {
+  block      = history.oldest;
+  blocksLeft = history.used;
+  overrun    = false;
+  enterBlock();
+}
+
+bool HMS_MQXXX_HistoryReader::enterBlock() {
+  if(blocksLeft == 0) return false;
+  const HMS_MQXXX_History::Block &b = history.blocks[block];
+  generation = b.generation;
+  index      = 0;
+  pos        = 0;
+  timestamp  = b.firstTimestamp;
+  delta      = 0;
+  value      = 0;
+  leading    = 0;
+  trailing   = 0;
+  return true;
+}
+
+uint32_t HMS_MQXXX_HistoryReader::readBits(const uint8_t *data, uint8_t count) {
+  uint32_t result = 0;
+  while(count > 0) {
+    uint8_t shift = pos & 7;
+    uint8_t room  = 8 - shift;
+    uint8_t take  = (count < room) ? count : room;
+    uint8_t chunk = (uint8_t)((data[pos >> 3] >> (room - take)) & ((1U << take) - 1));
+    result = (result << take) | chunk;
+    pos   += take;
+    count -= take;
+  }
+  return result;
+}
+
+static inline int32_t signExtend(uint32_t value, uint8_t bits) {
+  uint32_t sign = 1UL << (bits - 1);
+  return (int32_t)((value ^ sign) - sign);
+}
+
+bool HMS_MQXXX_HistoryReader::next(uint32_t *outTimestamp, float *outValue) {
+  while(blocksLeft > 0) {
+    const HMS_MQXXX_History::Block &b = history.blocks[block];
+    if(b.generation != generation) {                                        // Recycled under us
+      overrun    = true;
+      blocksLeft = 0;
+      return false;
+    }
+    if(index >= b.count) {
+      blocksLeft--;
+      block = (uint8_t)((block + 1) % HMS_MQXXX_HISTORY_BLOCKS);
+      enterBlock();
+      continue;
+    }
+
+    if(index == 0) {
+      value = readBits(b.data, 32);
+    } else {
+      int32_t dod;
+      if(readBits(b.data, 1) == 0)       dod = 0;
+      else if(readBits(b.data, 1) == 0)  dod = signExtend(readBits(b.data, 3), 3);
+      else if(readBits(b.data, 1) == 0)  dod = signExtend(readBits(b.data, 7), 7);
+      else if(readBits(b.data, 1) == 0)  dod = signExtend(readBits(b.data, 12), 12);
+      else                               dod = (int32_t)readBits(b.data, 32);
+      delta     += dod;
+      timestamp += (uint32_t)delta;
+
+      if(readBits(b.data, 1) != 0) {
+        if(readBits(b.data, 1) != 0) {
+          leading  = (uint8_t)readBits(b.data, 5);
+          uint8_t length = (uint8_t)(readBits(b.data, 5) + 1);
+          trailing = (uint8_t)(32 - leading - length);
+        }
+        uint8_t length = (uint8_t)(32 - leading - trailing);
+        value ^= readBits(b.data, length) << trailing;
+      }
+    }
+    index++;
+
+    if(outTimestamp != NULL) *outTimestamp = timestamp;
+    if(outValue != NULL)     memcpy(outValue, &value, sizeof(*outValue));
+    return true;
+  }
+  return false;
+}
@@ -0,0 +1,332 @@
+#include "HMS_MQXXX_Modbus.h"
+
+#include <string.h>
+#include <math.h>
+
+#define MODBUS_READ_COILS               0x01
+#define MODBUS_READ_HOLDING             0x03
+#define MODBUS_READ_INPUTS              0x04
+#define MODBUS_WRITE_COIL               0x05
+#define MODBUS_WRITE_REGISTER           0x06
+#define MODBUS_WRITE_REGISTERS          0x10
+
+static_assert(HMS_MQXXX_MODBUS_IR_GAS_PPM >= HMS_MQXXX_MODBUS_IR_SEQUENCE + 1, "Per-gas block overlaps the scalars");
+static_assert(HMS_MQXXX_MODBUS_IR_COUNT <= 0xFF, "Register indices are uint8_t");
+
+static inline uint16_t getBE(const uint8_t *in) {
+  return (uint16_t)((in[0] << 8) | in[1]);
+}
+
+static inline void putBE(uint8_t *out, uint16_t value) {
+  out[0] = (uint8_t)(value >> 8);
+  out[1] = (uint8_t)value;
+}
+
+static float cleanAirRatio(HMS_MQXXX_Type type) {
+  switch(type) {
+    case HMS_MQXXX_MQ2:     return HMS_MQXXX_MQ2_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ131:   return HMS_MQXXX_MQ131_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ135:   return HMS_MQXXX_MQ135_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ303A:  return HMS_MQXXX_MQ303A_CLEAN_AIR_RATIO;
+    default:                return HMS_MQXXX_GENERIC_CLEAN_AIR_RATIO;
+  }
+}
+
+HMS_MQXXX_Modbus::HMS_MQXXX_Modbus(uint8_t address) : slaveAddress(address) {
+  listener.callback = onReading;
+  listener.event    = onEvent;
+  listener.context  = this;
+  listener.next     = NULL;
+
+  float ratio = HMS_MQXXX_GENERIC_CLEAN_AIR_RATIO;
+  uint32_t bits;
+  memcpy(&bits, &ratio, sizeof(bits));
+  cleanAir[0] = (uint16_t)(bits >> 16);
+  cleanAir[1] = (uint16_t)bits;
+
+  memset(image, 0, sizeof(image));
+  putWord(HMS_MQXXX_MODBUS_IR_STATUS, HMS_MQXXX_NOT_FOUND);
+  putLong(HMS_MQXXX_MODBUS_IR_CAL_AGE, HMS_MQXXX_MODBUS_NOT_CALIBRATED);
+  putWord(HMS_MQXXX_MODBUS_IR_CAL_RESULT, calResult);
+  for(uint8_t i = 0; i < HMS_MQXXX_MAX_GASES; i++) {
+    putFloat((uint8_t)(HMS_MQXXX_MODBUS_IR_GAS_PPM + 2 * i), NAN);
+    putWord((uint8_t)(HMS_MQXXX_MODBUS_IR_GAS_ID + i), 0xFFFF);
+  }
+}
+
+HMS_MQXXX_Modbus::~HMS_MQXXX_Modbus() {
+  detach();
+}
+
+void HMS_MQXXX_Modbus::attach(HMS_MQXXX *source) {
+  detach();
+  sensor = source;
+  if(sensor == NULL) return;
+
+  uint8_t count;
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(sensor->getType(), &count);
+  if(count > HMS_MQXXX_MAX_GASES) count = HMS_MQXXX_MAX_GASES;
+
+  float    ratio = cleanAirRatio(sensor->getType());
+  uint32_t bits;
+  memcpy(&bits, &ratio, sizeof(bits));
+  __atomic_store_n(&cleanAir[0], (uint16_t)(bits >> 16), __ATOMIC_RELAXED);
+  __atomic_store_n(&cleanAir[1], (uint16_t)bits, __ATOMIC_RELAXED);
+
+  beginUpdate();
+  putWord(HMS_MQXXX_MODBUS_IR_TYPE, (uint16_t)sensor->getType());
+  putWord(HMS_MQXXX_MODBUS_IR_GAS_COUNT, count);
+  putFloat(HMS_MQXXX_MODBUS_IR_R0, sensor->getR0());
+  for(uint8_t i = 0; i < HMS_MQXXX_MAX_GASES; i++) {
+    putWord((uint8_t)(HMS_MQXXX_MODBUS_IR_GAS_ID + i), (i < count) ? (uint16_t)curves[i].gas : 0xFFFF);
+  }
+  endUpdate();
+  sensor->addListener(&listener);
+}
+
+void HMS_MQXXX_Modbus::detach() {
+  if(sensor != NULL) sensor->removeListener(&listener);
+  sensor = NULL;
+}
+
+/*
+  Seqlock writer, same protocol as HMS_MQXXX::publishReading(). Updates only come from the
+  sensor's publishing task (listener callbacks and service()), never from the bus.
+*/
+void HMS_MQXXX_Modbus::beginUpdate() {
+  __atomic_store_n(&imageSeq, (HMS_MQXXX_SeqWord)(imageSeq + 1), __ATOMIC_RELAXED);
+  __atomic_thread_fence(__ATOMIC_RELEASE);
+}
+
+void HMS_MQXXX_Modbus::endUpdate() {
+  __atomic_store_n(&imageSeq, (HMS_MQXXX_SeqWord)(imageSeq + 1), __ATOMIC_RELEASE);
+}
+
+void HMS_MQXXX_Modbus::putWord(uint8_t reg, uint16_t value) {
+  __atomic_store_n(&image[reg], value, __ATOMIC_RELAXED);
+}
+
+void HMS_MQXXX_Modbus::putLong(uint8_t reg, uint32_t value) {
+  putWord(reg, (uint16_t)(value >> 16));
+  putWord((uint8_t)(reg + 1), (uint16_t)value);
+}
+
+void HMS_MQXXX_Modbus::putFloat(uint8_t reg, float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  putLong(reg, bits);
+}
+
+void HMS_MQXXX_Modbus::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  HMS_MQXXX_Modbus *self = static_cast<HMS_MQXXX_Modbus *>(context);
+  float            ppm[HMS_MQXXX_MAX_GASES];
+  uint8_t          count = 0;
+  if(reading->status == HMS_MQXXX_OK) count = self->sensor->evaluateGases(reading->ratio, ppm, HMS_MQXXX_MAX_GASES);
+  for(uint8_t i = count; i < HMS_MQXXX_MAX_GASES; i++) ppm[i] = NAN;
+
+  uint32_t age = HMS_MQXXX_MODBUS_NOT_CALIBRATED;
+  if(self->calibrated) age = (reading->timestamp - self->calibratedAt) / 1000;
+
+  self->sequence++;
+  self->beginUpdate();
+  self->putWord(HMS_MQXXX_MODBUS_IR_STATUS, reading->status);
+  self->putWord(HMS_MQXXX_MODBUS_IR_FLAGS, reading->flags);
+  self->putLong(HMS_MQXXX_MODBUS_IR_TIMESTAMP, reading->timestamp);
+  self->putFloat(HMS_MQXXX_MODBUS_IR_PPM, reading->ppm);
+  self->putFloat(HMS_MQXXX_MODBUS_IR_RATIO, reading->ratio);
+  self->putFloat(HMS_MQXXX_MODBUS_IR_VOLTAGE, reading->voltage);
+  self->putFloat(HMS_MQXXX_MODBUS_IR_RS, reading->rs);
+  self->putLong(HMS_MQXXX_MODBUS_IR_CAL_AGE, age);
+  self->putWord(HMS_MQXXX_MODBUS_IR_SEQUENCE, self->sequence);
+  for(uint8_t i = 0; i < HMS_MQXXX_MAX_GASES; i++) self->putFloat((uint8_t)(HMS_MQXXX_MODBUS_IR_GAS_PPM + 2 * i), ppm[i]);
+  self->endUpdate();
+}
+
+void HMS_MQXXX_Modbus::onEvent(HMS_MQXXX_Event event, uint32_t timestamp, float value, float aux, void *context) {
+  HMS_MQXXX_Modbus *self = static_cast<HMS_MQXXX_Modbus *>(context);
+  (void)aux;
+  if(event != HMS_MQXXX_EVENT_CALIBRATED) return;
+
+  self->calibrated   = true;
+  self->calibratedAt = timestamp;
+  self->beginUpdate();
+  self->putFloat(HMS_MQXXX_MODBUS_IR_R0, value);
+  self->putLong(HMS_MQXXX_MODBUS_IR_CAL_AGE, 0);
+  self->endUpdate();
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Modbus::service() {
+  if(__atomic_exchange_n(&pending, (uint8_t)0, __ATOMIC_ACQUIRE) == 0) return HMS_MQXXX_NOT_FOUND;
+
+  uint32_t bits = ((uint32_t)__atomic_load_n(&cleanAir[0], __ATOMIC_RELAXED) << 16) | __atomic_load_n(&cleanAir[1], __ATOMIC_RELAXED);
+  float    ratio;
+  memcpy(&ratio, &bits, sizeof(ratio));
+
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_ERROR;
+  if(sensor != NULL && !isnan(ratio) && !isinf(ratio) && ratio > 0) {
+    float r0 = sensor->calibrate(ratio);                                    // Publishes CALIBRATED: R0 and age follow
+    if(!isnan(r0) && !isinf(r0) && r0 > 0) status = HMS_MQXXX_OK;
+  }
+  calResult = (uint16_t)status;
+  beginUpdate();
+  putWord(HMS_MQXXX_MODBUS_IR_CAL_RESULT, calResult);
+  endUpdate();
+  return status;
+}
+
+/*
+  Seqlock reader: copies straight out of the image, at most HMS_MQXXX_SNAPSHOT_RETRIES times,
+  and gives up rather than spin on a preempted writer.
+*/
+bool HMS_MQXXX_Modbus::readInputs(uint16_t start, uint16_t count, uint16_t *out) const {
+  if(out == NULL || (uint32_t)start + count > HMS_MQXXX_MODBUS_IR_COUNT) return false;
+
+  for(uint8_t attempt = 0; attempt < HMS_MQXXX_SNAPSHOT_RETRIES; attempt++) {
+    HMS_MQXXX_SeqWord begin = __atomic_load_n(&imageSeq, __ATOMIC_ACQUIRE);
+    if(begin & 1) continue;
+    for(uint16_t i = 0; i < count; i++) out[i] = __atomic_load_n(&image[start + i], __ATOMIC_RELAXED);
+    __atomic_thread_fence(__ATOMIC_ACQUIRE);
+    if(__atomic_load_n(&imageSeq, __ATOMIC_RELAXED) == begin) return true;
+  }
+  return false;
+}
+
+size_t HMS_MQXXX_Modbus::exception(uint8_t function, uint8_t code, uint8_t *response) {
+  exceptions++;
+  response[0] = (uint8_t)(function | 0x80);
+  response[1] = code;
+  return 2;
+}
+
+/*
+  One request PDU (function code + data) to its response PDU. Returns 0 only when the
+  response buffer is too small; every malformed request gets an exception response.
+*/
+size_t HMS_MQXXX_Modbus::processPDU(const uint8_t *request, size_t length, uint8_t *response, size_t capacity) {
+  if(request == NULL || response == NULL || length < 1 || capacity < 2) return 0;
+  requests++;
+
+  uint8_t function = request[0];
+  if(function != MODBUS_READ_COILS && function != MODBUS_READ_HOLDING && function != MODBUS_READ_INPUTS &&
+     function != MODBUS_WRITE_COIL && function != MODBUS_WRITE_REGISTER && function != MODBUS_WRITE_REGISTERS) {
+    return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_FUNCTION, response);
+  }
+  if(length < 5) return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+
+  uint16_t start = getBE(request + 1);
+  uint16_t value = getBE(request + 3);                                      // Quantity, or the value of a single write
+  uint8_t  flag  = __atomic_load_n(&pending, __ATOMIC_RELAXED);
+
+  switch(function) {
+    case MODBUS_READ_COILS: {
+      if(value < 1 || value > 2000)                                         return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+      if((uint32_t)start + value > HMS_MQXXX_MODBUS_COIL_COUNT)             return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS, response);
+      if(capacity < 3)                                                      return 0;
+      response[0] = function;
+      response[1] = 1;
+      response[2] = flag ? 0x01 : 0x00;                                     // Only coil 0 exists
+      return 3;
+    }
+
+    case MODBUS_READ_HOLDING:
+    case MODBUS_READ_INPUTS: {
+      uint16_t limit = (function == MODBUS_READ_INPUTS) ? (uint16_t)HMS_MQXXX_MODBUS_IR_COUNT : (uint16_t)HMS_MQXXX_MODBUS_HR_COUNT;
+      if(value < 1 || value > 125)                                          return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+      if((uint32_t)start + value > limit)                                   return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS, response);
+      if(capacity < 2 + 2 * (size_t)value)                                  return 0;
+
+      uint16_t words[HMS_MQXXX_MODBUS_IR_COUNT];
+      if(function == MODBUS_READ_INPUTS) {
+        if(!readInputs(start, value, words))                                return exception(function, HMS_MQXXX_MODBUS_DEVICE_BUSY, response);
+      } else {
+        uint16_t holding[HMS_MQXXX_MODBUS_HR_COUNT] = {
+          __atomic_load_n(&cleanAir[0], __ATOMIC_RELAXED), __atomic_load_n(&cleanAir[1], __ATOMIC_RELAXED), flag
+        };
+        memcpy(words, holding + start, 2 * (size_t)value);
+      }
+      response[0] = function;
+      response[1] = (uint8_t)(2 * value);
+      for(uint16_t i = 0; i < value; i++) putBE(response + 2 + 2 * i, words[i]);
+      return 2 + 2 * (size_t)value;
+    }
+
+    case MODBUS_WRITE_COIL: {
+      if(start >= HMS_MQXXX_MODBUS_COIL_COUNT)                              return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS, response);
+      if(value != 0xFF00 && value != 0x0000)                                return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+      __atomic_store_n(&pending, (uint8_t)(value ? 1 : 0), __ATOMIC_RELEASE);
+      break;
+    }
+
+    case MODBUS_WRITE_REGISTER: {
+      if(start >= HMS_MQXXX_MODBUS_HR_COUNT)                                return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS, response);
+      if(start == HMS_MQXXX_MODBUS_HR_COMMAND) {
+        if(value > 1)                                                       return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+        __atomic_store_n(&pending, (uint8_t)value, __ATOMIC_RELEASE);
+      } else {
+        __atomic_store_n(&cleanAir[start], value, __ATOMIC_RELAXED);
+      }
+      break;
+    }
+
+    case MODBUS_WRITE_REGISTERS: {
+      if(value < 1 || value > 123 || length < 6 || request[5] != 2 * value ||
+         length < 6 + 2 * (size_t)value)                                    return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+      if((uint32_t)start + value > HMS_MQXXX_MODBUS_HR_COUNT)               return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS, response);
+      uint16_t command = 0xFFFF;
+      for(uint16_t i = 0; i < value; i++) {
+        uint16_t word = getBE(request + 6 + 2 * i);
+        if(start + i == HMS_MQXXX_MODBUS_HR_COMMAND) {
+          if(word > 1)                                                      return exception(function, HMS_MQXXX_MODBUS_ILLEGAL_VALUE, response);
+          command = word;
+        }
+      }
+      for(uint16_t i = 0; i < value && start + i < HMS_MQXXX_MODBUS_HR_COMMAND; i++) {
+        __atomic_store_n(&cleanAir[start + i], getBE(request + 6 + 2 * i), __ATOMIC_RELAXED);
+      }
+      if(command != 0xFFFF) __atomic_store_n(&pending, (uint8_t)command, __ATOMIC_RELEASE);   // Ratio and trigger in one write
+      break;
+    }
+  }
+
+  if(capacity < 5) return 0;
+  memcpy(response, request, 5);                                             // Writes echo function, address and value/quantity
+  return 5;
+}
+
+size_t HMS_MQXXX_Modbus::processRTU(const uint8_t *frame, size_t length, uint8_t *response, size_t capacity) {
+  if(frame == NULL || response == NULL || length < 4) return 0;
+  if(frame[0] != slaveAddress && frame[0] != 0) return 0;
+  if(crc16(frame, length - 2) != (uint16_t)(frame[length - 2] | (frame[length - 1] << 8))) return 0;
+  if(capacity < 5) return 0;
+
+  size_t n = processPDU(frame + 1, length - 3, response + 1, capacity - 3);
+  if(n == 0 || frame[0] == 0) return 0;                                     // Broadcasts are executed, never answered
+  response[0] = slaveAddress;
+  uint16_t crc = crc16(response, n + 1);
+  response[n + 1] = (uint8_t)crc;                                           // CRC goes low byte first
+  response[n + 2] = (uint8_t)(crc >> 8);
+  return n + 3;
+}
+
+size_t HMS_MQXXX_Modbus::processTCP(const uint8_t *adu, size_t length, uint8_t *response, size_t capacity) {
+  if(adu == NULL || response == NULL || length < HMS_MQXXX_MODBUS_MBAP_SIZE + 1) return 0;
+  if(getBE(adu + 2) != 0 || getBE(adu + 4) != length - 6) return 0;        // Protocol id, length of unit id + PDU
+  if(capacity < HMS_MQXXX_MODBUS_MBAP_SIZE + 2) return 0;
+
+  size_t n = processPDU(adu + HMS_MQXXX_MODBUS_MBAP_SIZE, length - HMS_MQXXX_MODBUS_MBAP_SIZE,
+                        response + HMS_MQXXX_MODBUS_MBAP_SIZE, capacity - HMS_MQXXX_MODBUS_MBAP_SIZE);
+  if(n == 0) return 0;
+  memcpy(response, adu, 4);                                                 // Transaction and protocol id
+  putBE(response + 4, (uint16_t)(n + 1));
+  response[6] = adu[6];                                                     // Unit id echoed (any id is accepted)
+  return n + HMS_MQXXX_MODBUS_MBAP_SIZE;
+}
+
+uint16_t HMS_MQXXX_Modbus::crc16(const uint8_t *data, size_t length) {
+  uint16_t crc = 0xFFFF;
+  for(size_t i = 0; i < length; i++) {
+    crc ^= data[i];
+    for(uint8_t bit = 0; bit < 8; bit++) crc = (crc & 1) ? (uint16_t)((crc >> 1) ^ 0xA001) : (uint16_t)(crc >> 1);
+  }
+  return crc;
+}
@@ -0,0 +1,170 @@
+#include "HMS_MQXXX_Rollup.h"
+
+#include <string.h>
+#include <math.h>
+
+static constexpr uint32_t       levelPeriods[] = HMS_MQXXX_ROLLUP_PERIODS;   // Unsized, so a short list cannot zero-fill
+static constexpr uint16_t       levelSlots[]   = HMS_MQXXX_ROLLUP_SLOTS;
+
+// First bucket of a level in the per-gas bucket array (= slots of the levels before it)
+static constexpr uint32_t levelOffset(uint8_t level) {
+  return (level == 0) ? 0 : levelSlots[level - 1] + levelOffset(level - 1);
+}
+
+static_assert(HMS_MQXXX_ROLLUP_LEVELS >= 1 && HMS_MQXXX_ROLLUP_LEVELS <= 8, "Rollup levels out of range");
+static_assert(sizeof(levelPeriods) / sizeof(levelPeriods[0]) == HMS_MQXXX_ROLLUP_LEVELS, "HMS_MQXXX_ROLLUP_PERIODS needs one entry per level");
+static_assert(sizeof(levelSlots) / sizeof(levelSlots[0]) == HMS_MQXXX_ROLLUP_LEVELS, "HMS_MQXXX_ROLLUP_SLOTS needs one entry per level");
+static_assert(levelOffset(HMS_MQXXX_ROLLUP_LEVELS) == HMS_MQXXX_ROLLUP_TOTAL_SLOTS, "HMS_MQXXX_ROLLUP_TOTAL_SLOTS must be the sum of HMS_MQXXX_ROLLUP_SLOTS");
+
+HMS_MQXXX_Rollup::HMS_MQXXX_Rollup() {
+  listener.callback = onReading;
+  listener.event    = NULL;
+  listener.context  = this;
+  listener.next     = NULL;
+  memset(gases, HMS_MQXXX_GAS_COUNT, sizeof(gases));
+  clear();
+}
+
+void HMS_MQXXX_Rollup::attach(HMS_MQXXX *source) {
+  detach();
+  sensor = source;
+  if(sensor == NULL) return;
+
+  uint8_t count;
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(sensor->getType(), &count);
+  if(count > HMS_MQXXX_ROLLUP_GASES) count = HMS_MQXXX_ROLLUP_GASES;
+  memset(gases, HMS_MQXXX_GAS_COUNT, sizeof(gases));
+  for(uint8_t i = 0; i < count; i++) gases[i] = (uint8_t)curves[i].gas;
+  gasCount = (count > 0) ? count : 1;                                       // No table: index 0 is the active curve
+  clear();
+  sensor->addListener(&listener);
+}
+
+void HMS_MQXXX_Rollup::detach() {
+  if(sensor != NULL) sensor->removeListener(&listener);
+  sensor = NULL;
+}
+
+void HMS_MQXXX_Rollup::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  HMS_MQXXX_Rollup *self = static_cast<HMS_MQXXX_Rollup *>(context);
+  if(reading->status != HMS_MQXXX_OK) return;
+
+  float   ppm[HMS_MQXXX_ROLLUP_GASES];
+  uint8_t count = 1;
+  if(self->gases[0] == HMS_MQXXX_GAS_COUNT) ppm[0] = reading->ppm;
+  else                                      count  = self->sensor->evaluateGases(reading->ratio, ppm, self->gasCount);
+  self->append(reading->timestamp, ppm, count);
+}
+
+void HMS_MQXXX_Rollup::clear() {
+  for(uint8_t g = 0; g < HMS_MQXXX_ROLLUP_GASES; g++) {
+    for(uint16_t s = 0; s < HMS_MQXXX_ROLLUP_TOTAL_SLOTS; s++) buckets[g][s].count = 0;
+  }
+  memset(levels, 0, sizeof(levels));
+  started = false;
+}
+
+HMS_MQXXX_Gas HMS_MQXXX_Rollup::getGas(uint8_t index) const {
+  return (index < gasCount) ? (HMS_MQXXX_Gas)gases[index] : HMS_MQXXX_GAS_COUNT;
+}
+
+uint16_t HMS_MQXXX_Rollup::getSlotCount(uint8_t level) const {
+  return (level < HMS_MQXXX_ROLLUP_LEVELS) ? levelSlots[level] : 0;
+}
+
+uint32_t HMS_MQXXX_Rollup::getPeriod(uint8_t level) const {
+  return (level < HMS_MQXXX_ROLLUP_LEVELS) ? levelPeriods[level] : 0;
+}
+
+/*
+  Moves a level's current bucket forward to the period holding timestamp, emptying every
+  bucket it steps onto. At most one trip around the ring, whatever the gap.
+*/
+void HMS_MQXXX_Rollup::advance(uint8_t level, uint32_t timestamp) {
+  Level    &state   = levels[level];
+  uint32_t period   = levelPeriods[level];
+  uint32_t elapsed  = timestamp - state.start;
+  if(elapsed < period) return;
+
+  uint32_t steps = elapsed / period;
+  state.start   += steps * period;
+  if(steps > levelSlots[level]) steps = levelSlots[level];
+  for(uint32_t i = 0; i < steps; i++) {
+    state.current = (uint16_t)((state.current + 1) % levelSlots[level]);
+    for(uint8_t g = 0; g < gasCount; g++) buckets[g][levelOffset(level) + state.current].count = 0;
+    if(state.filled < levelSlots[level]) state.filled++;
+  }
+}
+
+void HMS_MQXXX_Rollup::append(uint32_t timestamp, const float *values, uint8_t count) {
+  if(values == NULL || count == 0) return;
+  if(count > HMS_MQXXX_ROLLUP_GASES) count = HMS_MQXXX_ROLLUP_GASES;
+  if(count > gasCount) gasCount = count;                                    // Plain append() without attach()
+
+  if(!started) {
+    for(uint8_t l = 0; l < HMS_MQXXX_ROLLUP_LEVELS; l++) {
+      levels[l].start   = timestamp;
+      levels[l].current = 0;
+      levels[l].filled  = 1;
+    }
+    started = true;
+  } else {
+    for(uint8_t l = 0; l < HMS_MQXXX_ROLLUP_LEVELS; l++) advance(l, timestamp);
+  }
+
+  for(uint8_t g = 0; g < count; g++) {
+    float value = values[g];
+    if(isnan(value) || isinf(value)) continue;
+    for(uint8_t l = 0; l < HMS_MQXXX_ROLLUP_LEVELS; l++) {
+      Bucket &bucket = buckets[g][levelOffset(l) + levels[l].current];
+      if(bucket.count == 0) {
+        bucket.min   = value;
+        bucket.max   = value;
+        bucket.mean  = value;
+        bucket.carry = 0;
+        bucket.count = 1;
+        continue;
+      }
+      if(value < bucket.min) bucket.min = value;
+      if(value > bucket.max) bucket.max = value;
+      bucket.count++;
+      float step   = (value - bucket.mean) / (float)bucket.count - bucket.carry;
+      float mean   = bucket.mean + step;
+      bucket.carry = (mean - bucket.mean) - step;                           // What the add rounded away
+      bucket.mean  = mean;
+    }
+  }
+}
+
+bool HMS_MQXXX_Rollup::getBucket(uint8_t level, uint8_t gas, uint16_t age, HMS_MQXXX_RollupStats *stats, uint32_t *start) const {
+  if(stats == NULL || level >= HMS_MQXXX_ROLLUP_LEVELS || gas >= gasCount || age >= levels[level].filled) return false;
+
+  uint16_t      slots  = levelSlots[level];
+  const Bucket &bucket = buckets[gas][levelOffset(level) + (levels[level].current + slots - age) % slots];
+  stats->count = bucket.count;
+  stats->min   = (bucket.count > 0) ? bucket.min  : NAN;
+  stats->max   = (bucket.count > 0) ? bucket.max  : NAN;
+  stats->mean  = (bucket.count > 0) ? bucket.mean : NAN;
+  if(start != NULL) *start = levels[level].start - (uint32_t)age * levelPeriods[level];
+  return true;
+}
+
+bool HMS_MQXXX_Rollup::getWindow(uint8_t level, uint8_t gas, HMS_MQXXX_RollupStats *stats) const {
+  if(stats == NULL || level >= HMS_MQXXX_ROLLUP_LEVELS || gas >= gasCount) return false;
+
+  double   weighted = 0;
+  uint32_t count    = 0;
+  stats->min = NAN;
+  stats->max = NAN;
+  for(uint16_t s = 0; s < levels[level].filled; s++) {
+    const Bucket &bucket = buckets[gas][levelOffset(level) + s];
+    if(bucket.count == 0) continue;
+    if(count == 0 || bucket.min < stats->min) stats->min = bucket.min;
+    if(count == 0 || bucket.max > stats->max) stats->max = bucket.max;
+    weighted += (double)bucket.mean * bucket.count;
+    count    += bucket.count;
+  }
+  stats->count = count;
+  stats->mean  = (count > 0) ? (float)(weighted / count) : NAN;
+  return true;
+}
@@ -0,0 +1,195 @@
+#include "HMS_MQXXX_Service.h"
+
+#if defined(HMS_MQXXX_SERVICE_AVAILABLE)
+
+static_assert(HMS_MQXXX_SERVICE_MAX_SENSORS <= 32, "One notification bit per sensor");
+
+HMS_MQXXX_Service::HMS_MQXXX_Service() {
+  for(uint8_t i = 0; i < HMS_MQXXX_SERVICE_MAX_SENSORS; i++)   sensors[i]   = NULL;
+  for(uint8_t i = 0; i < HMS_MQXXX_SERVICE_MAX_CONSUMERS; i++) consumers[i] = NULL;
+}
+
+HMS_MQXXX_Service::~HMS_MQXXX_Service() {
+  configASSERT(task == NULL || task != xTaskGetCurrentTaskHandle());       // Would wait for its own exit
+  stop();
+  bool left = waitExit();                                                   // Let the task leave readSensor() first
+  configASSERT(left);
+  (void)left;
+  #if defined(HMS_MQXXX_SERVICE_STATIC_TASK)
+  if(parkedTask != NULL) vTaskDelete(parkedTask);                           // Blocked in run(), its TCB is ours to release
+  #endif
+  #if (HMS_MQXXX_SERVICE_QUEUE_DEPTH > 0) && !(defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1))
+  if(queue != NULL) vQueueDelete(queue);
+  #endif
+  #if !(defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1))
+  if(exited != NULL) vSemaphoreDelete(exited);
+  #endif
+}
+
+// Every start() is paired with one give from run(); false when the task did not leave in time
+bool HMS_MQXXX_Service::waitExit() {
+  if(!awaitingExit) return true;
+  if(xSemaphoreTake(exited, pdMS_TO_TICKS(HMS_MQXXX_SERVICE_STOP_TIMEOUT)) != pdTRUE) return false;
+  awaitingExit = false;
+  return true;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Service::addSensor(HMS_MQXXX *sensor, uint8_t *index) {
+  if(sensor == NULL || task != NULL)                    return HMS_MQXXX_ERROR;
+  if(sensorCount >= HMS_MQXXX_SERVICE_MAX_SENSORS)      return HMS_MQXXX_ERROR;
+  if(index != NULL) *index = sensorCount;
+  sensors[sensorCount++] = sensor;
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Service::addConsumer(TaskHandle_t consumer) {
+  if(consumer == NULL || task != NULL)                  return HMS_MQXXX_ERROR;
+  if(consumerCount >= HMS_MQXXX_SERVICE_MAX_CONSUMERS)  return HMS_MQXXX_ERROR;
+  consumers[consumerCount++] = consumer;
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Service::start(uint32_t periodMs, UBaseType_t priority, BaseType_t core) {
+  if(task != NULL || sensorCount == 0) return HMS_MQXXX_ERROR;
+  if(!waitExit())                      return HMS_MQXXX_ERROR;             // Previous run still on its way out
+
+  if(exited == NULL) {
+    #if defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+    exited = xSemaphoreCreateBinaryStatic(&exitedControl);
+    #else
+    exited = xSemaphoreCreateBinary();
+    #endif
+    if(exited == NULL) return HMS_MQXXX_ERROR;
+  }
+
+  #if (HMS_MQXXX_SERVICE_QUEUE_DEPTH > 0)
+  if(queue == NULL) {
+    #if defined(configSUPPORT_STATIC_ALLOCATION) && (configSUPPORT_STATIC_ALLOCATION == 1)
+    queue = xQueueCreateStatic(HMS_MQXXX_SERVICE_QUEUE_DEPTH, sizeof(HMS_MQXXX_ServiceReading), queueStorage, &queueControl);
+    #else
+    queue = xQueueCreate(HMS_MQXXX_SERVICE_QUEUE_DEPTH, sizeof(HMS_MQXXX_ServiceReading));   // Allocated once, kept across restarts
+    #endif
+    if(queue == NULL) return HMS_MQXXX_ERROR;
+  }
+  #endif
+
+  period  = pdMS_TO_TICKS(periodMs);
+  if(period == 0) period = 1;
+  running      = true;
+  awaitingExit = true;
+
+  TaskHandle_t handle = NULL;
+  BaseType_t   result;
+  #if defined(HMS_MQXXX_SERVICE_STATIC_TASK)
+  if(parkedTask != NULL) {
+    vTaskPrioritySet(parkedTask, priority);
+    task = parkedTask;
+    xTaskNotifyGive(parkedTask);                                            // Leave the park loop in run()
+    return HMS_MQXXX_OK;
+  }
+    #if defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  handle = xTaskCreateStaticPinnedToCore(taskEntry, "hms_mqxxx", HMS_MQXXX_SERVICE_STACK_DEPTH, this, priority, taskStack, &taskControl, core);
+    #else
+  handle = xTaskCreateStatic(taskEntry, "hms_mqxxx", HMS_MQXXX_SERVICE_STACK_DEPTH, this, priority, taskStack, &taskControl);
+      #if defined(configUSE_CORE_AFFINITY) && (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+  if(handle != NULL && core >= 0 && core < configNUMBER_OF_CORES) vTaskCoreAffinitySet(handle, (UBaseType_t)1 << core);
+      #else
+  (void)core;
+      #endif
+    #endif
+  result     = (handle != NULL) ? pdPASS : pdFAIL;
+  parkedTask = handle;
+  #elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  result = xTaskCreatePinnedToCore(taskEntry, "hms_mqxxx", HMS_MQXXX_SERVICE_STACK_DEPTH, this, priority, &handle, core);
+  #else
+  result = xTaskCreate(taskEntry, "hms_mqxxx", HMS_MQXXX_SERVICE_STACK_DEPTH, this, priority, &handle);
+    #if defined(configUSE_CORE_AFFINITY) && (configUSE_CORE_AFFINITY == 1) && (configNUMBER_OF_CORES > 1)
+    if(result == pdPASS && core >= 0 && core < configNUMBER_OF_CORES) vTaskCoreAffinitySet(handle, (UBaseType_t)1 << core);
+    #else
+    (void)core;                                                             // Single core port, nothing to pin
+    #endif
+  #endif
+  if(result != pdPASS) {
+    running      = false;
+    awaitingExit = false;
+    return HMS_MQXXX_ERROR;
+  }
+  task = handle;
+  return HMS_MQXXX_OK;
+}
+
+void HMS_MQXXX_Service::stop() {
+  running = false;
+  trigger();                                                                // Cut the period wait short
+}
+
+void HMS_MQXXX_Service::trigger() {
+  TaskHandle_t handle = task;
+  if(handle != NULL) xTaskNotifyGive(handle);
+}
+
+bool HMS_MQXXX_Service::getReading(uint8_t index, HMS_MQXXX_Reading *reading) const {
+  if(index >= sensorCount) return false;
+  return sensors[index]->getLatestReading(reading);
+}
+
+void HMS_MQXXX_Service::taskEntry(void *arg) {
+  static_cast<HMS_MQXXX_Service *>(arg)->run();
+}
+
+void HMS_MQXXX_Service::run() {
+  #if defined(HMS_MQXXX_SERVICE_STATIC_TASK)
+  for(;;) {
+  #endif
+  TickType_t wake = xTaskGetTickCount();
+  while(running) {
+    sampleAll();
+
+    // Fixed-rate schedule; a trigger or an overrun restarts it from now
+    TickType_t elapsed = xTaskGetTickCount() - wake;
+    if(elapsed < period && ulTaskNotifyTake(pdTRUE, period - elapsed) == 0) {
+      wake += period;
+    } else {
+      wake = xTaskGetTickCount();
+    }
+  }
+  task = NULL;
+  xSemaphoreGive(exited);                                                   // Last touch of the object on the way out
+  #if defined(HMS_MQXXX_SERVICE_STATIC_TASK)
+  // A self-deleted static task stays on the termination list until the idle task runs, so it
+  // is parked instead and its storage reused by the next start()
+  while(!running) ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+  }
+  #else
+  vTaskDelete(NULL);
+  #endif
+}
+
+void HMS_MQXXX_Service::sampleAll() {
+  uint32_t sampled = 0;
+  for(uint8_t i = 0; i < sensorCount && running; i++) {
+    HMS_MQXXX *sensor = sensors[i];
+    sensor->updateCalibration();                                            // Not update(): readSensor() already feeds the warm-up
+    sensor->readSensor();
+
+    HMS_MQXXX_ServiceReading item;
+    item.index = i;
+    if(!sensor->getLatestReading(&item.reading)) continue;
+    sampled |= 1UL << i;
+
+    if(queue != NULL && xQueueSend(queue, &item, 0) != pdPASS) {
+      HMS_MQXXX_ServiceReading oldest;
+      xQueueReceive(queue, &oldest, 0);                                     // Slow consumer: keep the newest readings
+      xQueueSend(queue, &item, 0);
+      dropped = dropped + 1;
+    }
+  }
+  cycles = cycles + 1;
+
+  if(sampled == 0) return;
+  for(uint8_t c = 0; c < consumerCount; c++) {
+    xTaskNotify(consumers[c], sampled, eSetBits);
+  }
+}
+
+#endif // HMS_MQXXX_SERVICE_AVAILABLE
@@ -0,0 +1,334 @@
+#include "HMS_MQXXX_DRIVER.h"
+
+#include <stdio.h>
+#include <string.h>
+
+/*
+  CRC-32 (IEEE 802.3, reflected 0xEDB88320) with a 16 entry nibble table. Small enough for
+  AVR flash and still ~2 table lookups per byte, which is plenty for a 40 byte record.
+*/
+uint32_t HMS_MQXXX_Crc32(const void *data, size_t length, uint32_t crc) {
+  static const uint32_t table[16] = {
+    0x00000000UL, 0x1DB71064UL, 0x3B6E20C8UL, 0x26D930ACUL,
+    0x76DC4190UL, 0x6B6B51F4UL, 0x4DB26158UL, 0x5005713CUL,
+    0xEDB88320UL, 0xF00F9344UL, 0xD6D6A3E8UL, 0xCB61B38CUL,
+    0x9B64C2B0UL, 0x86D3D2D4UL, 0xA00AE278UL, 0xBDBDF21CUL
+  };
+  const uint8_t *bytes = (const uint8_t *)data;
+
+  crc = ~crc;
+  for(size_t i = 0; i < length; i++) {
+    crc = (crc >> 4) ^ table[(crc ^ bytes[i]) & 0x0F];
+    crc = (crc >> 4) ^ table[(crc ^ (bytes[i] >> 4)) & 0x0F];
+  }
+  return ~crc;
+}
+
+#if defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+/*
+  Raw flash helpers shared by the calibration table and the flash log. Sector-erase parts
+  (F2/F4/F7) take the sector number, page-erase parts derive the page from the address.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_STM32FlashErase(uint32_t address, uint32_t sector) {
+  FLASH_EraseInitTypeDef erase;
+  uint32_t               error = 0;
+  memset(&erase, 0, sizeof(erase));
+
+  #if defined(FLASH_TYPEERASE_SECTORS)
+  erase.TypeErase    = FLASH_TYPEERASE_SECTORS;
+  erase.Sector       = sector;
+  erase.NbSectors    = 1;
+    #if defined(FLASH_VOLTAGE_RANGE_3)
+  erase.VoltageRange = FLASH_VOLTAGE_RANGE_3;
+    #endif
+  #elif defined(STM32F0) || defined(STM32F1) || defined(STM32F3) || defined(STM32L0) || defined(STM32L1)
+  erase.TypeErase    = FLASH_TYPEERASE_PAGES;
+  erase.PageAddress  = address;
+  erase.NbPages      = 1;
+  #else
+  erase.TypeErase    = FLASH_TYPEERASE_PAGES;
+  erase.Page         = (address - FLASH_BASE) / FLASH_PAGE_SIZE;
+  erase.NbPages      = 1;
+    #if defined(FLASH_BANK_1)
+  erase.Banks        = FLASH_BANK_1;
+    #endif
+  #endif
+  (void)address;
+  (void)sector;
+
+  return (HAL_FLASHEx_Erase(&erase, &error) == HAL_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_STM32FlashProgram(uint32_t address, const void *data, size_t length) {
+  const uint8_t *bytes = (const uint8_t *)data;
+
+  #if defined(FLASH_TYPEPROGRAM_WORD)
+  for(size_t offset = 0; offset < length; offset += 4) {
+    uint32_t word;
+    memcpy(&word, bytes + offset, 4);
+    if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_WORD, address + offset, word) != HAL_OK) return HMS_MQXXX_ERROR;
+  }
+  #else
+  for(size_t offset = 0; offset < length; offset += 8) {
+    uint64_t dword;
+    memcpy(&dword, bytes + offset, 8);
+    if(HAL_FLASH_Program(FLASH_TYPEPROGRAM_DOUBLEWORD, address + offset, dword) != HAL_OK) return HMS_MQXXX_ERROR;
+  }
+  #endif
+  return HMS_MQXXX_OK;
+}
+#endif
+
+#if defined(HMS_MQXXX_STORAGE_ENABLED) && (HMS_MQXXX_STORAGE_ENABLED == 1)
+
+#if defined(HMS_MQXXX_PLATFORM_ARDUINO)
+  #include <EEPROM.h>
+#elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+  #include "nvs.h"
+#endif
+
+static bool recordIsValid(const HMS_MQXXX_CalibrationRecord *record) {
+  if(record->magic   != HMS_MQXXX_CALIBRATION_MAGIC)          return false;
+  if(record->version != HMS_MQXXX_CALIBRATION_VERSION)        return false;
+  if(record->length  != sizeof(HMS_MQXXX_CalibrationRecord))  return false;
+  if(record->crc     != HMS_MQXXX_Crc32(record, offsetof(HMS_MQXXX_CalibrationRecord, crc))) return false;
+  if(isnan(record->r0) || isinf(record->r0) || record->r0 <= 0) return false;
+  if(isnan(record->rl) || isinf(record->rl) || record->rl <= 0) return false;
+  if(isnan(record->vcc) || isinf(record->vcc) || record->vcc <= 0) return false;
+  return true;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::saveCalibration(uint32_t timestamp) {
+  if(storageSlot >= HMS_MQXXX_STORAGE_SLOTS) return HMS_MQXXX_ERROR;
+
+  HMS_MQXXX_CalibrationRecord record;
+  memset(&record, 0, sizeof(record));
+  record.magic      = HMS_MQXXX_CALIBRATION_MAGIC;
+  record.version    = HMS_MQXXX_CALIBRATION_VERSION;
+  record.length     = sizeof(HMS_MQXXX_CalibrationRecord);
+  record.type       = (uint8_t)getType();
+  record.regression = (uint8_t)getRegressionMethod();
+  record.r0         = r0;
+  record.rl         = getRL();
+  record.vcc        = getVCC();
+  record.a          = getA();
+  record.b          = getB();
+  record.timestamp  = timestamp;
+  record.crc        = HMS_MQXXX_Crc32(&record, offsetof(HMS_MQXXX_CalibrationRecord, crc));
+
+  HMS_MQXXX_StatusTypeDef status = storageWrite(storageSlot, &record);
+  if(status == HMS_MQXXX_OK) calibrationTime = timestamp;
+  return status;
+}
+
+/*
+  Restores the record for this slot. Age is only enforced when both the caller's clock and the
+  record carry a timestamp, so targets without a wall clock still get warm boots. Compact
+  builds cannot take the stored divider and curve (they live in the shared const profile), so
+  a record saved under different settings is refused with ERROR: its R0 only holds for them.
+*/
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::restoreCalibration(uint32_t now, uint32_t maxAge) {
+  if(storageSlot >= HMS_MQXXX_STORAGE_SLOTS) return HMS_MQXXX_ERROR;
+
+  HMS_MQXXX_CalibrationRecord record;
+  HMS_MQXXX_StatusTypeDef status = storageRead(storageSlot, &record);
+  if(status != HMS_MQXXX_OK)             return status;
+  if(!recordIsValid(&record))            return HMS_MQXXX_NOT_FOUND;
+  if(record.type != (uint8_t)getType())  return HMS_MQXXX_NOT_FOUND;
+
+  if(maxAge != 0 && now != 0 && record.timestamp != 0) {
+    if(now < record.timestamp || (now - record.timestamp) > maxAge) return HMS_MQXXX_STALE;
+  }
+
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  if(record.rl != getRL() || record.vcc != getVCC() || record.a != getA() || record.b != getB() ||
+     record.regression != (uint8_t)getRegressionMethod()) {
+    return HMS_MQXXX_ERROR;                                                 // Saved under another profile, setProfile() first
+  }
+  #endif
+
+  r0              = record.r0;
+  calibrationTime = record.timestamp;
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  readingValid    = false;                                                  // Profile already matches the record
+  #else
+  rl              = record.rl;
+  vcc             = record.vcc;
+  regression      = (HMS_MQXXX_Regression)record.regression;
+  setA(record.a);
+  setB(record.b);
+  #endif
+  return HMS_MQXXX_OK;
+}
+
+#if defined(HMS_MQXXX_PLATFORM_ARDUINO)
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record) {
+  #if defined(ESP32) || defined(ESP8266)
+  EEPROM.begin(HMS_MQXXX_EEPROM_SIZE);
+  #endif
+  EEPROM.get(HMS_MQXXX_EEPROM_ADDRESS + slot * sizeof(HMS_MQXXX_CalibrationRecord), *record);
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record) {
+  #if defined(ESP32) || defined(ESP8266)
+  EEPROM.begin(HMS_MQXXX_EEPROM_SIZE);
+  #endif
+  EEPROM.put(HMS_MQXXX_EEPROM_ADDRESS + slot * sizeof(HMS_MQXXX_CalibrationRecord), *record);  // put() skips unchanged bytes
+  #if defined(ESP32) || defined(ESP8266)
+  if(!EEPROM.commit()) return HMS_MQXXX_ERROR;
+  #endif
+  return HMS_MQXXX_OK;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_ESP_IDF)
+static void nvsKey(uint8_t slot, char *key) {
+  snprintf(key, 8, "cal%u", (unsigned)slot);
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record) {
+  nvs_handle_t handle;
+  char key[8];
+  nvsKey(slot, key);
+
+  esp_err_t err = nvs_open(HMS_MQXXX_NVS_NAMESPACE, NVS_READONLY, &handle);
+  if(err == ESP_ERR_NVS_NOT_FOUND) return HMS_MQXXX_NOT_FOUND;                // Namespace not created yet
+  if(err != ESP_OK)                return HMS_MQXXX_ERROR;
+
+  size_t length = sizeof(HMS_MQXXX_CalibrationRecord);
+  err = nvs_get_blob(handle, key, record, &length);
+  nvs_close(handle);
+
+  if(err == ESP_ERR_NVS_NOT_FOUND || length != sizeof(HMS_MQXXX_CalibrationRecord)) return HMS_MQXXX_NOT_FOUND;
+  return (err == ESP_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record) {
+  nvs_handle_t handle;
+  char key[8];
+  nvsKey(slot, key);
+
+  if(nvs_open(HMS_MQXXX_NVS_NAMESPACE, NVS_READWRITE, &handle) != ESP_OK) return HMS_MQXXX_ERROR;
+  esp_err_t err = nvs_set_blob(handle, key, record, sizeof(HMS_MQXXX_CalibrationRecord));
+  if(err == ESP_OK) err = nvs_commit(handle);
+  nvs_close(handle);
+  return (err == ESP_OK) ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+/*
+  Flash emulation on two erase units (A/B) so a power loss never takes the only copy. Each
+  holds a header and the whole slot table. A write patches the newest table into the unit not
+  in use, programs the header (sequence number, CRC over sequence and table) last as the commit
+  marker, and leaves the previous unit untouched until the write after. Reads take the valid
+  unit with the newest sequence. Keep both pages/sectors out of the linker's reach.
+*/
+typedef struct {
+  uint32_t  magic;
+  uint32_t  sequence;                                                       // Bumped per write, the newest valid unit wins
+  uint32_t  crc;                                                            // CRC-32 of sequence and the record table
+  uint32_t  reserved;
+} FlashPageHeader;
+
+static const uint32_t flashPageMagic     = 0x50534D48UL;                    // "HMSP" little-endian
+static const uint32_t flashPageAddress[] = { HMS_MQXXX_STM32_FLASH_ADDRESS, HMS_MQXXX_STM32_FLASH_ADDRESS_B };
+static const uint32_t flashPageSector[]  = { HMS_MQXXX_STM32_FLASH_SECTOR,  HMS_MQXXX_STM32_FLASH_SECTOR_B  };
+
+static_assert(((sizeof(HMS_MQXXX_CalibrationRecord) * HMS_MQXXX_STORAGE_SLOTS) % 8) == 0, "Record table must be whole doublewords");
+
+static uint32_t flashPageCrc(uint32_t sequence, const void *table) {
+  uint32_t crc = HMS_MQXXX_Crc32(&sequence, sizeof(sequence));
+  return HMS_MQXXX_Crc32(table, sizeof(HMS_MQXXX_CalibrationRecord) * HMS_MQXXX_STORAGE_SLOTS, crc);
+}
+
+// Index of the unit holding the newest committed table, -1 when neither does
+static int8_t flashActivePage(uint32_t *sequence) {
+  int8_t active = -1;
+  for(int8_t page = 0; page < 2; page++) {
+    FlashPageHeader header;
+    memcpy(&header, (const void *)(uintptr_t)flashPageAddress[page], sizeof(header));
+    if(header.magic != flashPageMagic) continue;
+    if(header.crc != flashPageCrc(header.sequence, (const void *)(flashPageAddress[page] + sizeof(header)))) continue;
+    if(active < 0 || (int32_t)(header.sequence - *sequence) > 0) {
+      active    = page;
+      *sequence = header.sequence;
+    }
+  }
+  return active;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record) {
+  uint32_t sequence = 0;
+  int8_t   page     = flashActivePage(&sequence);
+  if(page < 0) return HMS_MQXXX_NOT_FOUND;
+  memcpy(record, (const void *)(flashPageAddress[page] + sizeof(FlashPageHeader) + slot * sizeof(HMS_MQXXX_CalibrationRecord)),
+         sizeof(HMS_MQXXX_CalibrationRecord));
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record) {
+  HMS_MQXXX_CalibrationRecord table[HMS_MQXXX_STORAGE_SLOTS];
+  uint32_t                    sequence = 0;
+  int8_t                      active   = flashActivePage(&sequence);
+  memset(table, 0xFF, sizeof(table));                                       // Same "erased" state as flash
+  if(active >= 0) memcpy(table, (const void *)(flashPageAddress[active] + sizeof(FlashPageHeader)), sizeof(table));
+  table[slot] = *record;
+
+  uint8_t         target = (active == 0) ? 1 : 0;
+  FlashPageHeader header;
+  header.magic    = flashPageMagic;
+  header.sequence = (active >= 0) ? sequence + 1 : 1;
+  header.crc      = flashPageCrc(header.sequence, table);
+  header.reserved = 0xFFFFFFFFUL;
+
+  HAL_FLASH_Unlock();
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_STM32FlashErase(flashPageAddress[target], flashPageSector[target]);
+  if(status == HMS_MQXXX_OK) status = HMS_MQXXX_STM32FlashProgram(flashPageAddress[target] + sizeof(header), table, sizeof(table));
+  if(status == HMS_MQXXX_OK) status = HMS_MQXXX_STM32FlashProgram(flashPageAddress[target], &header, sizeof(header));   // Commit
+  HAL_FLASH_Lock();
+  return status;
+}
+
+#elif defined(HMS_MQXXX_PLATFORM_HOST)
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record) {
+  FILE *file = fopen(HMS_MQXXX_HOST_STORAGE_PATH, "rb");
+  if(file == NULL) return HMS_MQXXX_NOT_FOUND;
+
+  bool found = (fseek(file, (long)(slot * sizeof(HMS_MQXXX_CalibrationRecord)), SEEK_SET) == 0) &&
+               (fread(record, sizeof(HMS_MQXXX_CalibrationRecord), 1, file) == 1);
+  fclose(file);
+  return found ? HMS_MQXXX_OK : HMS_MQXXX_NOT_FOUND;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record) {
+  HMS_MQXXX_CalibrationRecord table[HMS_MQXXX_STORAGE_SLOTS];
+  memset(table, 0xFF, sizeof(table));                                       // Same "erased" state as flash
+
+  FILE *file = fopen(HMS_MQXXX_HOST_STORAGE_PATH, "rb");
+  if(file != NULL) {
+    size_t existing = fread(table, sizeof(HMS_MQXXX_CalibrationRecord), HMS_MQXXX_STORAGE_SLOTS, file);
+    (void)existing;
+    fclose(file);
+  }
+  table[slot] = *record;
+
+  file = fopen(HMS_MQXXX_HOST_STORAGE_PATH, "wb");
+  if(file == NULL) return HMS_MQXXX_ERROR;
+  bool written = (fwrite(table, sizeof(table), 1, file) == 1);
+  written = (fclose(file) == 0) && written;
+  return written ? HMS_MQXXX_OK : HMS_MQXXX_ERROR;
+}
+
+#else
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageRead(uint8_t slot, HMS_MQXXX_CalibrationRecord *record) {
+  (void)slot; (void)record;
+  return HMS_MQXXX_NOT_FOUND;                                               // No backend on this platform yet
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX::storageWrite(uint8_t slot, const HMS_MQXXX_CalibrationRecord *record) {
+  (void)slot; (void)record;
+  return HMS_MQXXX_ERROR;
+}
+#endif
+
+#endif // HMS_MQXXX_STORAGE_ENABLED
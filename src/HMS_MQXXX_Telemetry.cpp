@@ -0,0 +1,262 @@
+#include "HMS_MQXXX_Telemetry.h"
+
+#include <string.h>
+#include <math.h>
+
+static_assert(HMS_MQXXX_TELEMETRY_FRAME_SIZE >= HMS_MQXXX_TELEMETRY_HEADER_SIZE + HMS_MQXXX_TELEMETRY_RECORD_MAX,
+              "A frame must hold at least its header and one record");
+static_assert(HMS_MQXXX_TELEMETRY_FRAME_SIZE <= 1024, "Record count is a uint8_t");
+
+static inline uint32_t floatBits(float value) {
+  uint32_t bits;
+  memcpy(&bits, &value, sizeof(bits));
+  return bits;
+}
+
+static inline float bitsFloat(uint32_t bits) {
+  float value;
+  memcpy(&value, &bits, sizeof(value));
+  return value;
+}
+
+static inline void putLE(uint8_t *out, uint32_t value, uint8_t bytes) {
+  for(uint8_t i = 0; i < bytes; i++) out[i] = (uint8_t)(value >> (8 * i));
+}
+
+static inline uint32_t getLE(const uint8_t *in, uint8_t bytes) {
+  uint32_t value = 0;
+  for(uint8_t i = 0; i < bytes; i++) value |= (uint32_t)in[i] << (8 * i);
+  return value;
+}
+
+// Signed difference folded so small magnitudes of either sign give small varints
+static inline uint32_t zigzag(uint32_t difference) {
+  return (difference << 1) ^ (uint32_t)((int32_t)difference >> 31);
+}
+
+static inline uint32_t unzigzag(uint32_t value) {
+  return (value >> 1) ^ (0U - (value & 1));
+}
+
+static size_t putVarint(uint8_t *out, uint32_t value) {
+  size_t n = 0;
+  while(value >= 0x80) {
+    out[n++] = (uint8_t)(value | 0x80);
+    value  >>= 7;
+  }
+  out[n++] = (uint8_t)value;
+  return n;
+}
+
+HMS_MQXXX_Telemetry::HMS_MQXXX_Telemetry(HMS_MQXXX_FrameSink sink, void *context) : sink(sink), sinkContext(context) {
+  for(uint8_t i = 0; i < HMS_MQXXX_TELEMETRY_SOURCES; i++) {
+    sources[i].listener.callback = onReading;
+    sources[i].listener.event    = NULL;
+    sources[i].listener.context  = &sources[i];
+    sources[i].listener.next     = NULL;
+    sources[i].sensor            = NULL;
+    sources[i].owner             = this;
+    sources[i].alarm             = NAN;
+    sources[i].id                = 0;
+  }
+}
+
+HMS_MQXXX_Telemetry::~HMS_MQXXX_Telemetry() {
+  for(uint8_t i = 0; i < HMS_MQXXX_TELEMETRY_SOURCES; i++) {
+    if(sources[i].sensor != NULL) sources[i].sensor->removeListener(&sources[i].listener);
+  }
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Telemetry::attach(HMS_MQXXX *sensor, uint8_t id) {
+  if(sensor == NULL) return HMS_MQXXX_ERROR;
+  detach(sensor);
+  for(uint8_t i = 0; i < HMS_MQXXX_TELEMETRY_SOURCES; i++) {
+    if(sources[i].sensor != NULL) continue;
+    sources[i].sensor = sensor;
+    sources[i].id     = id;
+    sensor->addListener(&sources[i].listener);
+    return HMS_MQXXX_OK;
+  }
+  return HMS_MQXXX_ERROR;
+}
+
+void HMS_MQXXX_Telemetry::detach(HMS_MQXXX *sensor) {
+  for(uint8_t i = 0; i < HMS_MQXXX_TELEMETRY_SOURCES; i++) {
+    if(sources[i].sensor != sensor || sensor == NULL) continue;
+    sensor->removeListener(&sources[i].listener);
+    sources[i].sensor = NULL;
+  }
+}
+
+void HMS_MQXXX_Telemetry::setAlarmThreshold(uint8_t id, float ppm) {
+  for(uint8_t i = 0; i < HMS_MQXXX_TELEMETRY_SOURCES; i++) {
+    if(sources[i].sensor != NULL && sources[i].id == id) sources[i].alarm = ppm;
+  }
+}
+
+void HMS_MQXXX_Telemetry::onReading(const HMS_MQXXX_Reading *reading, void *context) {
+  Source *source = static_cast<Source *>(context);
+  HMS_MQXXX_TelemetryRecord record;
+  record.timestamp = reading->timestamp;
+  record.ppm       = reading->ppm;
+  record.ratio     = reading->ratio;
+  record.source    = source->id;
+  record.status    = reading->status;
+  record.flags     = reading->flags;
+  bool alarm = (reading->status == HMS_MQXXX_OK) && !isnan(source->alarm) && reading->ppm >= source->alarm;
+  source->owner->add(record, alarm);
+}
+
+/*
+  A source's first record in the frame carries its values in full and becomes the base the
+  later ones are differenced against; timestamps always chain to the previous record.
+*/
+size_t HMS_MQXXX_Telemetry::encode(const HMS_MQXXX_TelemetryRecord &record, uint8_t *out, bool *newBase) const {
+  uint8_t source = record.source & 0x7F;
+  uint8_t base   = 0;
+  while(base < baseCount && baseSource[base] != source) base++;
+  *newBase = (base == baseCount);
+
+  size_t n = 0;
+  out[n++] = (uint8_t)(source | (*newBase ? HMS_MQXXX_TELEMETRY_BASE : 0));
+  out[n++] = (uint8_t)((record.status & 0x0F) | (record.flags << 4));
+  n += putVarint(out + n, zigzag(record.timestamp - lastTimestamp));
+  if(*newBase) {
+    putLE(out + n, floatBits(record.ppm), 4);
+    putLE(out + n + 4, floatBits(record.ratio), 4);
+    return n + 8;
+  }
+  n += putVarint(out + n, zigzag(floatBits(record.ppm) - basePPM[base]));
+  n += putVarint(out + n, zigzag(floatBits(record.ratio) - baseRatio[base]));
+  return n;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Telemetry::add(const HMS_MQXXX_TelemetryRecord &record, bool urgentRecord) {
+  HMS_MQXXX_StatusTypeDef status = HMS_MQXXX_OK;
+  uint8_t                 encoded[HMS_MQXXX_TELEMETRY_RECORD_MAX];
+  bool                    newBase;
+  size_t                  n = 0;
+
+  if(count > 0) {
+    n = encode(record, encoded, &newBase);
+    if(length + n > sizeof(frame) || (newBase && baseCount == HMS_MQXXX_TELEMETRY_SOURCES) || count == 0xFF) {
+      status = flush();                                                     // Full: ship it, this record opens the next
+      if(status != HMS_MQXXX_OK) {
+        dropped += count;
+        count    = 0;
+      }
+    }
+  }
+  if(count == 0) {
+    firstTimestamp = record.timestamp;
+    lastTimestamp  = record.timestamp;
+    baseCount      = 0;
+    urgent         = false;
+    length         = HMS_MQXXX_TELEMETRY_HEADER_SIZE;
+    putLE(frame + 4, firstTimestamp, 4);                                    // Rest of the header is filled by flush()
+    n = encode(record, encoded, &newBase);
+  }
+
+  if(newBase) {
+    baseSource[baseCount] = record.source & 0x7F;
+    basePPM[baseCount]    = floatBits(record.ppm);
+    baseRatio[baseCount]  = floatBits(record.ratio);
+    baseCount++;
+  }
+  memcpy(frame + length, encoded, n);
+  length       += n;
+  lastTimestamp = record.timestamp;
+  count++;
+
+  if(urgentRecord) {
+    urgent = true;
+    return flush();
+  }
+  if(record.timestamp - firstTimestamp >= maxAge) return flush();
+  return status;
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Telemetry::poll(uint32_t now) {
+  if(count == 0 || now - firstTimestamp < maxAge) return HMS_MQXXX_OK;
+  return flush();
+}
+
+HMS_MQXXX_StatusTypeDef HMS_MQXXX_Telemetry::flush() {
+  if(count == 0)     return HMS_MQXXX_OK;
+  if(sink == NULL)   return HMS_MQXXX_ERROR;
+
+  frame[0] = (uint8_t)(HMS_MQXXX_TELEMETRY_VERSION | (urgent ? HMS_MQXXX_TELEMETRY_URGENT : 0));
+  frame[1] = count;
+  putLE(frame + 2, sequence, 2);
+  if(sink(frame, length, sinkContext) != HMS_MQXXX_OK) return HMS_MQXXX_ERROR;
+
+  framesSent++;
+  recordsSent += count;
+  sequence++;
+  count  = 0;
+  length = 0;
+  urgent = false;
+  return HMS_MQXXX_OK;
+}
+
+HMS_MQXXX_TelemetryReader::HMS_MQXXX_TelemetryReader(const uint8_t *frame, size_t length) : data(frame), length(length) {
+  valid = (frame != NULL) && (length > HMS_MQXXX_TELEMETRY_HEADER_SIZE) &&
+          ((frame[0] & ~HMS_MQXXX_TELEMETRY_URGENT) == HMS_MQXXX_TELEMETRY_VERSION) && (frame[1] > 0);
+  if(valid) timestamp = getLE(frame + 4, 4);
+  pos = HMS_MQXXX_TELEMETRY_HEADER_SIZE;
+}
+
+uint16_t HMS_MQXXX_TelemetryReader::getSequence() const {
+  return valid ? (uint16_t)getLE(data + 2, 2) : 0;
+}
+
+bool HMS_MQXXX_TelemetryReader::readVarint(uint32_t *value) {
+  uint32_t result = 0;
+  for(uint8_t shift = 0; shift < 35 && pos < length; shift += 7) {
+    uint8_t byte = data[pos++];
+    result |= (uint32_t)(byte & 0x7F) << shift;
+    if(!(byte & 0x80)) {
+      *value = result;
+      return true;
+    }
+  }
+  return false;
+}
+
+bool HMS_MQXXX_TelemetryReader::next(HMS_MQXXX_TelemetryRecord *record) {
+  if(!valid || record == NULL || index >= data[1]) return false;
+
+  uint32_t dt;
+  valid = false;                                                            // Until the record decodes cleanly
+  if(pos + 2 > length) return false;
+  uint8_t source = data[pos] & 0x7F;
+  bool    isBase = (data[pos] & HMS_MQXXX_TELEMETRY_BASE) != 0;
+  record->source = source;
+  record->status = data[pos + 1] & 0x0F;
+  record->flags  = data[pos + 1] >> 4;
+  pos += 2;
+  if(!readVarint(&dt)) return false;
+  timestamp        += unzigzag(dt);
+  record->timestamp = timestamp;
+
+  uint8_t base = 0;
+  while(base < baseCount && baseSource[base] != source) base++;
+  if(isBase) {
+    if(pos + 8 > length || base == HMS_MQXXX_TELEMETRY_SOURCES) return false;
+    baseSource[base] = source;
+    basePPM[base]    = getLE(data + pos, 4);
+    baseRatio[base]  = getLE(data + pos + 4, 4);
+    if(base == baseCount) baseCount++;
+    pos += 8;
+    record->ppm   = bitsFloat(basePPM[base]);
+    record->ratio = bitsFloat(baseRatio[base]);
+  } else {
+    uint32_t dppm, dratio;
+    if(base == baseCount || !readVarint(&dppm) || !readVarint(&dratio)) return false;
+    record->ppm   = bitsFloat(basePPM[base] + unzigzag(dppm));
+    record->ratio = bitsFloat(baseRatio[base] + unzigzag(dratio));
+  }
+  index++;
+  valid = true;
+  return true;
+}
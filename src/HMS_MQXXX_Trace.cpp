@@ -0,0 +1,96 @@
+#include "HMS_MQXXX_Trace.h"
+#include "HMS_MQXXX_Cycles.h"
+
+#if defined(HMS_MQXXX_TRACE_ENABLED)
+
+static_assert((HMS_MQXXX_TRACE_RECORDS & (HMS_MQXXX_TRACE_RECORDS - 1)) == 0 && HMS_MQXXX_TRACE_RECORDS >= 2,
+              "Trace ring size must be a power of two");
+
+static constexpr uint8_t lapShift() {
+  uint8_t shift = 0;
+  while((1UL << shift) < HMS_MQXXX_TRACE_RECORDS) shift++;
+  return shift;
+}
+
+static HMS_MQXXX_TraceRecord traceRing[HMS_MQXXX_TRACE_RECORDS];
+static uint32_t              traceHead    = 0;
+static bool                  traceEnabled = true;
+
+// Claim number of the next slot; a single atomic add where the core has one
+static inline uint32_t claim() {
+  #if defined(__AVR__)
+  uint8_t sreg = SREG;
+  cli();
+  uint32_t index = traceHead++;
+  SREG = sreg;
+  return index;
+  #elif defined(__ARM_ARCH_6M__) && defined(HMS_MQXXX_PLATFORM_STM32_HAL)
+  uint32_t primask = __get_PRIMASK();
+  __disable_irq();
+  uint32_t index = traceHead++;
+  __set_PRIMASK(primask);
+  return index;
+  #elif defined(__ARM_ARCH_6M__) && defined(HMS_MQXXX_PLATFORM_ARDUINO)
+  noInterrupts();
+  uint32_t index = traceHead++;
+  interrupts();
+  return index;
+  #elif defined(HMS_MQXXX_PLATFORM_ZEPHYR) && defined(CONFIG_ARMV6_M_ARMV8_M_BASELINE)
+  unsigned int key = irq_lock();                                            // No 32-bit atomic add without libatomic
+  uint32_t index = traceHead++;
+  irq_unlock(key);
+  return index;
+  #else
+  return __atomic_fetch_add(&traceHead, 1, __ATOMIC_RELAXED);
+  #endif
+}
+
+void HMS_MQXXX_TraceEmit(uint16_t event, uint8_t source, uint32_t arg0, uint32_t arg1) {
+  if(!__atomic_load_n(&traceEnabled, __ATOMIC_RELAXED)) return;
+
+  uint32_t               index  = claim();
+  HMS_MQXXX_TraceRecord  &slot  = traceRing[index & (HMS_MQXXX_TRACE_RECORDS - 1)];
+  slot.ticks  = HMS_MQXXX_GetTicks();
+  slot.millis = HMS_MQXXX_Millis();
+  slot.arg0   = arg0;
+  slot.arg1   = arg1;
+  slot.event  = event;
+  slot.source = source;
+  __atomic_store_n(&slot.lap, (uint8_t)(index >> lapShift()), __ATOMIC_RELEASE);
+}
+
+void HMS_MQXXX_TraceEnable(bool enable) {
+  if(enable) HMS_MQXXX_StartTicks();                                        // Sensors start it in init() too
+  __atomic_store_n(&traceEnabled, enable, __ATOMIC_RELAXED);
+}
+
+void HMS_MQXXX_TraceClear() {
+  memset(traceRing, 0, sizeof(traceRing));
+  __atomic_store_n(&traceHead, (uint32_t)0, __ATOMIC_RELEASE);
+}
+
+size_t HMS_MQXXX_TraceDumpSize() {
+  return sizeof(HMS_MQXXX_TraceDumpHeader) + sizeof(traceRing);
+}
+
+size_t HMS_MQXXX_TraceDump(uint8_t *out, size_t capacity) {
+  if(out == NULL || capacity < HMS_MQXXX_TraceDumpSize()) return 0;
+
+  HMS_MQXXX_TraceDumpHeader header;
+  header.magic      = HMS_MQXXX_TRACE_MAGIC;
+  header.version    = HMS_MQXXX_TRACE_VERSION;
+  header.recordSize = sizeof(HMS_MQXXX_TraceRecord);
+  header.capacity   = HMS_MQXXX_TRACE_RECORDS;
+  header.tickRate   = HMS_MQXXX_GetTickRate();
+  header.head       = __atomic_load_n(&traceHead, __ATOMIC_ACQUIRE);
+  memcpy(out + sizeof(header), traceRing, sizeof(traceRing));
+  __atomic_thread_fence(__ATOMIC_ACQUIRE);
+
+  // Writers that claimed a slot after `head` may have rewritten anything older than this
+  uint32_t after = __atomic_load_n(&traceHead, __ATOMIC_RELAXED);
+  header.stable  = (after > HMS_MQXXX_TRACE_RECORDS) ? after - HMS_MQXXX_TRACE_RECORDS : 0;
+  memcpy(out, &header, sizeof(header));
+  return HMS_MQXXX_TraceDumpSize();
+}
+
+#endif
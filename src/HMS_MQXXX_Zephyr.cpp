@@ -0,0 +1,323 @@
+#include "HMS_MQXXX_DRIVER.h"
+
+#if defined(HMS_MQXXX_PLATFORM_ZEPHYR) && defined(CONFIG_HMS_MQXXX_SENSOR)
+
+#define DT_DRV_COMPAT hms_mqxxx
+
+#include <errno.h>
+#include <zephyr/device.h>
+#include <zephyr/drivers/adc.h>
+#include <zephyr/drivers/sensor.h>
+#include <zephyr/logging/log.h>
+#if defined(CONFIG_SENSOR_ASYNC_API)
+  #include <zephyr/drivers/sensor_data_types.h>
+  #include <zephyr/rtio/rtio.h>
+#endif
+
+#include "HMS_MQXXX_Zephyr.h"
+
+LOG_MODULE_REGISTER(hms_mqxxx, CONFIG_SENSOR_LOG_LEVEL);
+
+/*
+  Devicetree "hms,mqxxx" nodes on top of the regular driver class. Acquisition goes through the
+  Zephyr ADC API (io-channels), everything after it through HMS_MQXXX::processVoltage() /
+  convertVoltage(), so readings match readSensor() on the other platforms.
+*/
+struct hms_mqxxx_config {
+  struct adc_dt_spec    adc;
+  HMS_MQXXX             *sensor;
+  uint32_t              loadOhms;
+  uint32_t              supplyMicrovolt;
+  uint32_t              r0Ohms;
+  uint8_t               oversampling;
+};
+
+struct hms_mqxxx_data {
+  struct k_mutex        lock;                                               // HMS_MQXXX is a single-writer object
+  HMS_MQXXX_Reading     reading;
+  float                 gasPPM[HMS_MQXXX_MAX_GASES];                         // HMS_MQXXX_GetGasCurves() order
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+  HMS_MQXXX_Profile     profile;                                            // Built-in profile with the devicetree divider
+#endif
+};
+
+static int hmsAcquire(const struct device *dev, float *voltage) {
+  const struct hms_mqxxx_config *cfg = (const struct hms_mqxxx_config *)dev->config;
+  int16_t sample = 0;
+  struct adc_sequence sequence = {};
+  sequence.buffer      = &sample;
+  sequence.buffer_size = sizeof(sample);
+
+  int rc = adc_sequence_init_dt(&cfg->adc, &sequence);
+  if(rc != 0) return rc;
+
+  uint8_t samples = (cfg->oversampling > 0) ? cfg->oversampling : 1;
+  int32_t sum = 0;
+  for(uint8_t i = 0; i < samples; i++) {
+    rc = adc_read(cfg->adc.dev, &sequence);
+    if(rc != 0) return rc;
+    int32_t mv = sample;
+    rc = adc_raw_to_millivolts_dt(&cfg->adc, &mv);                          // Per sample, the sum would overflow the scaling
+    if(rc != 0) return rc;
+    sum += mv;
+  }
+  *voltage = (float)sum / (1000.0f * (float)samples);
+  return 0;
+}
+
+static bool hmsGasIndex(const HMS_MQXXX *sensor, int chan, uint8_t *index) {
+  if(chan < HMS_MQXXX_SENSOR_CHAN_GAS_BASE || chan >= HMS_MQXXX_SENSOR_CHAN_GAS_BASE + HMS_MQXXX_GAS_COUNT) return false;
+  uint8_t count;
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(sensor->getType(), &count);
+  for(uint8_t i = 0; i < count; i++) {
+    if((int)curves[i].gas == chan - HMS_MQXXX_SENSOR_CHAN_GAS_BASE) {
+      *index = i;
+      return true;
+    }
+  }
+  return false;
+}
+
+static bool hmsChannelSupported(const HMS_MQXXX *sensor, int chan) {
+  uint8_t index;
+  switch(chan) {
+    case SENSOR_CHAN_VOLTAGE:
+    case SENSOR_CHAN_GAS_RES:
+    case HMS_MQXXX_SENSOR_CHAN_RATIO:
+    case HMS_MQXXX_SENSOR_CHAN_PPM:
+      return true;
+    default:
+      return hmsGasIndex(sensor, chan, &index);
+  }
+}
+
+static int hmsChannelValue(const HMS_MQXXX *sensor, const HMS_MQXXX_Reading *reading, const float *gasPPM, int chan, float *value) {
+  uint8_t index;
+  switch(chan) {
+    case SENSOR_CHAN_VOLTAGE:           *value = reading->voltage;          return 0;
+    case SENSOR_CHAN_GAS_RES:           *value = reading->rs * 1000.0f;     return 0;   // Driver works in kilo ohms
+    case HMS_MQXXX_SENSOR_CHAN_RATIO:   *value = reading->ratio;            return 0;
+    case HMS_MQXXX_SENSOR_CHAN_PPM:     *value = reading->ppm;              return 0;
+    default:
+      if(!hmsGasIndex(sensor, chan, &index)) return -ENOTSUP;
+      *value = gasPPM[index];
+      return 0;
+  }
+}
+
+static int hmsSampleFetch(const struct device *dev, enum sensor_channel chan) {
+  const struct hms_mqxxx_config *cfg  = (const struct hms_mqxxx_config *)dev->config;
+  struct hms_mqxxx_data         *data = (struct hms_mqxxx_data *)dev->data;
+
+  if(chan != SENSOR_CHAN_ALL && !hmsChannelSupported(cfg->sensor, chan)) return -ENOTSUP;
+
+  float voltage;
+  int rc = hmsAcquire(dev, &voltage);
+  if(rc != 0) {
+    LOG_ERR("%s: ADC read failed (%d)", dev->name, rc);
+    return rc;
+  }
+
+  k_mutex_lock(&data->lock, K_FOREVER);
+  data->reading  = cfg->sensor->processVoltage(voltage);
+  cfg->sensor->evaluateGases(data->reading.ratio, data->gasPPM, HMS_MQXXX_MAX_GASES);
+  k_mutex_unlock(&data->lock);
+  return 0;
+}
+
+static int hmsChannelGet(const struct device *dev, enum sensor_channel chan, struct sensor_value *val) {
+  const struct hms_mqxxx_config *cfg  = (const struct hms_mqxxx_config *)dev->config;
+  struct hms_mqxxx_data         *data = (struct hms_mqxxx_data *)dev->data;
+
+  float value;
+  k_mutex_lock(&data->lock, K_FOREVER);
+  int rc = hmsChannelValue(cfg->sensor, &data->reading, data->gasPPM, chan, &value);
+  k_mutex_unlock(&data->lock);
+  if(rc != 0) return rc;
+  return sensor_value_from_double(val, value);
+}
+
+#if defined(CONFIG_SENSOR_ASYNC_API)
+/*
+  RTIO frame. The hot path only stores the voltage; the decoder runs the const conversion
+  (convertVoltage()/evaluateGases()) later, in the consumer's context.
+*/
+struct hms_mqxxx_encoded {
+  uint64_t              timestamp;                                          // Capture time (ns)
+  const struct device   *dev;                                               // Conversion parameters live here
+  float                 voltage;
+  uint8_t               flags;                                              // HMS_MQXXX_FLAG_WARMUP at capture time
+};
+
+static void hmsFloatToQ31(float value, int8_t *shift, q31_t *out) {
+  if(value == 0 || isnan(value)) {
+    *shift = 0;
+    *out   = 0;
+    return;
+  }
+  int exponent;
+  float mantissa = frexpf(value, &exponent);                                // value = mantissa * 2^exponent, 0.5 <= |mantissa| < 1
+  if(exponent > INT8_MAX) {
+    exponent = INT8_MAX;                                                    // FLT_MAX: saturate
+    mantissa = (value > 0) ? 1.0f : -1.0f;
+  }
+  int64_t q = (int64_t)llroundf(mantissa * 2147483648.0f);
+  if(q > INT32_MAX) q = INT32_MAX;
+  if(q < INT32_MIN) q = INT32_MIN;
+  *shift = (int8_t)exponent;
+  *out   = (q31_t)q;
+}
+
+static int hmsDecoderGetFrameCount(const uint8_t *buffer, struct sensor_chan_spec chan, uint16_t *frameCount) {
+  const struct hms_mqxxx_encoded *edata = (const struct hms_mqxxx_encoded *)buffer;
+  const struct hms_mqxxx_config  *cfg   = (const struct hms_mqxxx_config *)edata->dev->config;
+  if(chan.chan_idx != 0 || !hmsChannelSupported(cfg->sensor, chan.chan_type)) return -ENOTSUP;
+  *frameCount = 1;
+  return 0;
+}
+
+static int hmsDecoderGetSizeInfo(struct sensor_chan_spec chan, size_t *baseSize, size_t *frameSize) {
+  if(chan.chan_type != SENSOR_CHAN_VOLTAGE && chan.chan_type != SENSOR_CHAN_GAS_RES &&
+     (chan.chan_type < HMS_MQXXX_SENSOR_CHAN_RATIO || chan.chan_type >= HMS_MQXXX_SENSOR_CHAN_GAS_BASE + HMS_MQXXX_GAS_COUNT)) {
+    return -ENOTSUP;
+  }
+  *baseSize  = sizeof(struct sensor_q31_data);
+  *frameSize = sizeof(struct sensor_q31_sample_data);
+  return 0;
+}
+
+static int hmsDecoderDecode(const uint8_t *buffer, struct sensor_chan_spec chan, uint32_t *fit, uint16_t maxCount, void *dataOut) {
+  const struct hms_mqxxx_encoded *edata = (const struct hms_mqxxx_encoded *)buffer;
+  const struct hms_mqxxx_config  *cfg   = (const struct hms_mqxxx_config *)edata->dev->config;
+  if(*fit != 0 || maxCount == 0) return 0;                                  // One frame per buffer
+  if(chan.chan_idx != 0) return -ENOTSUP;
+
+  HMS_MQXXX_Reading reading = cfg->sensor->convertVoltage(edata->voltage);
+  reading.flags = (uint8_t)((reading.flags & ~HMS_MQXXX_FLAG_WARMUP) | edata->flags);
+  float gasPPM[HMS_MQXXX_MAX_GASES];
+  cfg->sensor->evaluateGases(reading.ratio, gasPPM, HMS_MQXXX_MAX_GASES);
+
+  float value;
+  int rc = hmsChannelValue(cfg->sensor, &reading, gasPPM, chan.chan_type, &value);
+  if(rc != 0) return rc;
+
+  struct sensor_q31_data *out = (struct sensor_q31_data *)dataOut;
+  out->header.base_timestamp_ns = edata->timestamp;
+  out->header.reading_count     = 1;
+  out->readings[0].timestamp_delta = 0;
+  hmsFloatToQ31(value, &out->shift, &out->readings[0].value);
+  *fit = 1;
+  return 1;
+}
+
+static bool hmsDecoderHasTrigger(const uint8_t *buffer, enum sensor_trigger_type trigger) {
+  ARG_UNUSED(buffer);
+  ARG_UNUSED(trigger);
+  return false;
+}
+
+SENSOR_DECODER_API_DT_DEFINE() = {
+  .get_frame_count  = hmsDecoderGetFrameCount,
+  .get_size_info    = hmsDecoderGetSizeInfo,
+  .decode           = hmsDecoderDecode,
+  .has_trigger      = hmsDecoderHasTrigger,
+};
+
+static int hmsGetDecoder(const struct device *dev, const struct sensor_decoder_api **decoder) {
+  ARG_UNUSED(dev);
+  *decoder = &SENSOR_DECODER_NAME();
+  return 0;
+}
+
+static void hmsSubmit(const struct device *dev, struct rtio_iodev_sqe *iodevSqe) {
+  const struct hms_mqxxx_config *cfg  = (const struct hms_mqxxx_config *)dev->config;
+  struct hms_mqxxx_data         *data = (struct hms_mqxxx_data *)dev->data;
+  uint8_t  *buf;
+  uint32_t bufLen;
+
+  int rc = rtio_sqe_rx_buf(iodevSqe, sizeof(struct hms_mqxxx_encoded), sizeof(struct hms_mqxxx_encoded), &buf, &bufLen);
+  if(rc != 0) {
+    LOG_ERR("%s: no RTIO buffer (%d)", dev->name, rc);
+    rtio_iodev_sqe_err(iodevSqe, rc);
+    return;
+  }
+
+  float voltage;
+  rc = hmsAcquire(dev, &voltage);
+  if(rc != 0) {
+    rtio_iodev_sqe_err(iodevSqe, rc);
+    return;
+  }
+
+  struct hms_mqxxx_encoded *edata = (struct hms_mqxxx_encoded *)buf;
+  k_mutex_lock(&data->lock, K_FOREVER);
+  cfg->sensor->observeVoltage(voltage);                                     // Keep warm-up tracking going while streaming
+  edata->flags = cfg->sensor->isReady() ? (uint8_t)HMS_MQXXX_FLAG_NONE : (uint8_t)HMS_MQXXX_FLAG_WARMUP;
+  k_mutex_unlock(&data->lock);
+  edata->timestamp = k_ticks_to_ns_floor64(k_uptime_ticks());
+  edata->dev       = dev;
+  edata->voltage   = voltage;
+  rtio_iodev_sqe_ok(iodevSqe, 0);
+}
+#endif // CONFIG_SENSOR_ASYNC_API
+
+static int hmsInit(const struct device *dev) {
+  const struct hms_mqxxx_config *cfg  = (const struct hms_mqxxx_config *)dev->config;
+  struct hms_mqxxx_data         *data = (struct hms_mqxxx_data *)dev->data;
+
+  k_mutex_init(&data->lock);
+  if(!adc_is_ready_dt(&cfg->adc)) {
+    LOG_ERR("%s: ADC %s not ready", dev->name, cfg->adc.dev->name);
+    return -ENODEV;
+  }
+  int rc = adc_channel_setup_dt(&cfg->adc);
+  if(rc != 0) {
+    LOG_ERR("%s: ADC channel setup failed (%d)", dev->name, rc);
+    return rc;
+  }
+
+#if defined(HMS_MQXXX_COMPACT_ENABLED)
+  data->profile     = *HMS_MQXXX_GetProfile(cfg->sensor->getType());
+  data->profile.rl  = (float)cfg->loadOhms / 1000.0f;
+  data->profile.vcc = (float)cfg->supplyMicrovolt / 1000000.0f;
+  cfg->sensor->setProfile(&data->profile);
+#else
+  cfg->sensor->setRL((float)cfg->loadOhms / 1000.0f);
+  cfg->sensor->setVCC((float)cfg->supplyMicrovolt / 1000000.0f);
+#endif
+  cfg->sensor->setR0((float)cfg->r0Ohms / 1000.0f);
+  cfg->sensor->init();
+  return 0;
+}
+
+static const struct sensor_driver_api hmsApi = {
+  .sample_fetch     = hmsSampleFetch,
+  .channel_get      = hmsChannelGet,
+#if defined(CONFIG_SENSOR_ASYNC_API)
+  .get_decoder      = hmsGetDecoder,
+  .submit           = hmsSubmit,
+#endif
+};
+
+/*
+  The HMS_MQXXX instances are C++ statics, constructed by z_init_static() right before the
+  APPLICATION level, so the devices initialise at that level rather than POST_KERNEL.
+*/
+#define HMS_MQXXX_SENSOR_DEFINE(inst)                                                              \
+  static HMS_MQXXX hmsSensor##inst(DT_INST_IO_CHANNELS_INPUT(inst),                                \
+                                   (HMS_MQXXX_Type)DT_INST_ENUM_IDX(inst, sensor_type));           \
+  static struct hms_mqxxx_data hmsData##inst;                                                      \
+  static const struct hms_mqxxx_config hmsConfig##inst = {                                         \
+    ADC_DT_SPEC_INST_GET(inst),                                                                    \
+    &hmsSensor##inst,                                                                              \
+    DT_INST_PROP(inst, load_resistance_ohms),                                                      \
+    DT_INST_PROP(inst, supply_microvolt),                                                          \
+    DT_INST_PROP(inst, r0_ohms),                                                                   \
+    DT_INST_PROP(inst, oversampling),                                                              \
+  };                                                                                               \
+  SENSOR_DEVICE_DT_INST_DEFINE(inst, hmsInit, NULL, &hmsData##inst, &hmsConfig##inst,             \
+                               APPLICATION, CONFIG_SENSOR_INIT_PRIORITY, &hmsApi);
+
+DT_INST_FOREACH_STATUS_OKAY(HMS_MQXXX_SENSOR_DEFINE)
+
+#endif // HMS_MQXXX_PLATFORM_ZEPHYR && CONFIG_HMS_MQXXX_SENSOR
@@ -0,0 +1,221 @@
+/*
+  HMS_MQXXX_Modbus served over a loopback TCP socket, the way a socket task would run it: one
+  ADU read by its MBAP length, processTCP(), the response written back. Checks input and
+  holding register reads (FC04/FC03) against the published reading, the illegal function (01)
+  and illegal address (02) exceptions, and that the MBAP transaction, protocol and unit id are
+  echoed. processRTU() is checked on its own: CRC round-trip, other address, bad CRC and
+  broadcast.
+*/
+#include "HMS_MQXXX_Modbus.h"
+#include "HMS_MQXXX_Test.h"
+
+#include <thread>
+#include <vector>
+
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <string.h>
+#include <sys/socket.h>
+#include <unistd.h>
+
+static uint16_t readADC(uint8_t, void *) {
+  return 900;
+}
+
+static bool readExactly(int fd, uint8_t *out, size_t length) {
+  while(length > 0) {
+    ssize_t n = recv(fd, out, length, 0);
+    if(n <= 0) return false;
+    out    += n;
+    length -= (size_t)n;
+  }
+  return true;
+}
+
+static bool writeAll(int fd, const uint8_t *data, size_t length) {
+  while(length > 0) {
+    ssize_t n = send(fd, data, length, 0);
+    if(n <= 0) return false;
+    data   += n;
+    length -= (size_t)n;
+  }
+  return true;
+}
+
+// Socket task: answers ADUs on one connection until the master hangs up
+static void serveTCP(HMS_MQXXX_Modbus *slave, int listening) {
+  int fd = accept(listening, NULL, NULL);
+  if(fd < 0) return;
+  uint8_t adu[HMS_MQXXX_MODBUS_TCP_MAX], response[HMS_MQXXX_MODBUS_TCP_MAX];
+  while(readExactly(fd, adu, HMS_MQXXX_MODBUS_MBAP_SIZE - 1)) {
+    size_t length = (size_t)((adu[4] << 8) | adu[5]);                       // Unit id + PDU
+    if(length < 1 || HMS_MQXXX_MODBUS_MBAP_SIZE - 1 + length > sizeof(adu)) break;
+    if(!readExactly(fd, adu + HMS_MQXXX_MODBUS_MBAP_SIZE - 1, length)) break;
+    size_t n = slave->processTCP(adu, HMS_MQXXX_MODBUS_MBAP_SIZE - 1 + length, response, sizeof(response));
+    if(n > 0 && !writeAll(fd, response, n)) break;
+  }
+  close(fd);
+}
+
+// Master side: one request PDU out, the response PDU back; the MBAP header is checked here
+static std::vector<uint8_t> transact(int fd, uint16_t transaction, uint8_t unit, const std::vector<uint8_t> &pdu) {
+  std::vector<uint8_t> adu = {
+    (uint8_t)(transaction >> 8), (uint8_t)transaction, 0, 0, (uint8_t)((pdu.size() + 1) >> 8), (uint8_t)(pdu.size() + 1), unit
+  };
+  adu.insert(adu.end(), pdu.begin(), pdu.end());
+  if(!writeAll(fd, adu.data(), adu.size())) return {};
+
+  uint8_t header[HMS_MQXXX_MODBUS_MBAP_SIZE];
+  if(!readExactly(fd, header, sizeof(header))) return {};
+  HMS_MQXXX_CHECK(header[0] == adu[0] && header[1] == adu[1]);             // Transaction id
+  HMS_MQXXX_CHECK(header[2] == 0 && header[3] == 0);                       // Protocol id
+  HMS_MQXXX_CHECK(header[6] == unit);
+  size_t length = (size_t)((header[4] << 8) | header[5]);
+  if(length < 2) return {};
+  std::vector<uint8_t> response(length - 1);
+  if(!readExactly(fd, response.data(), response.size())) return {};
+  return response;
+}
+
+static std::vector<uint8_t> readRequest(uint8_t function, uint16_t start, uint16_t count) {
+  return { function, (uint8_t)(start >> 8), (uint8_t)start, (uint8_t)(count >> 8), (uint8_t)count };
+}
+
+static uint32_t getLong(const std::vector<uint8_t> &response, size_t word) {
+  size_t at = 2 + 2 * word;
+  return ((uint32_t)response[at] << 24) | ((uint32_t)response[at + 1] << 16) | ((uint32_t)response[at + 2] << 8) | response[at + 3];
+}
+
+static uint32_t bits(float value) {
+  uint32_t out;
+  memcpy(&out, &value, sizeof(out));
+  return out;
+}
+
+static void testTCP(HMS_MQXXX_Modbus &slave, float ppm) {
+  int listening = socket(AF_INET, SOCK_STREAM, 0);
+  HMS_MQXXX_CHECK(listening >= 0);
+  if(listening < 0) return;
+  sockaddr_in address;
+  memset(&address, 0, sizeof(address));
+  address.sin_family      = AF_INET;
+  address.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+  socklen_t size          = sizeof(address);
+  bool      bound         = bind(listening, (sockaddr *)&address, sizeof(address)) == 0 &&
+                            getsockname(listening, (sockaddr *)&address, &size) == 0 && listen(listening, 1) == 0;
+  HMS_MQXXX_CHECK(bound);
+  if(!bound) {
+    close(listening);
+    return;
+  }
+  std::thread server(serveTCP, &slave, listening);
+
+  int  fd        = socket(AF_INET, SOCK_STREAM, 0);
+  bool connected = fd >= 0 && connect(fd, (sockaddr *)&address, sizeof(address)) == 0;
+  HMS_MQXXX_CHECK(connected);
+  if(connected) {
+    uint32_t exceptions = slave.getExceptionCount();
+
+    // FC04: status, type, gas count, then the active curve's ppm
+    std::vector<uint8_t> response = transact(fd, 0xBEEF, 0x11, readRequest(0x04, HMS_MQXXX_MODBUS_IR_STATUS, 8));
+    HMS_MQXXX_CHECK(response.size() == 2 + 16 && response[0] == 0x04 && response[1] == 16);
+    if(response.size() == 2 + 16) {
+      HMS_MQXXX_CHECK(((response[2] << 8) | response[3]) == HMS_MQXXX_OK);
+      HMS_MQXXX_CHECK(((response[6] << 8) | response[7]) == HMS_MQXXX_MQ2);
+      HMS_MQXXX_CHECK(getLong(response, HMS_MQXXX_MODBUS_IR_PPM) == bits(ppm));
+    }
+    response = transact(fd, 0x0001, 0x00, readRequest(0x04, HMS_MQXXX_MODBUS_IR_SEQUENCE, 1));
+    HMS_MQXXX_CHECK(response.size() == 4 && response[3] == 1);
+
+    // FC03: the clean-air ratio defaults to the sensor type's
+    response = transact(fd, 0x0002, 0xFF, readRequest(0x03, HMS_MQXXX_MODBUS_HR_CLEAN_AIR, HMS_MQXXX_MODBUS_HR_COUNT));
+    HMS_MQXXX_CHECK(response.size() == 2 + 2 * HMS_MQXXX_MODBUS_HR_COUNT && response[0] == 0x03);
+    if(response.size() == 2 + 2 * HMS_MQXXX_MODBUS_HR_COUNT) {
+      HMS_MQXXX_CHECK(getLong(response, HMS_MQXXX_MODBUS_HR_CLEAN_AIR) == bits(HMS_MQXXX_MQ2_CLEAN_AIR_RATIO));
+      HMS_MQXXX_CHECK(response[6] == 0 && response[7] == 0);               // No calibration pending
+    }
+
+    // Exceptions: past the end of the input block, an unsupported function
+    response = transact(fd, 0x7FFF, 0x11, readRequest(0x04, HMS_MQXXX_MODBUS_IR_COUNT - 1, 2));
+    HMS_MQXXX_CHECK(response.size() == 2 && response[0] == 0x84 && response[1] == HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS);
+    response = transact(fd, 0x8000, 0x11, readRequest(0x03, HMS_MQXXX_MODBUS_HR_COUNT, 1));
+    HMS_MQXXX_CHECK(response.size() == 2 && response[0] == 0x83 && response[1] == HMS_MQXXX_MODBUS_ILLEGAL_ADDRESS);
+    response = transact(fd, 0xFFFF, 0x11, { 0x2B, 0x0E, 0x01, 0x00 });
+    HMS_MQXXX_CHECK(response.size() == 2 && response[0] == 0xAB && response[1] == HMS_MQXXX_MODBUS_ILLEGAL_FUNCTION);
+    HMS_MQXXX_CHECK(slave.getExceptionCount() == exceptions + 3);
+  }
+  if(fd >= 0) close(fd);
+  server.join();
+  close(listening);
+
+  // A header that does not match its ADU gets no answer at all
+  uint8_t adu[]      = { 0x00, 0x01, 0x00, 0x01, 0x00, 0x06, 0x11, 0x04, 0x00, 0x00, 0x00, 0x01 };
+  uint8_t response[HMS_MQXXX_MODBUS_TCP_MAX];
+  HMS_MQXXX_CHECK(slave.processTCP(adu, sizeof(adu), response, sizeof(response)) == 0);  // Protocol id 1
+  adu[3] = 0;
+  adu[5] = 7;
+  HMS_MQXXX_CHECK(slave.processTCP(adu, sizeof(adu), response, sizeof(response)) == 0);  // Length one byte long
+}
+
+static size_t rtuFrame(uint8_t address, const std::vector<uint8_t> &pdu, uint8_t *frame) {
+  frame[0] = address;
+  memcpy(frame + 1, pdu.data(), pdu.size());
+  uint16_t crc = HMS_MQXXX_Modbus::crc16(frame, pdu.size() + 1);
+  frame[pdu.size() + 1] = (uint8_t)crc;
+  frame[pdu.size() + 2] = (uint8_t)(crc >> 8);
+  return pdu.size() + 3;
+}
+
+static void testRTU(HMS_MQXXX_Modbus &slave) {
+  // Reference vector: 01 03 00 00 00 01 carries CRC 84 0A
+  const uint8_t reference[] = { 0x01, 0x03, 0x00, 0x00, 0x00, 0x01 };
+  HMS_MQXXX_CHECK(HMS_MQXXX_Modbus::crc16(reference, sizeof(reference)) == 0x0A84);
+
+  uint8_t frame[HMS_MQXXX_MODBUS_RTU_MAX], response[HMS_MQXXX_MODBUS_RTU_MAX];
+  size_t  length = rtuFrame(slave.getAddress(), readRequest(0x04, HMS_MQXXX_MODBUS_IR_TYPE, 2), frame);
+  size_t  n      = slave.processRTU(frame, length, response, sizeof(response));
+  HMS_MQXXX_CHECK(n == 3 + 4 + 2 && response[0] == slave.getAddress() && response[1] == 0x04 && response[2] == 4);
+  HMS_MQXXX_CHECK(n >= 4 && HMS_MQXXX_Modbus::crc16(response, n) == 0);    // CRC over the frame and its CRC is zero
+  HMS_MQXXX_CHECK(n == 9 && response[4] == HMS_MQXXX_MQ2);
+
+  // Exceptions go out with their own CRC
+  length = rtuFrame(slave.getAddress(), { 0x07 }, frame);
+  n      = slave.processRTU(frame, length, response, sizeof(response));
+  HMS_MQXXX_CHECK(n == 5 && response[1] == 0x87 && response[2] == HMS_MQXXX_MODBUS_ILLEGAL_FUNCTION);
+  HMS_MQXXX_CHECK(n == 5 && HMS_MQXXX_Modbus::crc16(response, n) == 0);
+
+  // Silence: another slave's frame, a damaged CRC, a broadcast (executed, not answered)
+  uint32_t requests = slave.getRequestCount();
+  length = rtuFrame((uint8_t)(slave.getAddress() + 1), readRequest(0x04, 0, 1), frame);
+  HMS_MQXXX_CHECK(slave.processRTU(frame, length, response, sizeof(response)) == 0);
+  length = rtuFrame(slave.getAddress(), readRequest(0x04, 0, 1), frame);
+  frame[length - 1] ^= 0x01;
+  HMS_MQXXX_CHECK(slave.processRTU(frame, length, response, sizeof(response)) == 0);
+  HMS_MQXXX_CHECK(slave.getRequestCount() == requests);
+
+  length = rtuFrame(0, { 0x05, 0x00, HMS_MQXXX_MODBUS_COIL_CALIBRATE, 0xFF, 0x00 }, frame);
+  HMS_MQXXX_CHECK(slave.processRTU(frame, length, response, sizeof(response)) == 0);
+  HMS_MQXXX_CHECK(slave.getRequestCount() == requests + 1);
+  length = rtuFrame(slave.getAddress(), readRequest(0x01, HMS_MQXXX_MODBUS_COIL_CALIBRATE, 1), frame);
+  n      = slave.processRTU(frame, length, response, sizeof(response));
+  HMS_MQXXX_CHECK(n == 6 && response[3] == 0x01);                          // Calibration now pending
+}
+
+int main() {
+  HMS_MQXXX_HostHooks hooks = { readADC, NULL, NULL, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+
+  HMS_MQXXX        sensor(0, HMS_MQXXX_MQ2);
+  HMS_MQXXX_Modbus slave(17);
+  HMS_MQXXX_CHECK(sensor.init() == HMS_MQXXX_OK);
+  sensor.setR0(10.0f);
+  slave.attach(&sensor);
+  float ppm = sensor.readSensor();                                          // Publishes into the register image
+
+  testTCP(slave, ppm);
+  testRTU(slave);
+
+  slave.detach();
+  HMS_MQXXX_SetHostHooks(NULL);
+  return HMS_MQXXX_TEST_RESULT();
+}
@@ -0,0 +1,104 @@
+/*
+  HMS_MQXXX_Service on the thread-backed FreeRTOS shim (tests/freertos): consumer notifications,
+  the reading queue, trigger()/stop(), and exactly one acquisition per sensor per cycle (the
+  warm-up tracker must see one sample per period, not two).
+*/
+#include "HMS_MQXXX_Service.h"
+#include "HMS_MQXXX_Test.h"
+
+#include <atomic>
+
+static std::atomic<uint32_t> conversions[2];
+
+static uint16_t readADC(uint8_t pin, void *) {
+  conversions[pin & 1]++;
+  return (uint16_t)(300 + 200 * pin);
+}
+
+static void delayTicks(uint32_t ms, void *) {
+  vTaskDelay(pdMS_TO_TICKS(ms));
+}
+
+static bool waitFor(const HMS_MQXXX_Service &service, uint32_t cycles, uint32_t timeoutMs) {
+  for(uint32_t waited = 0; service.getCycleCount() < cycles; waited++) {
+    if(waited >= timeoutMs) return false;
+    vTaskDelay(1);
+  }
+  return true;
+}
+
+static void waitStopped(const HMS_MQXXX_Service &service) {
+  for(uint32_t waited = 0; service.isRunning() && waited < 2000; waited++) vTaskDelay(1);
+}
+
+int main() {
+  HMS_MQXXX_HostHooks hooks = { readADC, delayTicks, NULL, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+
+  HMS_MQXXX sensors[2] = { HMS_MQXXX(0, HMS_MQXXX_MQ2), HMS_MQXXX(1, HMS_MQXXX_MQ135) };
+  HMS_MQXXX_Service service;
+  for(HMS_MQXXX &sensor : sensors) {
+    HMS_MQXXX_CHECK(sensor.init() == HMS_MQXXX_OK);
+    sensor.setCacheMaxAge(0);                                               // Every readSensor() acquires, whatever the build default
+    HMS_MQXXX_CHECK(service.addSensor(&sensor) == HMS_MQXXX_OK);
+  }
+  HMS_MQXXX_CHECK(service.addConsumer(xTaskGetCurrentTaskHandle()) == HMS_MQXXX_OK);
+  conversions[0] = 0;
+  conversions[1] = 0;
+
+  // Periodic cycles: every sensor's bit is set, every reading is queued
+  HMS_MQXXX_CHECK(service.start(20) == HMS_MQXXX_OK);
+  HMS_MQXXX_CHECK(service.addSensor(&sensors[0]) == HMS_MQXXX_ERROR);       // Not while running
+  uint32_t bits = 0;
+  HMS_MQXXX_CHECK(xTaskNotifyWait(0, 0xFFFFFFFFUL, &bits, 2000) == pdTRUE);
+  HMS_MQXXX_CHECK(bits == 0x3);
+  HMS_MQXXX_CHECK(waitFor(service, 5, 2000));
+  service.stop();
+  waitStopped(service);
+  HMS_MQXXX_CHECK(!service.isRunning());
+
+  uint32_t cycles = service.getCycleCount();
+  for(uint8_t i = 0; i < 2; i++) {
+    uint32_t acquisitions = conversions[i] / HMS_MQXXX_READ_RETRIES;
+    HMS_MQXXX_CHECK(conversions[i] % HMS_MQXXX_READ_RETRIES == 0);
+    HMS_MQXXX_CHECK(acquisitions <= cycles && acquisitions + 1 >= cycles);   // stop() may cut the last cycle short
+    #if defined(HMS_MQXXX_WARMUP_ENABLED) && (HMS_MQXXX_WARMUP_ENABLED == 1)
+    HMS_MQXXX_CHECK(!sensors[i].isReady());                                 // Still warming up, so update() would have sampled
+    #endif
+
+    HMS_MQXXX_Reading reading;
+    HMS_MQXXX_CHECK(service.getReading(i, &reading));
+    HMS_MQXXX_CHECK(reading.voltage > 0);
+  }
+
+  HMS_MQXXX_ServiceReading item;
+  uint32_t                 queued = 0;
+  while(xQueueReceive(service.getQueue(), &item, 0) == pdPASS) {
+    HMS_MQXXX_CHECK(item.index < 2);
+    queued++;
+  }
+  HMS_MQXXX_CHECK(queued > 0 && queued <= HMS_MQXXX_SERVICE_QUEUE_DEPTH);
+  HMS_MQXXX_CHECK(queued == HMS_MQXXX_SERVICE_QUEUE_DEPTH || service.getDroppedCount() == 0);
+
+  // A long period only runs the first cycle; trigger() runs the next one now
+  uint32_t before = service.getCycleCount();
+  HMS_MQXXX_CHECK(service.start(60000) == HMS_MQXXX_OK);
+  HMS_MQXXX_CHECK(waitFor(service, before + 1, 2000));
+  service.trigger();
+  HMS_MQXXX_CHECK(waitFor(service, before + 2, 2000));
+  service.stop();
+  waitStopped(service);
+  HMS_MQXXX_CHECK(service.getCycleCount() <= before + 3);
+
+  // Destroying a running service waits for the task to leave its cycle, not for the period
+  {
+    HMS_MQXXX_Service other;
+    HMS_MQXXX_CHECK(other.addSensor(&sensors[0]) == HMS_MQXXX_OK);
+    HMS_MQXXX_CHECK(other.start(60000) == HMS_MQXXX_OK);
+    HMS_MQXXX_CHECK(waitFor(other, 1, 2000));
+    before = xTaskGetTickCount();
+  }
+  HMS_MQXXX_CHECK(xTaskGetTickCount() - before < 2000);
+
+  return HMS_MQXXX_TEST_RESULT();
+}
@@ -0,0 +1,253 @@
+/*
+  HMS_MQXXX_Telemetry into a loopback link and back through HMS_MQXXX_TelemetryReader. The link
+  is a byte buffer of length-prefixed frames, as a UART or a radio driver would carry them.
+  Checks that records come back bit for bit (zigzag varints across sign changes, wrapping
+  timestamps, extreme and non-finite floats), that a damaged frame is rejected without taking
+  the next one down, and that a lost frame shows as a sequence gap.
+*/
+#include "HMS_MQXXX_Telemetry.h"
+#include "HMS_MQXXX_Test.h"
+
+#include <vector>
+
+#include <string.h>
+
+typedef struct {
+  std::vector<uint8_t>  bytes;                                              // u16 length + frame, back to back
+  bool                  fail                = false;                        // Sink refuses frames while set
+} Loopback;
+
+static HMS_MQXXX_StatusTypeDef sendFrame(const uint8_t *frame, size_t length, void *context) {
+  Loopback *link = static_cast<Loopback *>(context);
+  if(link->fail) return HMS_MQXXX_ERROR;
+  link->bytes.push_back((uint8_t)length);
+  link->bytes.push_back((uint8_t)(length >> 8));
+  link->bytes.insert(link->bytes.end(), frame, frame + length);
+  return HMS_MQXXX_OK;
+}
+
+// Splits the link back into frames
+static std::vector<std::vector<uint8_t>> receiveFrames(const Loopback &link) {
+  std::vector<std::vector<uint8_t>> frames;
+  for(size_t pos = 0; pos + 2 <= link.bytes.size();) {
+    size_t length = link.bytes[pos] | (link.bytes[pos + 1] << 8);
+    pos += 2;
+    if(pos + length > link.bytes.size()) break;
+    frames.emplace_back(link.bytes.begin() + pos, link.bytes.begin() + pos + length);
+    pos += length;
+  }
+  return frames;
+}
+
+static uint32_t bits(float value) {
+  uint32_t out;
+  memcpy(&out, &value, sizeof(out));
+  return out;
+}
+
+static bool sameRecord(const HMS_MQXXX_TelemetryRecord &a, const HMS_MQXXX_TelemetryRecord &b) {
+  return a.timestamp == b.timestamp && bits(a.ppm) == bits(b.ppm) && bits(a.ratio) == bits(b.ratio) &&
+         a.source == b.source && a.status == b.status && a.flags == b.flags;
+}
+
+static HMS_MQXXX_TelemetryRecord makeRecord(uint32_t timestamp, float ppm, float ratio, uint8_t source) {
+  HMS_MQXXX_TelemetryRecord record;
+  record.timestamp = timestamp;
+  record.ppm       = ppm;
+  record.ratio     = ratio;
+  record.source    = source;
+  record.status    = HMS_MQXXX_OK;
+  record.flags     = (uint8_t)(source & 0x0F);
+  return record;
+}
+
+static void testRoundTrip() {
+  Loopback            link;
+  HMS_MQXXX_Telemetry telemetry(sendFrame, &link);
+  telemetry.setMaxAge(0xFFFFFFFFUL);
+
+  // Deltas of every sign and size: zigzag varints from 1 to 5 bytes, timestamps across the wrap
+  std::vector<HMS_MQXXX_TelemetryRecord> sent;
+  sent.push_back(makeRecord(0xFFFFFF00UL, 412.5f,    0.93f,   1));
+  sent.push_back(makeRecord(0xFFFFFFF0UL, 412.25f,   0.931f,  1));
+  sent.push_back(makeRecord(0x00000010UL, 0.001f,    3.7f,    2));
+  sent.push_back(makeRecord(0x00000008UL, 413.0f,    -0.5f,   1));      // Timestamp steps back, ratio changes sign
+  sent.push_back(makeRecord(0x00010000UL, FLT_MAX,   FLT_MIN, 2));
+  sent.push_back(makeRecord(0x00010001UL, 0.0f,      -0.0f,   2));
+  sent.push_back(makeRecord(0x80010001UL, INFINITY,  NAN,     1));
+  sent.push_back(makeRecord(0x80010002UL, 1e-30f,    1e30f,   127));
+  for(const HMS_MQXXX_TelemetryRecord &record : sent) HMS_MQXXX_CHECK(telemetry.add(record) == HMS_MQXXX_OK);
+  HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_OK);
+  HMS_MQXXX_CHECK(telemetry.getRecordsSent() == sent.size());
+
+  size_t   received = 0;
+  uint16_t expected = 0;
+  for(const std::vector<uint8_t> &frame : receiveFrames(link)) {
+    HMS_MQXXX_CHECK(frame.size() <= HMS_MQXXX_TELEMETRY_FRAME_SIZE);
+    HMS_MQXXX_TelemetryReader reader(frame.data(), frame.size());
+    HMS_MQXXX_CHECK(reader.isValid());
+    HMS_MQXXX_CHECK(reader.getSequence() == expected++);
+    HMS_MQXXX_TelemetryRecord record;
+    uint8_t                   count = 0;
+    while(reader.next(&record)) {
+      HMS_MQXXX_CHECK(received < sent.size() && sameRecord(record, sent[received]));
+      received++;
+      count++;
+    }
+    HMS_MQXXX_CHECK(reader.isValid() && count == reader.getCount());
+  }
+  HMS_MQXXX_CHECK(received == sent.size());
+  HMS_MQXXX_CHECK(expected == telemetry.getFramesSent());
+}
+
+// Small steady deltas stay small on the wire, and every frame fits the configured size
+static void testDeltaFrames() {
+  Loopback            link;
+  HMS_MQXXX_Telemetry telemetry(sendFrame, &link);
+  telemetry.setMaxAge(0xFFFFFFFFUL);
+
+  std::vector<HMS_MQXXX_TelemetryRecord> sent;
+  for(uint32_t i = 0; i < 200; i++) {
+    sent.push_back(makeRecord(10000 * i, 400.0f + 0.01f * (float)(i % 7), 0.9f - 0.001f * (float)(i % 5), (uint8_t)(i % 2)));
+    HMS_MQXXX_CHECK(telemetry.add(sent.back()) == HMS_MQXXX_OK);
+  }
+  HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_OK);
+
+  size_t received = 0;
+  for(const std::vector<uint8_t> &frame : receiveFrames(link)) {
+    HMS_MQXXX_CHECK(frame.size() <= HMS_MQXXX_TELEMETRY_FRAME_SIZE);
+    HMS_MQXXX_TelemetryReader reader(frame.data(), frame.size());
+    HMS_MQXXX_TelemetryRecord record;
+    while(reader.next(&record)) {
+      HMS_MQXXX_CHECK(received < sent.size() && sameRecord(record, sent[received]));
+      received++;
+    }
+  }
+  HMS_MQXXX_CHECK(received == sent.size());
+  HMS_MQXXX_CHECK(telemetry.getFramesSent() <= sent.size() / 2);           // Several readings a wakeup
+}
+
+// A damaged frame is rejected on its own; the reader picks up again at the next frame
+static void testCorruptedFrame() {
+  Loopback            link;
+  HMS_MQXXX_Telemetry telemetry(sendFrame, &link);
+  telemetry.setMaxAge(0xFFFFFFFFUL);
+
+  std::vector<HMS_MQXXX_TelemetryRecord> sent;
+  for(uint32_t frame = 0; frame < 3; frame++) {
+    for(uint32_t i = 0; i < 3; i++) {
+      sent.push_back(makeRecord(1000 * (frame * 3 + i), 50.0f + (float)i, 1.0f + (float)frame, 3));
+      HMS_MQXXX_CHECK(telemetry.add(sent.back()) == HMS_MQXXX_OK);
+    }
+    HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_OK);
+  }
+  std::vector<std::vector<uint8_t>> frames = receiveFrames(link);
+  HMS_MQXXX_CHECK(frames.size() == 3);
+  if(frames.size() != 3) return;
+
+  // Frame 0: a varint that never terminates; frame 1: truncated mid-record; frame 2 intact
+  std::vector<uint8_t> unterminated = frames[0];
+  for(size_t i = HMS_MQXXX_TELEMETRY_HEADER_SIZE + 2; i < unterminated.size(); i++) unterminated[i] |= 0x80;
+  std::vector<uint8_t> truncated(frames[1].begin(), frames[1].end() - 3);
+  std::vector<uint8_t> badVersion = frames[2];
+  badVersion[0] = 0x7F;
+
+  HMS_MQXXX_TelemetryRecord record;
+  HMS_MQXXX_TelemetryReader first(unterminated.data(), unterminated.size());
+  uint8_t                   decoded = 0;
+  while(first.next(&record)) decoded++;
+  HMS_MQXXX_CHECK(!first.isValid() && decoded < 3);
+
+  HMS_MQXXX_TelemetryReader second(truncated.data(), truncated.size());
+  decoded = 0;
+  while(second.next(&record)) decoded++;
+  HMS_MQXXX_CHECK(!second.isValid() && decoded < 3);
+
+  HMS_MQXXX_TelemetryReader wrongVersion(badVersion.data(), badVersion.size());
+  HMS_MQXXX_CHECK(!wrongVersion.isValid() && !wrongVersion.next(&record));
+
+  HMS_MQXXX_TelemetryReader third(frames[2].data(), frames[2].size());
+  HMS_MQXXX_CHECK(third.isValid() && third.getSequence() == 2);
+  decoded = 0;
+  while(third.next(&record)) {
+    HMS_MQXXX_CHECK(sameRecord(record, sent[6 + decoded]));
+    decoded++;
+  }
+  HMS_MQXXX_CHECK(third.isValid() && decoded == 3);
+}
+
+// A frame lost on the link shows up as a jump in the sequence; a failing sink keeps the batch
+static void testSequenceGaps() {
+  Loopback            link;
+  HMS_MQXXX_Telemetry telemetry(sendFrame, &link);
+  telemetry.setMaxAge(0xFFFFFFFFUL);
+
+  for(uint32_t i = 0; i < 5; i++) {
+    HMS_MQXXX_CHECK(telemetry.add(makeRecord(i, (float)i, 1.0f, 0)) == HMS_MQXXX_OK);
+    HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_OK);
+  }
+  std::vector<std::vector<uint8_t>> frames = receiveFrames(link);
+  HMS_MQXXX_CHECK(frames.size() == 5);
+  frames.erase(frames.begin() + 2);                                         // Lost in the air
+
+  uint32_t gaps     = 0;
+  uint16_t previous = 0;
+  for(size_t i = 0; i < frames.size(); i++) {
+    HMS_MQXXX_TelemetryReader reader(frames[i].data(), frames[i].size());
+    HMS_MQXXX_CHECK(reader.isValid());
+    if(i > 0 && (uint16_t)(reader.getSequence() - previous) != 1) gaps += (uint16_t)(reader.getSequence() - previous) - 1;
+    previous = reader.getSequence();
+  }
+  HMS_MQXXX_CHECK(gaps == 1);
+
+  // Refused by the sink: kept and resent with the same sequence number, no gap
+  link.fail = true;
+  HMS_MQXXX_CHECK(telemetry.add(makeRecord(5, 5.0f, 1.0f, 0)) == HMS_MQXXX_OK);
+  HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_ERROR);
+  HMS_MQXXX_CHECK(telemetry.getPendingCount() == 1);
+  link.fail = false;
+  HMS_MQXXX_CHECK(telemetry.flush() == HMS_MQXXX_OK);
+  frames = receiveFrames(link);
+  HMS_MQXXX_TelemetryReader resent(frames.back().data(), frames.back().size());
+  HMS_MQXXX_CHECK(resent.getSequence() == 5);
+  HMS_MQXXX_CHECK(telemetry.getDroppedCount() == 0);
+}
+
+// Attached sensor: a reading over the alarm threshold goes out at once, marked urgent
+static uint16_t readADC(uint8_t, void *) {
+  return 900;
+}
+
+static void testUrgentReading() {
+  HMS_MQXXX_HostHooks hooks = { readADC, NULL, NULL, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+
+  Loopback            link;
+  HMS_MQXXX_Telemetry telemetry(sendFrame, &link);
+  HMS_MQXXX           sensor(0, HMS_MQXXX_MQ2);
+  HMS_MQXXX_CHECK(sensor.init() == HMS_MQXXX_OK);
+  sensor.setR0(10.0f);
+  HMS_MQXXX_CHECK(telemetry.attach(&sensor, 9) == HMS_MQXXX_OK);
+  telemetry.setAlarmThreshold(9, 0.0f);
+
+  float ppm = sensor.readSensor();
+  HMS_MQXXX_CHECK(telemetry.getFramesSent() == 1 && telemetry.getPendingCount() == 0);
+  std::vector<std::vector<uint8_t>> frames = receiveFrames(link);
+  HMS_MQXXX_CHECK(frames.size() == 1);
+  if(frames.size() != 1) return;
+  HMS_MQXXX_TelemetryReader reader(frames[0].data(), frames[0].size());
+  HMS_MQXXX_TelemetryRecord record;
+  HMS_MQXXX_CHECK(reader.isUrgent());
+  HMS_MQXXX_CHECK(reader.next(&record) && record.source == 9 && bits(record.ppm) == bits(ppm));
+  telemetry.detach(&sensor);
+  HMS_MQXXX_SetHostHooks(NULL);
+}
+
+int main() {
+  testRoundTrip();
+  testDeltaFrames();
+  testCorruptedFrame();
+  testSequenceGaps();
+  testUrgentReading();
+  return HMS_MQXXX_TEST_RESULT();
+}
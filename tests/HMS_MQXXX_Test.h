@@ -0,0 +1,22 @@
+/*
+  Checks shared by the host tests. A failing HMS_MQXXX_CHECK prints the expression and carries
+  on; main() ends with HMS_MQXXX_TEST_RESULT() so ctest sees a non-zero exit on any failure.
+*/
+#ifndef HMS_MQXXX_TEST_H
+#define HMS_MQXXX_TEST_H
+
+#include <stdio.h>
+
+static int hmsTestFailures = 0;
+
+#define HMS_MQXXX_CHECK(condition)                                                        \
+  do {                                                                                    \
+    if(!(condition)) {                                                                    \
+      fprintf(stderr, "%s:%d: check failed: %s\n", __FILE__, __LINE__, #condition);       \
+      hmsTestFailures++;                                                                  \
+    }                                                                                     \
+  } while(0)
+
+#define HMS_MQXXX_TEST_RESULT()   ((hmsTestFailures == 0) ? (printf("ok\n"), 0) : (printf("%d failed\n", hmsTestFailures), 1))
+
+#endif // HMS_MQXXX_TEST_H
@@ -0,0 +1,36 @@
+/*
+  Thread-backed stand-in for the FreeRTOS kernel API the driver uses (tasks, notifications,
+  queues, binary semaphores, one-shot timers), so the service and the timer executor run in a host test without
+  the FreeRTOS sources. Tasks are std::threads, one tick is one millisecond of steady_clock,
+  and nothing is preemptive: priorities and core affinity are accepted and ignored.
+*/
+#ifndef HMS_MQXXX_FREERTOS_SHIM_H
+#define HMS_MQXXX_FREERTOS_SHIM_H
+
+#include <assert.h>
+#include <stddef.h>
+#include <stdint.h>
+
+typedef uint32_t      TickType_t;
+typedef long          BaseType_t;
+typedef unsigned long UBaseType_t;
+typedef uintptr_t     StackType_t;
+
+#define pdFALSE                             0
+#define pdTRUE                              1
+#define pdFAIL                              0
+#define pdPASS                              1
+#define pdMS_TO_TICKS(ms)                   ((TickType_t)(ms))
+#define portTICK_PERIOD_MS                  1
+#define portMAX_DELAY                       ((TickType_t)0xFFFFFFFFUL)
+
+#define configSUPPORT_STATIC_ALLOCATION     1
+#define configSUPPORT_DYNAMIC_ALLOCATION    1
+#define configASSERT(x)                     assert(x)
+
+void vShimEnterCritical(void);
+void vShimExitCritical(void);
+#define taskENTER_CRITICAL()                vShimEnterCritical()
+#define taskEXIT_CRITICAL()                 vShimExitCritical()
+
+#endif // HMS_MQXXX_FREERTOS_SHIM_H
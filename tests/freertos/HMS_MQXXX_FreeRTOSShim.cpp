@@ -0,0 +1,270 @@
+#include "FreeRTOS.h"
+#include "task.h"
+#include "queue.h"
+#include "semphr.h"
+#include "timers.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include <string.h>
+
+struct ShimTask {
+  std::mutex                m;
+  std::condition_variable   cv;
+  uint32_t                  value               = 0;
+  bool                      pending             = false;
+};
+
+struct ShimQueue {
+  std::mutex                                m;
+  std::deque<std::vector<uint8_t>>          items;
+  size_t                                    length;
+  size_t                                    itemSize;
+};
+
+struct ShimSemaphore {
+  std::mutex                                m;
+  std::condition_variable                   cv;
+  bool                                      given               = false;
+};
+
+struct ShimTimer {
+  void                                      *id;
+  TimerCallbackFunction_t                   callback;
+  bool                                      armed               = false;
+  bool                                      deleted             = false;
+  std::chrono::steady_clock::time_point     expiry;
+};
+
+// Never destroyed: detached task and timer threads may still use them during process exit
+struct ShimTimers {
+  std::mutex                                m;
+  std::condition_variable                   cv;
+  std::vector<ShimTimer *>                  list;
+  bool                                      started             = false;
+};
+
+static ShimTimers                           &timers     = *new ShimTimers;
+static std::recursive_mutex                 &critical   = *new std::recursive_mutex;
+static ShimTask                             &mainTask   = *new ShimTask;    // Any thread not created through the shim
+static thread_local ShimTask                *currentTask = NULL;
+static const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now();
+
+void vShimEnterCritical(void) { critical.lock();   }
+void vShimExitCritical(void)  { critical.unlock(); }
+
+/* Tasks and notifications */
+
+BaseType_t xTaskCreate(TaskFunction_t entry, const char *, uint32_t, void *arg, UBaseType_t, TaskHandle_t *handle) {
+  ShimTask *task = new ShimTask;
+  if(handle != NULL) *handle = task;
+  std::thread([entry, arg, task]() {
+    currentTask = task;
+    entry(arg);
+  }).detach();
+  return pdPASS;
+}
+
+TaskHandle_t xTaskCreateStatic(TaskFunction_t entry, const char *name, uint32_t stackDepth, void *arg, UBaseType_t priority,
+                               StackType_t *, StaticTask_t *) {
+  TaskHandle_t handle = NULL;
+  xTaskCreate(entry, name, stackDepth, arg, priority, &handle);
+  return handle;
+}
+
+void vTaskDelete(TaskHandle_t)                  { }
+void vTaskPrioritySet(TaskHandle_t, UBaseType_t) { }
+
+void vTaskDelay(TickType_t ticks) {
+  std::this_thread::sleep_for(std::chrono::milliseconds(ticks));
+}
+
+TickType_t xTaskGetTickCount(void) {
+  return (TickType_t)std::chrono::duration_cast<std::chrono::milliseconds>(std::chrono::steady_clock::now() - epoch).count();
+}
+
+TaskHandle_t xTaskGetCurrentTaskHandle(void) {
+  return (currentTask != NULL) ? currentTask : &mainTask;
+}
+
+BaseType_t xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action) {
+  std::lock_guard<std::mutex> lock(task->m);
+  switch(action) {
+    case eSetBits:                task->value |= value; break;
+    case eIncrement:              task->value++;        break;
+    case eSetValueWithOverwrite:  task->value  = value; break;
+    default:                                            break;
+  }
+  task->pending = true;
+  task->cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTaskNotifyGive(TaskHandle_t task) {
+  return xTaskNotify(task, 0, eIncrement);
+}
+
+static bool waitNotified(ShimTask *task, std::unique_lock<std::mutex> &lock, TickType_t timeout) {
+  if(timeout == portMAX_DELAY) {
+    task->cv.wait(lock, [task]() { return task->pending; });
+    return true;
+  }
+  return task->cv.wait_for(lock, std::chrono::milliseconds(timeout), [task]() { return task->pending; });
+}
+
+BaseType_t xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, TickType_t timeout) {
+  ShimTask                     *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->m);
+  if(!task->pending) task->value &= ~clearOnEntry;
+  if(!waitNotified(task, lock, timeout)) return pdFALSE;
+  task->pending = false;
+  if(value != NULL) *value = task->value;
+  task->value &= ~clearOnExit;
+  return pdTRUE;
+}
+
+uint32_t ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout) {
+  ShimTask                     *task = xTaskGetCurrentTaskHandle();
+  std::unique_lock<std::mutex> lock(task->m);
+  if(task->value == 0) {
+    task->pending = false;
+    if(!waitNotified(task, lock, timeout)) return 0;
+  }
+  uint32_t value = task->value;
+  task->value    = clearOnExit ? 0 : value - 1;
+  task->pending  = task->value != 0;
+  return value;
+}
+
+/* Queues */
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize) {
+  ShimQueue *queue = new ShimQueue;
+  queue->length    = length;
+  queue->itemSize  = itemSize;
+  return queue;
+}
+
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *, StaticQueue_t *) {
+  return xQueueCreate(length, itemSize);
+}
+
+void vQueueDelete(QueueHandle_t queue) {
+  delete queue;
+}
+
+BaseType_t xQueueSend(QueueHandle_t queue, const void *item, TickType_t) {
+  std::lock_guard<std::mutex> lock(queue->m);
+  if(queue->items.size() >= queue->length) return pdFALSE;
+  const uint8_t *bytes = static_cast<const uint8_t *>(item);
+  queue->items.emplace_back(bytes, bytes + queue->itemSize);
+  return pdPASS;
+}
+
+BaseType_t xQueueReceive(QueueHandle_t queue, void *item, TickType_t) {
+  std::lock_guard<std::mutex> lock(queue->m);
+  if(queue->items.empty()) return pdFALSE;
+  memcpy(item, queue->items.front().data(), queue->itemSize);
+  queue->items.pop_front();
+  return pdPASS;
+}
+
+UBaseType_t uxQueueMessagesWaiting(QueueHandle_t queue) {
+  std::lock_guard<std::mutex> lock(queue->m);
+  return (UBaseType_t)queue->items.size();
+}
+
+/* Binary semaphores */
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void) {
+  return new ShimSemaphore;
+}
+
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *) {
+  return xSemaphoreCreateBinary();
+}
+
+void vSemaphoreDelete(SemaphoreHandle_t semaphore) {
+  delete semaphore;
+}
+
+BaseType_t xSemaphoreGive(SemaphoreHandle_t semaphore) {
+  std::lock_guard<std::mutex> lock(semaphore->m);
+  if(semaphore->given) return pdFALSE;
+  semaphore->given = true;
+  semaphore->cv.notify_one();
+  return pdPASS;
+}
+
+BaseType_t xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout) {
+  std::unique_lock<std::mutex> lock(semaphore->m);
+  auto given = [semaphore]() { return semaphore->given; };
+  if(timeout == portMAX_DELAY) semaphore->cv.wait(lock, given);
+  else if(!semaphore->cv.wait_for(lock, std::chrono::milliseconds(timeout), given)) return pdFALSE;
+  semaphore->given = false;
+  return pdTRUE;
+}
+
+/* One-shot timers, served by a single daemon thread like the timer service task */
+
+static void timerDaemon() {
+  std::unique_lock<std::mutex> lock(timers.m);
+  for(;;) {
+    ShimTimer *next = NULL;
+    for(ShimTimer *timer : timers.list) {
+      if(timer->armed && !timer->deleted && (next == NULL || timer->expiry < next->expiry)) next = timer;
+    }
+    if(next == NULL) {
+      timers.cv.wait(lock);
+      continue;
+    }
+    timers.cv.wait_until(lock, next->expiry);
+    if(!next->armed || next->deleted || std::chrono::steady_clock::now() < next->expiry) continue;
+    next->armed = false;
+    lock.unlock();
+    next->callback(next);
+    lock.lock();
+  }
+}
+
+TimerHandle_t xTimerCreate(const char *, TickType_t, UBaseType_t, void *id, TimerCallbackFunction_t callback) {
+  std::lock_guard<std::mutex> lock(timers.m);
+  ShimTimer *timer = new ShimTimer;
+  timer->id        = id;
+  timer->callback  = callback;
+  timers.list.push_back(timer);
+  if(!timers.started) {
+    timers.started = true;
+    std::thread(timerDaemon).detach();
+  }
+  return timer;
+}
+
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                                 TimerCallbackFunction_t callback, StaticTimer_t *) {
+  return xTimerCreate(name, period, autoReload, id, callback);
+}
+
+BaseType_t xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t) {
+  std::lock_guard<std::mutex> lock(timers.m);
+  timer->armed  = true;
+  timer->expiry = std::chrono::steady_clock::now() + std::chrono::milliseconds(period);
+  timers.cv.notify_all();
+  return pdPASS;
+}
+
+BaseType_t xTimerDelete(TimerHandle_t timer, TickType_t) {
+  std::lock_guard<std::mutex> lock(timers.m);
+  timer->deleted = true;                                                    // Kept: the daemon may be about to call it
+  timer->armed   = false;
+  return pdPASS;
+}
+
+void *pvTimerGetTimerID(TimerHandle_t timer) {
+  return timer->id;
+}
@@ -0,0 +1,16 @@
+#ifndef HMS_MQXXX_FREERTOS_SHIM_QUEUE_H
+#define HMS_MQXXX_FREERTOS_SHIM_QUEUE_H
+
+#include "FreeRTOS.h"
+
+typedef struct ShimQueue *QueueHandle_t;
+typedef struct { void *reserved[4]; } StaticQueue_t;
+
+QueueHandle_t xQueueCreate(UBaseType_t length, UBaseType_t itemSize);
+QueueHandle_t xQueueCreateStatic(UBaseType_t length, UBaseType_t itemSize, uint8_t *storage, StaticQueue_t *control);
+void          vQueueDelete(QueueHandle_t queue);
+BaseType_t    xQueueSend(QueueHandle_t queue, const void *item, TickType_t timeout);   // Timeouts are not waited for
+BaseType_t    xQueueReceive(QueueHandle_t queue, void *item, TickType_t timeout);
+UBaseType_t   uxQueueMessagesWaiting(QueueHandle_t queue);
+
+#endif // HMS_MQXXX_FREERTOS_SHIM_QUEUE_H
@@ -0,0 +1,15 @@
+#ifndef HMS_MQXXX_FREERTOS_SHIM_SEMPHR_H
+#define HMS_MQXXX_FREERTOS_SHIM_SEMPHR_H
+
+#include "FreeRTOS.h"
+
+typedef struct ShimSemaphore *SemaphoreHandle_t;
+typedef struct { void *reserved[4]; } StaticSemaphore_t;
+
+SemaphoreHandle_t xSemaphoreCreateBinary(void);                             // Binary only, created empty
+SemaphoreHandle_t xSemaphoreCreateBinaryStatic(StaticSemaphore_t *control);
+void              vSemaphoreDelete(SemaphoreHandle_t semaphore);
+BaseType_t        xSemaphoreGive(SemaphoreHandle_t semaphore);
+BaseType_t        xSemaphoreTake(SemaphoreHandle_t semaphore, TickType_t timeout);
+
+#endif // HMS_MQXXX_FREERTOS_SHIM_SEMPHR_H
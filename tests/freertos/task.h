@@ -0,0 +1,32 @@
+#ifndef HMS_MQXXX_FREERTOS_SHIM_TASK_H
+#define HMS_MQXXX_FREERTOS_SHIM_TASK_H
+
+#include "FreeRTOS.h"
+
+typedef struct ShimTask *TaskHandle_t;
+typedef void (*TaskFunction_t)(void *arg);
+typedef struct { void *reserved[4]; } StaticTask_t;
+
+typedef enum {
+  eNoAction,
+  eSetBits,
+  eIncrement,
+  eSetValueWithOverwrite
+} eNotifyAction;
+
+BaseType_t   xTaskCreate(TaskFunction_t entry, const char *name, uint32_t stackDepth, void *arg, UBaseType_t priority,
+                         TaskHandle_t *handle);
+TaskHandle_t xTaskCreateStatic(TaskFunction_t entry, const char *name, uint32_t stackDepth, void *arg, UBaseType_t priority,
+                               StackType_t *stack, StaticTask_t *control);
+void         vTaskDelete(TaskHandle_t task);                                // Only NULL (self) ends a thread, as a return
+void         vTaskDelay(TickType_t ticks);
+void         vTaskPrioritySet(TaskHandle_t task, UBaseType_t priority);
+TickType_t   xTaskGetTickCount(void);
+TaskHandle_t xTaskGetCurrentTaskHandle(void);
+
+BaseType_t   xTaskNotify(TaskHandle_t task, uint32_t value, eNotifyAction action);
+BaseType_t   xTaskNotifyGive(TaskHandle_t task);
+BaseType_t   xTaskNotifyWait(uint32_t clearOnEntry, uint32_t clearOnExit, uint32_t *value, TickType_t timeout);
+uint32_t     ulTaskNotifyTake(BaseType_t clearOnExit, TickType_t timeout);
+
+#endif // HMS_MQXXX_FREERTOS_SHIM_TASK_H
@@ -0,0 +1,18 @@
+#ifndef HMS_MQXXX_FREERTOS_SHIM_TIMERS_H
+#define HMS_MQXXX_FREERTOS_SHIM_TIMERS_H
+
+#include "FreeRTOS.h"
+
+typedef struct ShimTimer *TimerHandle_t;
+typedef void (*TimerCallbackFunction_t)(TimerHandle_t timer);
+typedef struct { void *reserved[4]; } StaticTimer_t;
+
+TimerHandle_t xTimerCreate(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                           TimerCallbackFunction_t callback);
+TimerHandle_t xTimerCreateStatic(const char *name, TickType_t period, UBaseType_t autoReload, void *id,
+                                 TimerCallbackFunction_t callback, StaticTimer_t *control);
+BaseType_t    xTimerChangePeriod(TimerHandle_t timer, TickType_t period, TickType_t timeout);   // One-shot, (re)starts it
+BaseType_t    xTimerDelete(TimerHandle_t timer, TickType_t timeout);
+void          *pvTimerGetTimerID(TimerHandle_t timer);
+
+#endif // HMS_MQXXX_FREERTOS_SHIM_TIMERS_H
@@ -0,0 +1,369 @@
+/*
+  Host batch re-processor for archived raw ADC data.
+
+  Every input file is a flat array of HMS_MQXXX_ArchiveRecord (12 bytes, little endian) from
+  one sensor node. Files are memory mapped, cut into fixed-size chunks and the chunks are
+  spread over a work-stealing thread pool. Each chunk is converted with the driver's own
+  codeToVoltage() / convertVoltage() / evaluateGases(), which are const and safe to share
+  between threads, and written straight into memory-mapped output columns:
+
+    <out>/<stem>.ratio.f32      Rs/R0 (R0/Rs for MQ-131) after correction
+    <out>/<stem>.ppm.f32        active curve (--a/--b, default curve of the type)
+    <out>/<stem>.flags.u8       HMS_MQXXX_ReadingFlags
+    <out>/<stem>.<gas>.f32      one column per gas of the sensor type
+
+  Results match readSensor() on the node bit for bit as long as the tool is built with the
+  same HMS_MQXXX_Config.h. Warm-up is replayed from the archived flag rather than re-tracked,
+  and compensated builds see baseline conditions (the archive holds no environment data).
+
+  usage: HMS_MQXXX_Batch [options] file[:r0] ...
+*/
+#include "HMS_MQXXX_DRIVER.h"
+
+#include <atomic>
+#include <deque>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include <errno.h>
+#include <fcntl.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+/*
+  One acquisition as logged by the node: the raw conversions getVoltage() averaged, kept as
+  an integer sum so the float average is rebuilt exactly.
+*/
+typedef struct {
+  uint32_t  timestamp;                                                      // mqMillis() at acquisition (ms)
+  uint32_t  codeSum;                                                        // Sum of the raw ADC codes
+  uint16_t  codeCount;                                                      // Number of conversions summed (retries)
+  uint8_t   flags;                                                          // HMS_MQXXX_ReadingFlags the node reported
+  uint8_t   reserved;
+} HMS_MQXXX_ArchiveRecord;
+
+static_assert(sizeof(HMS_MQXXX_ArchiveRecord) == 12, "Archive layout is fixed");
+
+#define BATCH_CHUNK_RECORDS     65536                                       // Records per work item
+
+class MappedFile {
+  public:
+    MappedFile()                                            {                             }
+    MappedFile(const MappedFile &) = delete;
+    MappedFile &operator=(const MappedFile &) = delete;
+    ~MappedFile() {
+      if(data != NULL && size > 0) munmap(data, size);
+      if(fd >= 0) close(fd);
+    }
+
+    bool openRead(const char *path) {
+      fd = open(path, O_RDONLY);
+      if(fd < 0) return false;
+      struct stat st;
+      if(fstat(fd, &st) != 0) return false;
+      size = (size_t)st.st_size;
+      if(size == 0) return true;
+      data = mmap(NULL, size, PROT_READ, MAP_PRIVATE, fd, 0);
+      if(data == MAP_FAILED) { data = NULL; return false; }
+      madvise(data, size, MADV_SEQUENTIAL);
+      return true;
+    }
+
+    bool create(const std::string &path, size_t bytes) {
+      fd = open(path.c_str(), O_RDWR | O_CREAT | O_TRUNC, 0644);
+      if(fd < 0) return false;
+      size = bytes;
+      if(size == 0) return true;
+      if(ftruncate(fd, (off_t)size) != 0) return false;
+      data = mmap(NULL, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+      if(data == MAP_FAILED) { data = NULL; return false; }
+      return true;
+    }
+
+    void *getData() const                                   { return data;                }
+    size_t getSize() const                                  { return size;                }
+
+  private:
+    int                         fd                  = -1;
+    void                        *data               = NULL;
+    size_t                      size                = 0;
+};
+
+typedef struct {
+  std::string                   path;
+  std::string                   stem;
+  float                         r0;
+  float                         correction;
+  MappedFile                    input;
+  MappedFile                    ratio;
+  MappedFile                    ppm;
+  MappedFile                    flags;
+  MappedFile                    gases[HMS_MQXXX_MAX_GASES];
+  uint8_t                       gasCount;
+  std::unique_ptr<HMS_MQXXX>    sensor;                                     // Shared read-only by the workers
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+    HMS_MQXXX_Profile           profile;                                    // Command line settings for the compact sensor
+  #endif
+} BatchFile;
+
+typedef struct {
+  BatchFile                     *file;
+  size_t                        begin;
+  size_t                        end;
+} BatchJob;
+
+/*
+  Each worker owns a deque, pops its own work from the back (last dealt, still cache warm)
+  and steals from the front of the others when it runs dry. All jobs exist before the
+  workers start, so an empty sweep over every deque means the batch is finished.
+*/
+class WorkStealingPool {
+  public:
+    explicit WorkStealingPool(unsigned workers) : queues(workers) {}
+
+    void deal(const BatchJob &job) {
+      queues[next].jobs.push_back(job);
+      next = (next + 1) % queues.size();
+    }
+
+    template<typename Fn>
+    void run(Fn fn) {
+      std::vector<std::thread> threads;
+      for(unsigned i = 0; i < queues.size(); i++) {
+        threads.emplace_back([this, i, &fn]() {
+          BatchJob job;
+          while(pop(i, &job) || steal(i, &job)) fn(job);
+        });
+      }
+      for(std::thread &thread : threads) thread.join();
+    }
+
+    uint64_t getStealCount() const                          { return steals.load();       }
+
+  private:
+    struct Queue {
+      std::mutex                lock;
+      std::deque<BatchJob>      jobs;
+    };
+
+    std::vector<Queue>          queues;
+    size_t                      next                = 0;
+    std::atomic<uint64_t>       steals{0};
+
+    bool pop(unsigned self, BatchJob *job) {
+      std::lock_guard<std::mutex> guard(queues[self].lock);
+      if(queues[self].jobs.empty()) return false;
+      *job = queues[self].jobs.back();
+      queues[self].jobs.pop_back();
+      return true;
+    }
+
+    bool steal(unsigned self, BatchJob *job) {
+      for(size_t k = 1; k < queues.size(); k++) {
+        Queue &victim = queues[(self + k) % queues.size()];
+        std::lock_guard<std::mutex> guard(victim.lock);
+        if(victim.jobs.empty()) continue;
+        *job = victim.jobs.front();
+        victim.jobs.pop_front();
+        steals++;
+        return true;
+      }
+      return false;
+    }
+};
+
+typedef struct {
+  HMS_MQXXX_Type                type                = HMS_MQXXX_DEFAULT_TYPE;
+  float                         r0                  = 10;
+  float                         rl                  = 10;
+  float                         vcc                 = 5;
+  float                         voltageResolution   = 3.3f;
+  uint8_t                       adcBits             = 12;
+  float                         adcOffset           = 0;
+  float                         adcGain             = 1;
+  float                         correction          = 0;
+  float                         a                   = NAN;                  // NAN = keep the type's default
+  float                         b                   = NAN;
+  unsigned                      threads             = 0;
+  std::string                   outDir              = ".";
+} BatchOptions;
+
+static void convertJob(const BatchJob &job) {
+  BatchFile &file = *job.file;
+  const HMS_MQXXX &sensor = *file.sensor;
+  const HMS_MQXXX_ArchiveRecord *records = (const HMS_MQXXX_ArchiveRecord *)file.input.getData();
+  float   *ratio = (float *)file.ratio.getData();
+  float   *ppm   = (float *)file.ppm.getData();
+  uint8_t *flags = (uint8_t *)file.flags.getData();
+  float   *gases[HMS_MQXXX_MAX_GASES];
+  for(uint8_t g = 0; g < file.gasCount; g++) gases[g] = (float *)file.gases[g].getData();
+
+  for(size_t i = job.begin; i < job.end; i++) {
+    const HMS_MQXXX_ArchiveRecord &record = records[i];
+    uint16_t count = (record.codeCount > 0) ? record.codeCount : 1;
+    float average  = (float)record.codeSum / (float)count;                 // Same float sum/divide as getVoltage()
+    HMS_MQXXX_Reading reading = sensor.convertVoltage(sensor.codeToVoltage(average), file.correction, record.timestamp);
+
+    float values[HMS_MQXXX_MAX_GASES];
+    sensor.evaluateGases(reading.ratio, values, file.gasCount);
+
+    ratio[i] = reading.ratio;
+    ppm[i]   = reading.ppm;
+    flags[i] = (uint8_t)((reading.flags & ~HMS_MQXXX_FLAG_WARMUP) | (record.flags & HMS_MQXXX_FLAG_WARMUP));
+    for(uint8_t g = 0; g < file.gasCount; g++) gases[g][i] = values[g];
+  }
+}
+
+static bool parseType(const char *name, HMS_MQXXX_Type *type) {
+  static const struct { const char *name; HMS_MQXXX_Type type; } types[] = {
+    { "mq2", HMS_MQXXX_MQ2 }, { "mq131", HMS_MQXXX_MQ131 }, { "mq135", HMS_MQXXX_MQ135 }, { "mq303a", HMS_MQXXX_MQ303A }
+  };
+  for(const auto &entry : types) {
+    if(strcasecmp(name, entry.name) == 0) { *type = entry.type; return true; }
+  }
+  return false;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: HMS_MQXXX_Batch [options] file[:r0] ...\n"
+    "  --type mq2|mq131|mq135|mq303a   sensor type (all files)\n"
+    "  --r0 kOhm       default R0 for files without :r0\n"
+    "  --rl kOhm       load resistance (10)\n"
+    "  --vcc V         sensor supply (5)\n"
+    "  --vref V        ADC full scale (3.3)\n"
+    "  --bits N        ADC resolution (12)\n"
+    "  --adc-offset V  ADC offset correction (0)\n"
+    "  --adc-gain G    ADC gain correction (1)\n"
+    "  --correction X  ratio correction factor passed to readSensor() (0)\n"
+    "  --a A --b B     active curve, default is the type's default curve\n"
+    "  --threads N     worker threads (hardware concurrency)\n"
+    "  --out DIR       output directory (.)\n");
+}
+
+static bool parseOptions(int argc, char **argv, BatchOptions *options, std::vector<std::string> *inputs) {
+  for(int i = 1; i < argc; i++) {
+    const char *arg = argv[i];
+    if(arg[0] != '-' || arg[1] != '-') {
+      inputs->push_back(arg);
+      continue;
+    }
+    if(i + 1 >= argc) return false;
+    const char *value = argv[++i];
+    if(strcmp(arg, "--type") == 0)            { if(!parseType(value, &options->type)) return false; }
+    else if(strcmp(arg, "--r0") == 0)         options->r0                = strtof(value, NULL);
+    else if(strcmp(arg, "--rl") == 0)         options->rl                = strtof(value, NULL);
+    else if(strcmp(arg, "--vcc") == 0)        options->vcc               = strtof(value, NULL);
+    else if(strcmp(arg, "--vref") == 0)       options->voltageResolution = strtof(value, NULL);
+    else if(strcmp(arg, "--bits") == 0)       options->adcBits           = (uint8_t)atoi(value);
+    else if(strcmp(arg, "--adc-offset") == 0) options->adcOffset         = strtof(value, NULL);
+    else if(strcmp(arg, "--adc-gain") == 0)   options->adcGain           = strtof(value, NULL);
+    else if(strcmp(arg, "--correction") == 0) options->correction        = strtof(value, NULL);
+    else if(strcmp(arg, "--a") == 0)          options->a                 = strtof(value, NULL);
+    else if(strcmp(arg, "--b") == 0)          options->b                 = strtof(value, NULL);
+    else if(strcmp(arg, "--threads") == 0)    options->threads           = (unsigned)atoi(value);
+    else if(strcmp(arg, "--out") == 0)        options->outDir            = value;
+    else return false;
+  }
+  return !inputs->empty();
+}
+
+static std::string fileStem(const std::string &path) {
+  size_t slash = path.find_last_of('/');
+  std::string name = (slash == std::string::npos) ? path : path.substr(slash + 1);
+  size_t dot = name.find_last_of('.');
+  return (dot == std::string::npos || dot == 0) ? name : name.substr(0, dot);
+}
+
+static bool prepareFile(BatchFile *file, const BatchOptions &options) {
+  if(!file->input.openRead(file->path.c_str())) {
+    fprintf(stderr, "%s: %s\n", file->path.c_str(), strerror(errno));
+    return false;
+  }
+  if(file->input.getSize() % sizeof(HMS_MQXXX_ArchiveRecord) != 0) {
+    fprintf(stderr, "%s: size is not a multiple of %u bytes\n", file->path.c_str(), (unsigned)sizeof(HMS_MQXXX_ArchiveRecord));
+    return false;
+  }
+
+  file->sensor.reset(new HMS_MQXXX(0, options.type));                     // No init(): nothing is sampled here
+  HMS_MQXXX &sensor = *file->sensor;
+  sensor.setR0(file->r0);
+  #if defined(HMS_MQXXX_COMPACT_ENABLED)
+  file->profile                   = *HMS_MQXXX_GetProfile(options.type);
+  file->profile.rl                = options.rl;
+  file->profile.vcc               = options.vcc;
+  file->profile.voltageResolution = options.voltageResolution;
+  file->profile.adcBitResolution  = (options.adcBits < 1) ? 1 : (options.adcBits > 16) ? 16 : options.adcBits;
+  if(!isnan(options.a)) file->profile.a = options.a;
+  if(!isnan(options.b)) file->profile.b = options.b;
+  sensor.setProfile(&file->profile);
+  #else
+  sensor.setRL(options.rl);
+  sensor.setVCC(options.vcc);
+  sensor.setVoltResolution(options.voltageResolution);
+  sensor.setADCBitResolution(options.adcBits);
+  if(!isnan(options.a)) sensor.setA(options.a);
+  if(!isnan(options.b)) sensor.setB(options.b);
+  #endif
+  sensor.setADCCorrection(options.adcOffset, options.adcGain);
+
+  size_t records = file->input.getSize() / sizeof(HMS_MQXXX_ArchiveRecord);
+  std::string base = options.outDir + "/" + file->stem;
+  bool ok = file->ratio.create(base + ".ratio.f32", records * sizeof(float))
+         && file->ppm.create(base + ".ppm.f32", records * sizeof(float))
+         && file->flags.create(base + ".flags.u8", records);
+
+  const HMS_MQXXX_GasCurve *curves = HMS_MQXXX_GetGasCurves(options.type, &file->gasCount);
+  for(uint8_t g = 0; ok && g < file->gasCount; g++) {
+    ok = file->gases[g].create(base + "." + HMS_MQXXX_GetGasName(curves[g].gas) + ".f32", records * sizeof(float));
+  }
+  if(!ok) fprintf(stderr, "%s: cannot create outputs in %s: %s\n", file->path.c_str(), options.outDir.c_str(), strerror(errno));
+  return ok;
+}
+
+int main(int argc, char **argv) {
+  BatchOptions options;
+  std::vector<std::string> inputs;
+  if(!parseOptions(argc, argv, &options, &inputs)) {
+    usage();
+    return 2;
+  }
+
+  std::vector<std::unique_ptr<BatchFile>> files;
+  for(const std::string &input : inputs) {
+    std::unique_ptr<BatchFile> file(new BatchFile());
+    size_t colon = input.find_last_of(':');
+    file->path       = (colon == std::string::npos) ? input : input.substr(0, colon);
+    file->r0         = (colon == std::string::npos) ? options.r0 : strtof(input.c_str() + colon + 1, NULL);
+    file->correction = options.correction;
+    file->stem       = fileStem(file->path);
+    if(!prepareFile(file.get(), options)) return 1;
+    files.push_back(std::move(file));
+  }
+
+  unsigned workers = (options.threads > 0) ? options.threads : std::thread::hardware_concurrency();
+  if(workers == 0) workers = 1;
+  WorkStealingPool pool(workers);
+
+  size_t total = 0;
+  for(auto &file : files) {
+    size_t records = file->input.getSize() / sizeof(HMS_MQXXX_ArchiveRecord);
+    for(size_t begin = 0; begin < records; begin += BATCH_CHUNK_RECORDS) {
+      size_t end = (records - begin > BATCH_CHUNK_RECORDS) ? begin + BATCH_CHUNK_RECORDS : records;
+      pool.deal(BatchJob{ file.get(), begin, end });
+    }
+    total += records;
+  }
+
+  pool.run(convertJob);
+
+  fprintf(stderr, "%zu records from %zu files on %u threads (%llu chunks stolen)\n",
+          total, files.size(), workers, (unsigned long long)pool.getStealCount());
+  return 0;
+}
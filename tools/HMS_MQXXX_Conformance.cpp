@@ -0,0 +1,226 @@
+/*
+  Accuracy-versus-speed conformance of the curve math modes (HMS_MQXXX_MathMode).
+
+  Every mode is run side by side against HMS_MQXXX_MATH_DOUBLE, the reference readSensor() and
+  setRatioAndGetPPM() use by default, on:
+    sweep   every ADC code through the driver's own conversion (codeToVoltage, Rs, ratio with
+            its ratio <= 0 clamp) for each type, over an R0 x RL x VCC grid, evaluated with
+            each gas curve of the type and its default curve from HMS_MQXXX_Config.h
+    edges   ratio <= 0, NaN, infinities, subnormals, a == 0, negative a and coefficients
+            that drive willOverflow() to either side
+  Edges must agree exactly: same value and same SATURATED flag. The only tolerated
+  difference is a saturation decision within the mode's budget of the FLT_MAX / FLT_MIN
+  boundary. A mode fails when its largest relative error exceeds its declared budget
+  (HMS_MQXXX_MATH_<MODE>_BUDGET) or any edge disagrees; the exit status is then 1.
+
+  usage: HMS_MQXXX_Conformance [--bits N] [--vref V]
+*/
+#include "HMS_MQXXX_DRIVER.h"
+
+#include <chrono>
+#include <vector>
+
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const modeNames[HMS_MQXXX_MATH_COUNT] = { "double", "float", "fast" };
+static const float       modeBudgets[HMS_MQXXX_MATH_COUNT] = { 0.0f, HMS_MQXXX_MATH_FLOAT_BUDGET, HMS_MQXXX_MATH_FAST_BUDGET };
+static const char *const typeNames[] = { "MQ-2", "MQ-131", "MQ-135", "MQ-303A" };
+
+static const float gridR0[]  = { 0.5f, 2.0f, 10.0f, 50.0f, 200.0f };        // kOhm
+static const float gridRL[]  = { 1.0f, 4.7f, 10.0f, 22.0f, 47.0f };         // kOhm
+static const float gridVCC[] = { 3.3f, 5.0f };                              // V
+
+typedef struct {
+  const char            *label;
+  HMS_MQXXX_Regression  regression;
+  float                 a;
+  float                 b;
+} CurveCase;
+
+typedef struct {
+  double                maxError            = 0;
+  double                errorSum            = 0;
+  uint64_t              compared            = 0;
+  uint64_t              boundary            = 0;                            // Tolerated saturation disagreements
+  uint64_t              failures            = 0;
+  double                seconds             = 0;
+  uint64_t              evaluations         = 0;
+  char                  worst[160]          = "";
+} ModeResult;
+
+/*
+  Folds one evaluation into the result. Returns false on a hard disagreement: a clamped or
+  saturated reference that the mode does not reproduce.
+*/
+static bool compare(float reference, uint8_t referenceFlags, float value, uint8_t valueFlags, float budget, ModeResult *result, double *error) {
+  *error = 0;
+  bool referenceSaturated = (referenceFlags & HMS_MQXXX_FLAG_SATURATED) != 0;
+  bool valueSaturated     = (valueFlags & HMS_MQXXX_FLAG_SATURATED) != 0;
+  if(referenceSaturated != valueSaturated) {
+    float unsaturated = referenceSaturated ? value : reference;
+    float saturated   = referenceSaturated ? reference : value;
+    bool  nearLimit   = (saturated == FLT_MAX) ? unsaturated >= FLT_MAX * (1.0f - budget) : unsaturated <= FLT_MIN * (1.0f + budget);
+    if(!nearLimit) return false;
+    result->boundary++;
+    return true;
+  }
+  if(reference == 0 || reference == FLT_MAX || referenceSaturated) return value == reference;
+  if(isnan(value) || isinf(value)) return false;
+
+  *error = fabs((double)value - (double)reference) / (double)reference;
+  result->compared++;
+  result->errorSum += *error;
+  return true;
+}
+
+static void evaluate(const CurveCase &curve, const char *context, const std::vector<float> &ratios, ModeResult *results, bool edges) {
+  std::vector<float>   reference(ratios.size());
+  std::vector<uint8_t> referenceFlags(ratios.size());
+  std::vector<float>   values(ratios.size());
+  std::vector<uint8_t> valueFlags(ratios.size());
+
+  for(uint8_t mode = 0; mode < HMS_MQXXX_MATH_COUNT; mode++) {
+    float   *out   = (mode == HMS_MQXXX_MATH_DOUBLE) ? reference.data() : values.data();
+    uint8_t *flags = (mode == HMS_MQXXX_MATH_DOUBLE) ? referenceFlags.data() : valueFlags.data();
+    memset(flags, 0, ratios.size());
+
+    auto begin = std::chrono::steady_clock::now();
+    for(size_t i = 0; i < ratios.size(); i++) {
+      out[i] = HMS_MQXXX_CurveToPPM((HMS_MQXXX_MathMode)mode, curve.regression, curve.a, curve.b, ratios[i], &flags[i]);
+    }
+    auto end = std::chrono::steady_clock::now();
+    if(!edges) {
+      results[mode].seconds     += std::chrono::duration<double>(end - begin).count();
+      results[mode].evaluations += ratios.size();
+    }
+    if(mode == HMS_MQXXX_MATH_DOUBLE) continue;
+
+    ModeResult &result = results[mode];
+    for(size_t i = 0; i < ratios.size(); i++) {
+      double error;
+      bool   agreed = compare(reference[i], referenceFlags[i], values[i], valueFlags[i], modeBudgets[mode], &result, &error);
+      if(agreed && error <= result.maxError) continue;
+      if(agreed) result.maxError = error;
+      else       result.failures++;
+      if(agreed ? result.failures == 0 : result.failures == 1) {             // A mismatch outranks any error
+        snprintf(result.worst, sizeof(result.worst), "%s %s%s ratio=%.9g ref=%.9g got=%.9g%s", context, curve.label,
+                 edges ? " (edge)" : "", (double)ratios[i], (double)reference[i], (double)values[i], agreed ? "" : " MISMATCH");
+      }
+    }
+  }
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: HMS_MQXXX_Conformance [options]\n"
+    "  --bits N        ADC resolution swept code by code (12)\n"
+    "  --vref V        ADC full scale (3.3)\n");
+}
+
+int main(int argc, char **argv) {
+  uint8_t bits = 12;
+  float   vref = 3.3f;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--bits") == 0 && i + 1 < argc)       bits = (uint8_t)atoi(argv[++i]);
+    else if(strcmp(argv[i], "--vref") == 0 && i + 1 < argc)  vref = strtof(argv[++i], NULL);
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if(bits < 8 || bits > 16 || !(vref > 0)) {
+    usage();
+    return 2;
+  }
+
+  ModeResult results[HMS_MQXXX_MATH_COUNT];
+  char       context[64];
+
+  for(int type = HMS_MQXXX_MQ2; type <= HMS_MQXXX_MQ303A; type++) {
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+    HMS_MQXXX_Profile profile = *HMS_MQXXX_GetProfile((HMS_MQXXX_Type)type);  // Grid settings for the compact sensor
+    profile.adcBitResolution  = bits;
+    profile.voltageResolution = vref;
+    #endif
+    HMS_MQXXX sensor(0, (HMS_MQXXX_Type)type);
+    #if defined(HMS_MQXXX_COMPACT_ENABLED)
+    sensor.setProfile(&profile);
+    #else
+    sensor.setADCBitResolution(bits);
+    sensor.setVoltResolution(vref);
+    #endif
+
+    std::vector<CurveCase> curves;
+    curves.push_back(CurveCase{ "default", sensor.getRegressionMethod(), sensor.getA(), sensor.getB() });
+    uint8_t count;
+    const HMS_MQXXX_GasCurve *table = HMS_MQXXX_GetGasCurves((HMS_MQXXX_Type)type, &count);
+    for(uint8_t g = 0; g < count; g++) {
+      curves.push_back(CurveCase{ HMS_MQXXX_GetGasName(table[g].gas), table[g].regression, table[g].a, table[g].b });
+    }
+
+    // Ratios exactly as convertVoltage() produces them, every code of every grid point
+    std::vector<float> ratios;
+    ratios.reserve(sizeof(gridR0) / sizeof(gridR0[0]) * sizeof(gridRL) / sizeof(gridRL[0]) *
+                   sizeof(gridVCC) / sizeof(gridVCC[0]) << bits);
+    for(float vcc : gridVCC) {
+      for(float rl : gridRL) {
+        for(float r0 : gridR0) {
+          #if defined(HMS_MQXXX_COMPACT_ENABLED)
+          profile.vcc = vcc;
+          profile.rl  = rl;
+          sensor.setProfile(&profile);
+          #else
+          sensor.setVCC(vcc);
+          sensor.setRL(rl);
+          #endif
+          sensor.setR0(r0);
+          for(uint32_t code = 0; code < (1UL << bits); code++) {
+            ratios.push_back(sensor.convertVoltage(sensor.codeToVoltage((float)code)).ratio);
+          }
+        }
+      }
+    }
+
+    snprintf(context, sizeof(context), "%s", typeNames[type]);
+    for(const CurveCase &curve : curves) evaluate(curve, context, ratios, results, false);
+  }
+
+  // Inputs the sweep cannot reach but the public entry points accept
+  const float edgeRatios[] = { 0.0f, -0.0f, -1.0f, NAN, INFINITY, -INFINITY, FLT_MIN, FLT_MIN / 4, FLT_MAX,
+                               1e-30f, 1e-3f, 1.0f, 1e30f };
+  const CurveCase edgeCurves[] = {
+    { "a=0",                 HMS_MQXXX_EXPONENTIAL,  0.0f,    -2.0f  },
+    { "a<0",                 HMS_MQXXX_EXPONENTIAL,  -5.0f,   -2.0f  },
+    { "exp overflow",        HMS_MQXXX_EXPONENTIAL,  1e30f,   -3.0f  },
+    { "exp underflow",       HMS_MQXXX_EXPONENTIAL,  1e-30f,  3.0f   },
+    { "exp b=0",             HMS_MQXXX_EXPONENTIAL,  574.25f, 0.0f   },
+    { "linear tiny a",       HMS_MQXXX_LINEAR,       1e-4f,   0.5f   },
+    { "linear negative a",   HMS_MQXXX_LINEAR,       -0.45f,  1.2f   },
+    { "linear b=NaN",        HMS_MQXXX_LINEAR,       -0.45f,  NAN    }
+  };
+  std::vector<float> edges(edgeRatios, edgeRatios + sizeof(edgeRatios) / sizeof(edgeRatios[0]));
+  for(const CurveCase &curve : edgeCurves) evaluate(curve, "edge", edges, results, true);
+
+  // Ratio sweep across each saturation boundary of a known curve
+  std::vector<float> boundary;
+  for(int i = -2000; i <= 2000; i++) boundary.push_back(powf(10.0f, -12.0f + (float)i * 1e-5f));
+  evaluate(CurveCase{ "boundary", HMS_MQXXX_EXPONENTIAL, 1.0f, -3.2f }, "edge", boundary, results, true);
+
+  printf("%-8s %10s %14s %14s %10s %8s %10s  %s\n", "mode", "budget", "max rel err", "mean rel err", "boundary", "edges", "Meval/s", "result");
+  bool passed = true;
+  for(uint8_t mode = 0; mode < HMS_MQXXX_MATH_COUNT; mode++) {
+    const ModeResult &result = results[mode];
+    double rate = (result.seconds > 0) ? result.evaluations / result.seconds / 1e6 : 0;
+    bool   ok   = (mode == HMS_MQXXX_MATH_DOUBLE) || (result.failures == 0 && result.maxError <= modeBudgets[mode]);
+    printf("%-8s %10.1e %14.3e %14.3e %10llu %8llu %10.1f  %s%s\n", modeNames[mode], (double)modeBudgets[mode], result.maxError,
+           (result.compared > 0) ? result.errorSum / result.compared : 0.0, (unsigned long long)result.boundary,
+           (unsigned long long)result.failures, rate,
+           (mode == HMS_MQXXX_MATH_DOUBLE) ? "reference" : (ok ? "PASS" : "FAIL"), (mode == HMS_MQXXX_MATH_MODE) ? "  (driver)" : "");
+    passed = passed && ok;
+  }
+  for(uint8_t mode = 1; mode < HMS_MQXXX_MATH_COUNT; mode++) {
+    if(results[mode].worst[0] != '\0') printf("worst %-6s %s\n", modeNames[mode], results[mode].worst);
+  }
+  return passed ? 0 : 1;
+}
@@ -0,0 +1,241 @@
+/*
+  Virtual-time simulation of many sensors sampling side by side, written as a Chrome
+  trace-event / Perfetto timeline (HMS_MQXXX_ChromeTrace).
+
+  Every sensor gets its own virtual clock. mqDelay() advances that clock instead of sleeping;
+  driver code between delays runs at host speed and its real duration, less the time the
+  trace spends recording, is added to the clock, so conversion stages keep their true
+  relative cost next to the simulated delays. A
+  scheduler always resumes the sensor whose next readSensor() is due first, which keeps the
+  single-threaded run deterministic apart from those measured compute times.
+
+  Each sensor sees clean air until --step, then a gas step that drives its active curve past
+  its alarm threshold (the geometric mean of the clean and gas ppm unless --alarm is given).
+  The trace shows, per sensor track: readSensor with its acquire / mqDelay / average / rs /
+  ratio / curve spans, a ppm counter, the gas step mark and a sample-to-alarm span from the
+  first conversion of the alarming sample to its reading. Open it in ui.perfetto.dev or
+  chrome://tracing.
+
+  usage: HMS_MQXXX_Simulate [options]
+*/
+#include "HMS_MQXXX_ChromeTrace.h"
+
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+static const char *const typeNames[] = { "MQ-2", "MQ-131", "MQ-135", "MQ-303A" };
+
+typedef struct {
+  const char            *out                = "HMS_MQXXX_Simulation.json";
+  uint32_t              sensors             = 8;
+  double                seconds             = 30;                           // Virtual run length
+  uint32_t              interval            = 1000;                         // ms between readSensor() calls of a sensor
+  double                step                = 10;                           // s, start of the gas step
+  float                 alarm               = NAN;                          // ppm, NAN = per sensor default
+  float                 gasFactor           = 8;                            // Rs change of the gas step
+} Options;
+
+typedef struct {
+  std::unique_ptr<HMS_MQXXX> sensor;
+  uint64_t              clock;                                              // Virtual ns
+  uint64_t              next;                                               // Virtual ns of the next readSensor()
+  float                 cleanRs;                                            // kOhm
+  float                 gasRs;
+  float                 threshold;
+  uint32_t              noise;                                              // LCG state
+  bool                  stepped;
+  double                latency;                                            // First sample-to-alarm (ms), < 0 = none
+} SimSensor;
+
+static std::vector<SimSensor> simulated;
+static SimSensor              *current  = NULL;
+static uint64_t               resumed   = 0;                                // Steady ns when current last resumed
+static uint64_t               excluded  = 0;                                // Trace overhead already left out
+static HMS_MQXXX_ChromeTrace  trace;
+static uint64_t               stepAt    = 0;
+
+static uint64_t steadyNanoseconds() {
+  return (uint64_t)std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+static void resume(SimSensor *sim) {
+  current  = sim;
+  resumed  = steadyNanoseconds();
+  excluded = trace.getOverhead();
+}
+
+// Virtual time of the running sensor: its clock plus the host time spent since it resumed, less the trace's own
+static uint64_t virtualNow(void *context) {
+  (void)context;
+  if(current == NULL) return 0;
+  uint64_t steady   = steadyNanoseconds();
+  uint64_t overhead = trace.getOverhead();
+  uint64_t elapsed  = steady - resumed;
+  elapsed           = (elapsed > overhead - excluded) ? elapsed - (overhead - excluded) : 0;
+  current->clock   += elapsed;
+  resumed           = steady;
+  excluded          = overhead;
+  return current->clock;
+}
+
+static void virtualDelay(uint32_t ms, void *context) {
+  virtualNow(context);
+  if(current != NULL) current->clock += (uint64_t)ms * 1000000ULL;
+}
+
+static uint32_t virtualMillis(void *context) {
+  return (uint32_t)(virtualNow(context) / 1000000ULL);
+}
+
+// Voltage divider of the load resistor run backwards, with +-0.5 % of noise on Rs
+static uint16_t simulatedADC(uint8_t pin, void *context) {
+  if(pin >= simulated.size()) return 0;
+  SimSensor &sim = simulated[pin];
+  uint64_t   now = virtualNow(context);
+  sim.noise      = sim.noise * 1664525UL + 1013904223UL;
+  float rs       = ((now >= stepAt) ? sim.gasRs : sim.cleanRs) * (1.0f + ((float)(sim.noise >> 8) / 16777216.0f - 0.5f) * 0.01f);
+
+  HMS_MQXXX &sensor = *sim.sensor;
+  float supply  = sensor.getVCC() - ((sensor.getType() == HMS_MQXXX_MQ303A) ? 0.45f : 0.0f);    // As sensorSupply()
+  float voltage = supply * sensor.getRL() / (rs + sensor.getRL());
+  float code    = voltage / sensor.getVoltResolution() * (float)((1UL << sensor.getADCBitResolution()) - 1);
+  if(code < 0) code = 0;
+  if(code > (float)((1UL << sensor.getADCBitResolution()) - 1)) code = (float)((1UL << sensor.getADCBitResolution()) - 1);
+  return (uint16_t)lroundf(code);
+}
+
+static float cleanAirRatio(HMS_MQXXX_Type type) {
+  switch(type) {
+    case HMS_MQXXX_MQ2:     return HMS_MQXXX_MQ2_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ131:   return HMS_MQXXX_MQ131_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ135:   return HMS_MQXXX_MQ135_CLEAN_AIR_RATIO;
+    case HMS_MQXXX_MQ303A:  return HMS_MQXXX_MQ303A_CLEAN_AIR_RATIO;
+    default:                return HMS_MQXXX_GENERIC_CLEAN_AIR_RATIO;
+  }
+}
+
+// First alarm of each sensor, for the summary
+static void onAlarmReading(const HMS_MQXXX_Reading *reading, void *context) {
+  SimSensor *sim = static_cast<SimSensor *>(context);
+  if(sim->latency >= 0 || reading->status != HMS_MQXXX_OK || reading->ppm < sim->threshold) return;
+  uint64_t now = virtualNow(NULL);
+  if(now >= stepAt) sim->latency = (double)(now - stepAt) / 1e6;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: HMS_MQXXX_Simulate [options]\n"
+    "  --out FILE      trace output (HMS_MQXXX_Simulation.json)\n"
+    "  --sensors N     simulated sensors, types in turn (8)\n"
+    "  --seconds S     virtual run length (30)\n"
+    "  --interval MS   readSensor() period of each sensor (1000)\n"
+    "  --step S        virtual time of the gas step (10)\n"
+    "  --factor F      Rs change of the gas step (8)\n"
+    "  --alarm PPM     alarm threshold of every sensor (per sensor default)\n");
+}
+
+int main(int argc, char **argv) {
+  Options options;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--out") == 0 && i + 1 < argc)             options.out       = argv[++i];
+    else if(strcmp(argv[i], "--sensors") == 0 && i + 1 < argc)    options.sensors   = (uint32_t)atoi(argv[++i]);
+    else if(strcmp(argv[i], "--seconds") == 0 && i + 1 < argc)    options.seconds   = atof(argv[++i]);
+    else if(strcmp(argv[i], "--interval") == 0 && i + 1 < argc)   options.interval  = (uint32_t)atoi(argv[++i]);
+    else if(strcmp(argv[i], "--step") == 0 && i + 1 < argc)       options.step      = atof(argv[++i]);
+    else if(strcmp(argv[i], "--factor") == 0 && i + 1 < argc)     options.gasFactor = strtof(argv[++i], NULL);
+    else if(strcmp(argv[i], "--alarm") == 0 && i + 1 < argc)      options.alarm     = strtof(argv[++i], NULL);
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if(options.sensors == 0 || options.sensors > 256 || options.interval == 0 || !(options.seconds > 0) || !(options.gasFactor > 1)) {
+    usage();
+    return 2;
+  }
+
+  HMS_MQXXX_HostHooks hooks = { simulatedADC, virtualDelay, virtualMillis, NULL };
+  HMS_MQXXX_SetHostHooks(&hooks);
+
+  if(trace.open(options.out, virtualNow) != HMS_MQXXX_OK) {
+    fprintf(stderr, "%s: cannot create\n", options.out);
+    return 1;
+  }
+  stepAt = (uint64_t)(options.step * 1e9);
+
+  simulated.resize(options.sensors);
+  std::vector<HMS_MQXXX_Listener> listeners(options.sensors);
+  for(uint32_t i = 0; i < options.sensors; i++) {
+    SimSensor      &sim  = simulated[i];
+    HMS_MQXXX_Type type  = (HMS_MQXXX_Type)(i % 4);
+    sim.sensor.reset(new HMS_MQXXX((uint8_t)i, type));
+    sim.sensor->init();
+
+    // Clean air at a quarter of the ADC range; gas moves Rs whichever way raises the active curve's ppm
+    HMS_MQXXX &sensor = *sim.sensor;
+    float supply = sensor.getVCC() - ((type == HMS_MQXXX_MQ303A) ? 0.45f : 0.0f);
+    float clean  = cleanAirRatio(type);
+    bool  r0Rs   = (type == HMS_MQXXX_MQ131);                               // Ratio is R0/Rs
+    sim.cleanRs  = sensor.getRL() * (supply / (0.25f * sensor.getVoltResolution()) - 1);
+    sensor.setR0(r0Rs ? sim.cleanRs * clean : sim.cleanRs / clean);
+    float gas    = (sensor.ratioToPPM(clean * options.gasFactor) > sensor.ratioToPPM(clean / options.gasFactor)) ?
+                   clean * options.gasFactor : clean / options.gasFactor;
+    sim.gasRs    = r0Rs ? sim.cleanRs * clean / gas : sim.cleanRs * gas / clean;
+    sim.threshold = isnan(options.alarm) ? sqrtf(sensor.ratioToPPM(clean) * sensor.ratioToPPM(gas)) : options.alarm;
+    sim.noise     = 0x9E3779B9UL * (i + 1);
+    sim.clock     = 0;
+    sim.next      = (uint64_t)options.interval * 1000000ULL * i / options.sensors;    // Staggered starts
+    sim.stepped   = false;
+    sim.latency   = -1;
+
+    char name[32];
+    snprintf(name, sizeof(name), "%s #%lu", typeNames[type], (unsigned long)i);
+    trace.attach(sim.sensor.get(), name);
+    trace.setAlarmThreshold(sim.sensor.get(), sim.threshold);
+    listeners[i] = HMS_MQXXX_Listener{ onAlarmReading, NULL, &sim, NULL };
+    sim.sensor->addListener(&listeners[i]);
+  }
+
+  uint64_t end   = (uint64_t)(options.seconds * 1e9);
+  uint64_t reads = 0;
+  auto     begin = std::chrono::steady_clock::now();
+  for(;;) {
+    SimSensor *due = NULL;
+    for(SimSensor &sim : simulated) {
+      if(due == NULL || sim.next < due->next) due = &sim;
+    }
+    if(due->next >= end) break;
+
+    resume(due);
+    if(due->clock < due->next) due->clock = due->next;                      // Idle until the sensor is due
+    if(!due->stepped && due->clock >= stepAt) {
+      due->stepped = true;
+      trace.mark(due->sensor.get(), "gas step");
+    }
+    due->sensor->readSensor();
+    virtualNow(NULL);
+    due->next += (uint64_t)options.interval * 1000000ULL;
+    current    = NULL;
+    reads++;
+  }
+  double host = std::chrono::duration<double>(std::chrono::steady_clock::now() - begin).count();
+  for(uint32_t i = 0; i < options.sensors; i++) simulated[i].sensor->removeListener(&listeners[i]);
+  trace.close();
+
+  printf("%llu reads of %lu sensors over %.1f s virtual in %.3f s host, %llu trace events -> %s\n", (unsigned long long)reads,
+         (unsigned long)options.sensors, options.seconds, host, (unsigned long long)trace.getEventCount(), options.out);
+  printf("%-12s %12s %16s\n", "sensor", "alarm ppm", "step-to-alarm ms");
+  for(uint32_t i = 0; i < options.sensors; i++) {
+    char name[32];
+    snprintf(name, sizeof(name), "%s #%lu", typeNames[i % 4], (unsigned long)i);
+    if(simulated[i].latency >= 0) printf("%-12s %12.4g %16.1f\n", name, (double)simulated[i].threshold, simulated[i].latency);
+    else                          printf("%-12s %12.4g %16s\n", name, (double)simulated[i].threshold, "none");
+  }
+  HMS_MQXXX_SetHostHooks(NULL);
+  return 0;
+}
@@ -0,0 +1,172 @@
+/*
+  Decoder for HMS_MQXXX_TraceDump() images.
+
+  A dump is an HMS_MQXXX_TraceDumpHeader followed by the raw trace ring. The decoder keeps
+  the records whose lap byte matches their claim number (slots still being written when the
+  dump was taken, and slots overwritten during the copy, are dropped), puts them back in
+  claim order and prints one line per record:
+
+    claim   time (us since the first record)   delta (us)   source   event   arg0   arg1
+
+  Ticks are 32-bit and wrap, within seconds on a fast cycle counter. Each step between two
+  records takes the number of wraps that brings the tick delta closest to the delta of their
+  millisecond stamps, so idle gaps of up to 2^31 ms keep the timeline right as long as the
+  tick rate is known (--rate when the dump's is wrong).
+
+  Arguments of the driver events are printed as floats or integers (see HMS_MQXXX_TraceEvent);
+  application events (>= HMS_MQXXX_TRACE_USER) as hex words.
+
+  usage: HMS_MQXXX_TraceDecode [--csv] [--rate HZ] dump ...
+*/
+#include "HMS_MQXXX_Trace.h"
+
+#include <vector>
+
+#include <math.h>
+#include <stdlib.h>
+#include <string.h>
+
+typedef struct {
+  uint32_t                claim;
+  HMS_MQXXX_TraceRecord   record;
+} Entry;
+
+typedef struct {
+  bool                    csv                 = false;
+  uint32_t                rate                = 0;                          // Overrides the dump's tick rate when set
+} Options;
+
+static void formatArg(uint16_t event, uint8_t arg, uint32_t value, char *out, size_t size) {
+  if(HMS_MQXXX_TraceArgIsFloat(event, arg)) {
+    float f;
+    memcpy(&f, &value, sizeof(f));
+    snprintf(out, size, "%.6g", (double)f);
+  } else if(event >= HMS_MQXXX_TRACE_USER) {
+    snprintf(out, size, "0x%08lx", (unsigned long)value);
+  } else {
+    snprintf(out, size, "%lu", (unsigned long)value);
+  }
+}
+
+// Ticks from one record to the next: the short signed delta plus whole wraps of the counter
+static int64_t tickDelta(const HMS_MQXXX_TraceRecord &from, const HMS_MQXXX_TraceRecord &to, uint32_t rate) {
+  int64_t ticks    = (int32_t)(to.ticks - from.ticks);
+  double  expected = (double)(int32_t)(to.millis - from.millis) * rate / 1000.0;
+  double  wraps    = round((expected - (double)ticks) / 4294967296.0);
+  return ticks + (int64_t)wraps * 4294967296LL;
+}
+
+static bool readDump(const char *path, HMS_MQXXX_TraceDumpHeader *header, std::vector<HMS_MQXXX_TraceRecord> *ring) {
+  FILE *file = fopen(path, "rb");
+  if(file == NULL) {
+    fprintf(stderr, "%s: cannot open\n", path);
+    return false;
+  }
+  bool ok = fread(header, sizeof(*header), 1, file) == 1;
+  if(!ok || header->magic != HMS_MQXXX_TRACE_MAGIC) {
+    fprintf(stderr, "%s: not a trace dump\n", path);
+    fclose(file);
+    return false;
+  }
+  if(header->version != HMS_MQXXX_TRACE_VERSION || header->recordSize != sizeof(HMS_MQXXX_TraceRecord) ||
+     header->capacity == 0 || (header->capacity & (header->capacity - 1)) != 0) {
+    fprintf(stderr, "%s: unsupported dump (version %u, record %u bytes, capacity %lu)\n", path, header->version,
+            header->recordSize, (unsigned long)header->capacity);
+    fclose(file);
+    return false;
+  }
+  ring->resize(header->capacity);
+  ok = fread(ring->data(), sizeof(HMS_MQXXX_TraceRecord), header->capacity, file) == header->capacity;
+  fclose(file);
+  if(!ok) fprintf(stderr, "%s: truncated\n", path);
+  return ok;
+}
+
+static bool decode(const char *path, const Options &options) {
+  HMS_MQXXX_TraceDumpHeader          header;
+  std::vector<HMS_MQXXX_TraceRecord> ring;
+  if(!readDump(path, &header, &ring)) return false;
+
+  uint8_t shift = 0;
+  while((1UL << shift) < header.capacity) shift++;
+
+  // Claim numbers still in the ring, minus those a concurrent writer may have reused
+  // (distances, so the 32-bit claim counter may wrap)
+  uint32_t count = (header.head < header.capacity) ? header.head : header.capacity;
+  uint32_t first = header.head - count;
+  if((int32_t)(header.stable - first) > 0) {
+    first = ((int32_t)(header.head - header.stable) > 0) ? header.stable : header.head;  // Else the whole ring was rewritten
+  }
+
+  std::vector<Entry> entries;
+  uint32_t           skipped = 0;
+  for(uint32_t claim = first; claim != header.head; claim++) {
+    const HMS_MQXXX_TraceRecord &record = ring[claim & (header.capacity - 1)];
+    if(record.lap != (uint8_t)(claim >> shift)) {
+      skipped++;
+      continue;
+    }
+    entries.push_back(Entry{ claim, record });
+  }
+
+  uint32_t rate = (options.rate != 0) ? options.rate : header.tickRate;
+  if(rate == 0) rate = 1000000;
+  if(options.csv) {
+    printf("claim,time_us,delta_us,source,event,name,arg0,arg1\n");
+  } else {
+    printf("# %s: %lu records (%lu skipped), head %lu, %lu ticks/s\n", path, (unsigned long)entries.size(),
+           (unsigned long)skipped, (unsigned long)header.head, (unsigned long)rate);
+    printf("%10s %14s %12s %6s  %-14s %14s %14s\n", "claim", "time us", "delta us", "source", "event", "arg0", "arg1");
+  }
+
+  int64_t  elapsed  = 0;                                                    // Unwrapped ticks since the first record
+  int64_t  previous = 0;
+  char     arg0[24], arg1[24];
+  for(size_t i = 0; i < entries.size(); i++) {
+    const HMS_MQXXX_TraceRecord &record = entries[i].record;
+    if(i > 0) elapsed += tickDelta(entries[i - 1].record, record, rate);
+    double time  = (double)elapsed * 1e6 / rate;
+    double delta = (double)(elapsed - previous) * 1e6 / rate;
+    previous     = elapsed;
+
+    formatArg(record.event, 0, record.arg0, arg0, sizeof(arg0));
+    formatArg(record.event, 1, record.arg1, arg1, sizeof(arg1));
+    if(options.csv) {
+      printf("%lu,%.3f,%.3f,%u,%u,%s,%s,%s\n", (unsigned long)entries[i].claim, time, delta, record.source, record.event,
+             HMS_MQXXX_TraceEventName(record.event), arg0, arg1);
+    } else {
+      printf("%10lu %14.3f %12.3f %6u  %-14s %14s %14s\n", (unsigned long)entries[i].claim, time, delta, record.source,
+             HMS_MQXXX_TraceEventName(record.event), arg0, arg1);
+    }
+  }
+  return true;
+}
+
+static void usage() {
+  fprintf(stderr,
+    "usage: HMS_MQXXX_TraceDecode [options] dump ...\n"
+    "  --csv           comma-separated output\n"
+    "  --rate HZ       tick rate when the dump's is wrong or missing\n");
+}
+
+int main(int argc, char **argv) {
+  Options                    options;
+  std::vector<const char *>  files;
+  for(int i = 1; i < argc; i++) {
+    if(strcmp(argv[i], "--csv") == 0)                             options.csv  = true;
+    else if(strcmp(argv[i], "--rate") == 0 && i + 1 < argc)       options.rate = (uint32_t)strtoul(argv[++i], NULL, 10);
+    else if(argv[i][0] != '-')                                    files.push_back(argv[i]);
+    else {
+      usage();
+      return 2;
+    }
+  }
+  if(files.empty()) {
+    usage();
+    return 2;
+  }
+
+  bool ok = true;
+  for(const char *file : files) ok = decode(file, options) && ok;
+  return ok ? 0 : 1;
+}